@@ -1078,6 +1078,16 @@ int opt_max_alloc(void *optctx, const char *opt, const char *arg)
     return 0;
 }
 
+int opt_hugepage_threshold(void *optctx, const char *opt, const char *arg)
+{
+    int64_t min_size = parse_number_or_die(opt, arg, OPT_INT64, 0,
+                                           FFMIN(INT64_MAX, SIZE_MAX));
+
+    if (av_hugepage_threshold(min_size) < 0)
+        av_log(NULL, AV_LOG_WARNING, "Huge pages are not supported on this platform.\n");
+    return 0;
+}
+
 int opt_timelimit(void *optctx, const char *opt, const char *arg)
 {
 #if HAVE_SETRLIMIT
@@ -4012,6 +4012,9 @@ static void free_input_thread(int i)
     if (!f || !f->in_thread_queue)
         return;
     av_thread_message_queue_set_err_send(f->in_thread_queue, AVERROR_EOF);
+    while (f->thread_pkts_pos < f->nb_thread_pkts)
+        av_packet_free(&f->thread_pkts[f->thread_pkts_pos++]);
+    f->thread_pkts_pos = f->nb_thread_pkts = 0;
     while (av_thread_message_queue_recv(f->in_thread_queue, &pkt, 0) >= 0)
         av_packet_free(&pkt);
 
@@ -4069,9 +4072,20 @@ static int init_input_threads(void)
 
 static int get_input_packet_mt(InputFile *f, AVPacket **pkt)
 {
-    return av_thread_message_queue_recv(f->in_thread_queue, pkt,
-                                        f->non_blocking ?
-                                        AV_THREAD_MESSAGE_NONBLOCK : 0);
+    /* take all the queued packets at once, to lock the queue less often
+     * when the packet rate is high */
+    if (f->thread_pkts_pos == f->nb_thread_pkts) {
+        int ret = av_thread_message_queue_recv_multi(f->in_thread_queue, f->thread_pkts,
+                                                     FF_ARRAY_ELEMS(f->thread_pkts),
+                                                     f->non_blocking ?
+                                                     AV_THREAD_MESSAGE_NONBLOCK : 0);
+        if (ret < 0)
+            return ret;
+        f->thread_pkts_pos = 0;
+        f->nb_thread_pkts  = ret;
+    }
+    *pkt = f->thread_pkts[f->thread_pkts_pos++];
+    return 0;
 }
 #endif
 
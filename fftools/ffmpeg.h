@@ -426,6 +426,9 @@ typedef struct InputFile {
     int non_blocking;           /* reading packets from the thread should not block */
     int joined;                 /* the thread has been joined */
     int thread_queue_size;      /* maximum number of queued packets */
+    AVPacket *thread_pkts[16];  /* packets received from the thread in one batch */
+    int thread_pkts_pos;        /* index of the next packet to return in thread_pkts */
+    int nb_thread_pkts;         /* number of packets in thread_pkts */
 #endif
 } InputFile;
 
@@ -31,6 +31,7 @@
 #include "libavutil/imgutils.h"
 #include "libavutil/mem.h"
 #include "libavutil/opt.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/thread.h"
 #include "avcodec.h"
 #include "bsf.h"
@@ -321,6 +322,14 @@ FF_ENABLE_DEPRECATION_WARNINGS
     if (!HAVE_THREADS)
         av_log(avctx, AV_LOG_WARNING, "Warning: not compiled with thread support, using thread emulation\n");
 
+    if (avctx->thread_affinity && *avctx->thread_affinity) {
+        ret = avpriv_thread_check_affinity(avctx->thread_affinity);
+        if (ret < 0) {
+            av_log(avctx, AV_LOG_ERROR, "Invalid CPU list '%s'.\n", avctx->thread_affinity);
+            goto free_and_end;
+        }
+    }
+
     if (CONFIG_FRAME_THREAD_ENCODER && av_codec_is_encoder(avctx->codec)) {
         ret = ff_frame_thread_encoder_init(avctx);
         if (ret < 0)
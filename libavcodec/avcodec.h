@@ -2055,6 +2055,38 @@ typedef struct AVCodecContext {
      *             The decoder can then override during decoding as needed.
      */
     AVChannelLayout ch_layout;
+
+    /**
+     * List of CPUs the worker threads are pinned to, e.g. "0-7,16-23".
+     * Each worker thread is bound to one CPU of the list, assigned
+     * round-robin. NULL leaves the threads unrestricted.
+     * - encoding: Set by user.
+     * - decoding: Set by user.
+     */
+    char *thread_affinity;
+
+    /**
+     * Increment added to the nice value of the worker threads, relative to
+     * the thread calling avcodec_open2(). Only supported where the nice value
+     * is a per-thread property, i.e. on Linux.
+     * - encoding: Set by user.
+     * - decoding: Set by user.
+     */
+    int thread_nice;
+
+    /**
+     * Shared thread pool to run slice threading jobs on, instead of threads
+     * private to this context. thread_count then limits the number of pool
+     * threads working on this context at the same time. Frame threading and
+     * codecs whose slice threading needs a dedicated main thread still use
+     * private threads.
+     *
+     * The pool must outlive the codec context. Must be set before
+     * avcodec_open2().
+     * - encoding: Set by user.
+     * - decoding: Set by user.
+     */
+    struct AVExecutor *executor;
 } AVCodecContext;
 
 /**
@@ -66,6 +66,7 @@ typedef struct{
 
     pthread_t worker[MAX_THREADS];
     atomic_int exit;
+    atomic_int nb_started;
 } ThreadContext;
 
 #define OFF(member) offsetof(ThreadContext, member)
@@ -78,6 +79,8 @@ static void * attribute_align_arg worker(void *v){
     AVCodecContext *avctx = v;
     ThreadContext *c = avctx->internal->frame_thread_encoder;
 
+    ff_pthread_setup_worker(avctx, atomic_fetch_add(&c->nb_started, 1));
+
     while (!atomic_load(&c->exit)) {
         int got_packet = 0, ret;
         AVPacket *pkt;
@@ -199,6 +202,7 @@ av_cold int ff_frame_thread_encoder_init(AVCodecContext *avctx)
     if (ret < 0)
         goto fail;
     atomic_init(&c->exit, 0);
+    atomic_init(&c->nb_started, 0);
 
     c->max_tasks = avctx->thread_count + 2;
     for (unsigned j = 0; j < c->max_tasks; j++) {
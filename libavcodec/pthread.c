@@ -29,6 +29,8 @@
  * @see doc/multithreading.txt
  */
 
+#include "libavutil/error.h"
+#include "libavutil/slicethread.h"
 #include "libavutil/thread.h"
 
 #include "avcodec.h"
@@ -83,6 +85,23 @@ int ff_thread_init(AVCodecContext *avctx)
     return 0;
 }
 
+void ff_pthread_setup_worker(AVCodecContext *avctx, int index)
+{
+    int ret;
+
+    if (avctx->thread_affinity && *avctx->thread_affinity) {
+        ret = avpriv_thread_set_affinity(avctx->thread_affinity, index);
+        if (ret < 0)
+            av_log(avctx, AV_LOG_WARNING, "Could not set thread affinity to '%s': %s\n",
+                   avctx->thread_affinity, av_err2str(ret));
+    }
+
+    ret = avpriv_thread_set_priority(avctx->thread_nice);
+    if (ret < 0)
+        av_log(avctx, AV_LOG_WARNING, "Could not change thread priority: %s\n",
+               av_err2str(ret));
+}
+
 void ff_thread_free(AVCodecContext *avctx)
 {
     if (avctx->active_thread_type&FF_THREAD_FRAME)
@@ -31,6 +31,14 @@ void ff_slice_thread_free(AVCodecContext *avctx);
 int ff_frame_thread_init(AVCodecContext *avctx);
 void ff_frame_thread_free(AVCodecContext *avctx, int thread_count);
 
+/**
+ * Apply AVCodecContext.thread_affinity and AVCodecContext.thread_nice
+ * to the calling worker thread.
+ *
+ * @param index index of the worker, used to pick its CPU from the list
+ */
+void ff_pthread_setup_worker(AVCodecContext *avctx, int index);
+
 #define THREAD_SENTINEL 0 // This forbids putting a mutex/condition variable at the front.
 /**
  * Initialize/destroy a list of mutexes/conditions contained in a structure.
@@ -33,6 +33,7 @@
 #include "libavutil/avassert.h"
 #include "libavutil/common.h"
 #include "libavutil/cpu.h"
+#include "libavutil/executor.h"
 #include "libavutil/mem.h"
 #include "libavutil/thread.h"
 #include "libavutil/slicethread.h"
@@ -43,6 +44,7 @@ typedef int (main_func)(AVCodecContext *c);
 
 typedef struct SliceThreadContext {
     AVSliceThread *thread;
+    AVExecutor *executor;
     action_func *func;
     action_func2 *func2;
     main_func *mainfunc;
@@ -63,14 +65,21 @@ static void main_function(void *priv) {
     c->mainfunc(avctx);
 }
 
+static int run_job(void *priv, int jobnr, int threadnr)
+{
+    AVCodecContext *avctx = priv;
+    SliceThreadContext *c = avctx->internal->thread_ctx;
+
+    return c->func ? c->func(avctx, (char *)c->args + c->job_size * jobnr)
+                   : c->func2(avctx, c->args, jobnr, threadnr);
+}
+
 static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
 {
     AVCodecContext *avctx = priv;
     SliceThreadContext *c = avctx->internal->thread_ctx;
-    int ret;
+    int ret = run_job(priv, jobnr, threadnr);
 
-    ret = c->func ? c->func(avctx, (char *)c->args + c->job_size * jobnr)
-                  : c->func2(avctx, c->args, jobnr, threadnr);
     if (c->rets)
         c->rets[jobnr] = ret;
 }
@@ -108,7 +117,10 @@ static int thread_execute(AVCodecContext *avctx, action_func* func, void *arg, i
     c->func = func;
     c->rets = ret;
 
-    avpriv_slicethread_execute(c->thread, job_count, !!c->mainfunc  );
+    if (c->executor)
+        av_executor_execute(c->executor, run_job, avctx, ret, job_count, avctx->thread_count);
+    else
+        avpriv_slicethread_execute(c->thread, job_count, !!c->mainfunc  );
     return 0;
 }
 
@@ -139,6 +151,29 @@ int ff_slice_thread_init(AVCodecContext *avctx)
         avctx->height > 2800)
         thread_count = avctx->thread_count = 1;
 
+    mainfunc = ffcodec(avctx->codec)->caps_internal & FF_CODEC_CAP_SLICE_THREAD_HAS_MF ? &main_function : NULL;
+
+    /* The main function of a codec expects the workers to make progress
+     * while it runs, which a shared pool cannot guarantee. */
+    if (avctx->executor && !mainfunc) {
+        int nb_threads = av_executor_get_nb_threads(avctx->executor) + 1;
+        thread_count = avctx->thread_count = thread_count ? FFMIN(thread_count, nb_threads)
+                                                          : FFMIN(nb_threads, MAX_AUTO_THREADS);
+        if (thread_count <= 1) {
+            avctx->active_thread_type = 0;
+            return 0;
+        }
+
+        avctx->internal->thread_ctx = c = av_mallocz(sizeof(*c));
+        if (!c)
+            return AVERROR(ENOMEM);
+        c->executor = avctx->executor;
+
+        avctx->execute  = thread_execute;
+        avctx->execute2 = thread_execute2;
+        return 0;
+    }
+
     if (!thread_count) {
         int nb_cpus = av_cpu_count();
         if  (avctx->height)
@@ -156,7 +191,6 @@ int ff_slice_thread_init(AVCodecContext *avctx)
     }
 
     avctx->internal->thread_ctx = c = av_mallocz(sizeof(*c));
-    mainfunc = ffcodec(avctx->codec)->caps_internal & FF_CODEC_CAP_SLICE_THREAD_HAS_MF ? &main_function : NULL;
     if (!c || (thread_count = avpriv_slicethread_create(&c->thread, avctx, worker_func, mainfunc, thread_count)) <= 1) {
         if (c)
             avpriv_slicethread_free(&c->thread);
@@ -167,6 +201,21 @@ int ff_slice_thread_init(AVCodecContext *avctx)
     }
     avctx->thread_count = thread_count;
 
+    if (avctx->thread_affinity && *avctx->thread_affinity) {
+        int ret = avpriv_slicethread_set_affinity(c->thread, avctx->thread_affinity, 1);
+        if (ret == AVERROR(ENOSYS)) {
+            av_log(avctx, AV_LOG_WARNING, "Thread affinity is not supported on this platform.\n");
+        } else if (ret < 0) {
+            ff_slice_thread_free(avctx);
+            avctx->thread_count = 1;
+            avctx->active_thread_type = 0;
+            return ret;
+        }
+    }
+    if (avctx->thread_nice &&
+        avpriv_slicethread_set_priority(c->thread, avctx->thread_nice) < 0)
+        av_log(avctx, AV_LOG_WARNING, "Changing the thread priority is not supported\n");
+
     avctx->execute = thread_execute;
     avctx->execute2 = thread_execute2;
     return 0;
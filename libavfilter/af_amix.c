@@ -53,6 +53,14 @@
 #define DURATION_SHORTEST 1
 #define DURATION_FIRST    2
 
+/* Number of samples of one plane mixed from all inputs of a batch at a time,
+ * small enough for the output block to stay in the L1 cache. */
+#define MIX_BLOCK_SIZE 512
+
+/* Maximum size in bytes of the samples read from a batch of inputs before
+ * mixing them, so that they are still in the L2 cache when mixed. */
+#define MIX_BATCH_SIZE (128 * 1024)
+
 
 typedef struct FrameInfo {
     int nb_samples;
@@ -170,6 +178,7 @@ typedef struct MixContext {
     int sample_rate;            /**< sample rate */
     int planar;
     AVAudioFifo **fifos;        /**< audio fifo for each input */
+    AVFrame **queued;           /**< frame of each input not yet in its fifo */
     uint8_t *input_state;       /**< current state of each input */
     float *input_scale;         /**< mixing scale factor for each input */
     float *weights;             /**< custom weights for every input */
@@ -177,6 +186,13 @@ typedef struct MixContext {
     float *scale_norm;          /**< normalization factor for every input */
     int64_t next_pts;           /**< calculated pts for next output frame */
     FrameList *frame_list;      /**< list of frame info for the first input */
+
+    int nb_threads;
+    uint8_t *mix_data;          /**< samples read from a batch of input fifos */
+    unsigned mix_data_size;
+    uint8_t **mix_planes;       /**< plane pointers in mix_data for every input of the batch */
+    float *mix_scale;           /**< scale factor for every input of the batch */
+    AVFrame **mix_frames;       /**< queued frames mixed directly in the batch */
 } MixContext;
 
 #define OFFSET(x) offsetof(MixContext, x)
@@ -261,6 +277,10 @@ static int config_output(AVFilterLink *outlink)
     if (!s->fifos)
         return AVERROR(ENOMEM);
 
+    s->queued = av_calloc(s->nb_inputs, sizeof(*s->queued));
+    if (!s->queued)
+        return AVERROR(ENOMEM);
+
     s->nb_channels = outlink->ch_layout.nb_channels;
     for (i = 0; i < s->nb_inputs; i++) {
         s->fifos[i] = av_audio_fifo_alloc(outlink->format, s->nb_channels, 1024);
@@ -276,8 +296,13 @@ static int config_output(AVFilterLink *outlink)
 
     s->input_scale = av_calloc(s->nb_inputs, sizeof(*s->input_scale));
     s->scale_norm  = av_calloc(s->nb_inputs, sizeof(*s->scale_norm));
-    if (!s->input_scale || !s->scale_norm)
+    s->mix_planes  = av_calloc(s->nb_inputs, (s->planar ? s->nb_channels : 1) * sizeof(*s->mix_planes));
+    s->mix_scale   = av_calloc(s->nb_inputs, sizeof(*s->mix_scale));
+    s->mix_frames  = av_calloc(s->nb_inputs, sizeof(*s->mix_frames));
+    if (!s->input_scale || !s->scale_norm || !s->mix_planes || !s->mix_scale ||
+        !s->mix_frames)
         return AVERROR(ENOMEM);
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
     for (i = 0; i < s->nb_inputs; i++)
         s->scale_norm[i] = s->weight_sum / FFABS(s->weights[i]);
     calculate_scales(s, 0);
@@ -291,6 +316,105 @@ static int config_output(AVFilterLink *outlink)
     return 0;
 }
 
+/**
+ * Number of samples buffered for an input, in its fifo and its queued frame.
+ */
+static int input_samples(MixContext *s, int i)
+{
+    return av_audio_fifo_size(s->fifos[i]) +
+           (s->queued[i] ? s->queued[i]->nb_samples : 0);
+}
+
+/**
+ * Move the queued frame of an input, if any, to the end of its fifo.
+ */
+static int flush_queued(MixContext *s, int i)
+{
+    int ret = 0;
+
+    if (s->queued[i]) {
+        ret = av_audio_fifo_write(s->fifos[i], (void **)s->queued[i]->extended_data,
+                                  s->queued[i]->nb_samples);
+        av_frame_free(&s->queued[i]);
+    }
+    return ret < 0 ? ret : 0;
+}
+
+/**
+ * Check whether the queued frame of an input can be mixed in place: it must
+ * hold exactly the samples to mix, with room for the aligned mixing length
+ * and the alignment the float DSP functions require.
+ */
+static int queued_mixable(MixContext *s, int i, int nb_samples, int size)
+{
+    const AVFrame *frame = s->queued[i];
+
+    if (!frame || av_audio_fifo_size(s->fifos[i]) ||
+        frame->nb_samples != nb_samples || frame->linesize[0] < size)
+        return 0;
+    for (int p = 0; p < (s->planar ? s->nb_channels : 1); p++)
+        if ((uintptr_t)frame->extended_data[p] & 31)
+            return 0;
+    return 1;
+}
+
+typedef struct ThreadData {
+    AVFrame *out;
+    int nb_active;              /**< number of inputs in the batch */
+    int planes;
+    int plane_size;             /**< number of samples to mix in every plane */
+} ThreadData;
+
+/**
+ * Mix a batch of inputs into a part of the output. Packed audio is split
+ * along the samples, planar audio along the channels. Every block of the
+ * output gets the contribution of all the inputs of the batch before moving
+ * on to the next one, in the same order as a whole plane at a time would.
+ */
+static int mix_inputs(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MixContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int is_float = td->out->format == AV_SAMPLE_FMT_FLT ||
+                         td->out->format == AV_SAMPLE_FMT_FLTP;
+    int plane_start = 0, plane_end = td->planes;
+    int start = 0, end = td->plane_size;
+    int block = MIX_BLOCK_SIZE;
+
+    if (td->planes > 1) {
+        plane_start = (td->planes *  jobnr   ) / nb_jobs;
+        plane_end   = (td->planes * (jobnr+1)) / nb_jobs;
+    } else {
+        start = ((td->plane_size >> 4) *  jobnr   ) / nb_jobs << 4;
+        end   = ((td->plane_size >> 4) * (jobnr+1)) / nb_jobs << 4;
+    }
+
+    /* a single input gains nothing from blocking */
+    if (td->nb_active == 1)
+        block = end - start;
+
+    for (int p = plane_start; p < plane_end; p++) {
+        uint8_t *dst = td->out->extended_data[p];
+
+        for (int n = start; n < end; n += block) {
+            const int len = FFMIN(block, end - n);
+
+            for (int i = 0; i < td->nb_active; i++) {
+                const uint8_t *src = s->mix_planes[i * td->planes + p];
+
+                if (is_float)
+                    s->fdsp->vector_fmac_scalar((float *)dst + n, (const float *)src + n,
+                                                s->mix_scale[i], len);
+                else
+                    s->fdsp->vector_dmac_scalar((double *)dst + n, (const double *)src + n,
+                                                s->mix_scale[i], len);
+            }
+        }
+    }
+
+    return 0;
+}
+
 /**
  * Read samples from the input FIFOs, mix, and write to the output link.
  */
@@ -298,15 +422,16 @@ static int output_frame(AVFilterLink *outlink)
 {
     AVFilterContext *ctx = outlink->src;
     MixContext      *s = ctx->priv;
-    AVFrame *out_buf, *in_buf;
-    int nb_samples, ns, i;
+    AVFrame *out_buf;
+    ThreadData td;
+    int nb_samples, ns, i, input_size, batch, nb_jobs, nb_direct = 0, ret;
 
     if (s->input_state[0] & INPUT_ON) {
         /* first input live: use the corresponding frame size */
         nb_samples = frame_list_next_frame_size(s->frame_list);
         for (i = 1; i < s->nb_inputs; i++) {
             if (s->input_state[i] & INPUT_ON) {
-                ns = av_audio_fifo_size(s->fifos[i]);
+                ns = input_samples(s, i);
                 if (ns < nb_samples) {
                     if (!(s->input_state[i] & INPUT_EOF))
                         /* unclosed input with not enough samples */
@@ -323,7 +448,7 @@ static int output_frame(AVFilterLink *outlink)
         nb_samples = INT_MAX;
         for (i = 1; i < s->nb_inputs; i++) {
             if (s->input_state[i] & INPUT_ON) {
-                ns = av_audio_fifo_size(s->fifos[i]);
+                ns = input_samples(s, i);
                 nb_samples = FFMIN(nb_samples, ns);
             }
         }
@@ -344,40 +469,54 @@ static int output_frame(AVFilterLink *outlink)
     if (!out_buf)
         return AVERROR(ENOMEM);
 
-    in_buf = ff_get_audio_buffer(outlink, nb_samples);
-    if (!in_buf) {
+    td.out        = out_buf;
+    td.planes     = s->planar ? s->nb_channels : 1;
+    td.plane_size = nb_samples * (s->planar ? 1 : s->nb_channels);
+    td.plane_size = FFALIGN(td.plane_size, 16);
+    td.nb_active  = 0;
+    nb_jobs = FFMIN(td.planes > 1 ? td.planes : td.plane_size >> 4, s->nb_threads);
+
+    /* read the inputs by batches and mix each batch in one pass */
+    input_size = td.planes * td.plane_size * av_get_bytes_per_sample(outlink->format);
+    batch = av_clip(MIX_BATCH_SIZE / input_size, 1, s->nb_inputs);
+    av_fast_malloc(&s->mix_data, &s->mix_data_size, (size_t)batch * input_size);
+    if (!s->mix_data) {
         av_frame_free(&out_buf);
         return AVERROR(ENOMEM);
     }
 
     for (i = 0; i < s->nb_inputs; i++) {
         if (s->input_state[i] & INPUT_ON) {
-            int planes, plane_size, p;
-
-            av_audio_fifo_read(s->fifos[i], (void **)in_buf->extended_data,
-                               nb_samples);
-
-            planes     = s->planar ? s->nb_channels : 1;
-            plane_size = nb_samples * (s->planar ? 1 : s->nb_channels);
-            plane_size = FFALIGN(plane_size, 16);
-
-            if (out_buf->format == AV_SAMPLE_FMT_FLT ||
-                out_buf->format == AV_SAMPLE_FMT_FLTP) {
-                for (p = 0; p < planes; p++) {
-                    s->fdsp->vector_fmac_scalar((float *)out_buf->extended_data[p],
-                                                (float *) in_buf->extended_data[p],
-                                                s->input_scale[i], plane_size);
-                }
+            uint8_t **planes = s->mix_planes + td.nb_active * td.planes;
+
+            if (queued_mixable(s, i, nb_samples, input_size / td.planes)) {
+                /* the frame holds exactly the samples to mix, skip the fifo */
+                for (int p = 0; p < td.planes; p++)
+                    planes[p] = s->queued[i]->extended_data[p];
+                s->mix_frames[nb_direct++] = s->queued[i];
+                s->queued[i] = NULL;
             } else {
-                for (p = 0; p < planes; p++) {
-                    s->fdsp->vector_dmac_scalar((double *)out_buf->extended_data[p],
-                                                (double *) in_buf->extended_data[p],
-                                                s->input_scale[i], plane_size);
+                if ((ret = flush_queued(s, i)) < 0) {
+                    while (nb_direct)
+                        av_frame_free(&s->mix_frames[--nb_direct]);
+                    av_frame_free(&out_buf);
+                    return ret;
                 }
+                for (int p = 0; p < td.planes; p++)
+                    planes[p] = s->mix_data + (size_t)td.nb_active * input_size +
+                                p * (input_size / td.planes);
+                av_audio_fifo_read(s->fifos[i], (void **)planes, nb_samples);
             }
+            s->mix_scale[td.nb_active++] = s->input_scale[i];
+        }
+
+        if (td.nb_active == batch || (td.nb_active && i == s->nb_inputs - 1)) {
+            ff_filter_execute(ctx, mix_inputs, &td, NULL, nb_jobs);
+            td.nb_active = 0;
+            while (nb_direct)
+                av_frame_free(&s->mix_frames[--nb_direct]);
         }
     }
-    av_frame_free(&in_buf);
 
     out_buf->pts = s->next_pts;
     if (s->next_pts != AV_NOPTS_VALUE)
@@ -400,7 +539,7 @@ static int request_samples(AVFilterContext *ctx, int min_samples)
         if (!(s->input_state[i] & INPUT_ON) ||
              (s->input_state[i] & INPUT_EOF))
             continue;
-        if (av_audio_fifo_size(s->fifos[i]) >= min_samples)
+        if (input_samples(s, i) >= min_samples)
             continue;
         ff_inlink_request_frame(ctx->inputs[i]);
     }
@@ -451,15 +590,20 @@ static int activate(AVFilterContext *ctx)
                 }
             }
 
-            ret = av_audio_fifo_write(s->fifos[i], (void **)buf->extended_data,
-                                      buf->nb_samples);
-            if (ret < 0) {
+            /* keep the frame aside while the input has nothing buffered,
+             * so that it can be mixed without going through the fifo */
+            if (!input_samples(s, i)) {
+                s->queued[i] = buf;
+            } else {
+                ret = flush_queued(s, i);
+                if (ret >= 0)
+                    ret = av_audio_fifo_write(s->fifos[i], (void **)buf->extended_data,
+                                              buf->nb_samples);
                 av_frame_free(&buf);
-                return ret;
+                if (ret < 0)
+                    return ret;
             }
 
-            av_frame_free(&buf);
-
             ret = output_frame(outlink);
             if (ret < 0)
                 return ret;
@@ -480,7 +624,7 @@ static int activate(AVFilterContext *ctx)
                     }
                 } else {
                     s->input_state[i] |= INPUT_EOF;
-                    if (av_audio_fifo_size(s->fifos[i]) == 0) {
+                    if (input_samples(s, i) == 0) {
                         s->input_state[i] = 0;
                     }
                 }
@@ -580,6 +724,11 @@ static av_cold void uninit(AVFilterContext *ctx)
             av_audio_fifo_free(s->fifos[i]);
         av_freep(&s->fifos);
     }
+    if (s->queued) {
+        for (i = 0; i < s->nb_inputs; i++)
+            av_frame_free(&s->queued[i]);
+        av_freep(&s->queued);
+    }
     frame_list_clear(s->frame_list);
     av_freep(&s->frame_list);
     av_freep(&s->input_state);
@@ -587,6 +736,10 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&s->scale_norm);
     av_freep(&s->weights);
     av_freep(&s->fdsp);
+    av_freep(&s->mix_data);
+    av_freep(&s->mix_planes);
+    av_freep(&s->mix_scale);
+    av_freep(&s->mix_frames);
 }
 
 static int process_command(AVFilterContext *ctx, const char *cmd, const char *args,
@@ -628,5 +781,6 @@ const AVFilter ff_af_amix = {
     FILTER_SAMPLEFMTS(AV_SAMPLE_FMT_FLT, AV_SAMPLE_FMT_FLTP,
                       AV_SAMPLE_FMT_DBL, AV_SAMPLE_FMT_DBLP),
     .process_command = process_command,
-    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS,
+    .flags          = AVFILTER_FLAG_DYNAMIC_INPUTS |
+                      AVFILTER_FLAG_SLICE_THREADS,
 };
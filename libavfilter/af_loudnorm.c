@@ -31,6 +31,7 @@ enum FrameType {
     INNER_FRAME,
     FINAL_FRAME,
     LINEAR_MODE,
+    LOOKAHEAD_MODE,
     FRAME_NB
 };
 
@@ -62,6 +63,7 @@ typedef struct LoudNormContext {
     int linear;
     int dual_mono;
     enum PrintFormat print_format;
+    int64_t lookahead;
 
     double *buf;
     int buf_size;
@@ -91,6 +93,20 @@ typedef struct LoudNormContext {
     int prev_nb_samples;
     int channels;
 
+    double *la_buf;
+    int la_buf_blocks;
+    int block_len;
+    int la_blocks;
+    int nb_blocks;
+    double *block_energy;
+    double *block_peak;
+    double *block_gain;
+    int64_t in_blocks;
+    int64_t out_blocks;
+    int64_t gain_blocks;
+    int in_fill;
+    int eof;
+
     FFEBUR128State *r128_in;
     FFEBUR128State *r128_out;
 } LoudNormContext;
@@ -119,6 +135,7 @@ static const AVOption loudnorm_options[] = {
     {     "none",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  NONE},     0,         0,  FLAGS, "print_format" },
     {     "json",         0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  JSON},     0,         0,  FLAGS, "print_format" },
     {     "summary",      0,                                   0,                        AV_OPT_TYPE_CONST,   {.i64 =  SUMMARY},  0,         0,  FLAGS, "print_format" },
+    { "lookahead",        "set lookahead for single pass normalization", OFFSET(lookahead), AV_OPT_TYPE_DURATION, {.i64 = 0},     0,  60000000,  FLAGS },
     { NULL }
 };
 
@@ -406,6 +423,196 @@ static void true_peak_limiter(LoudNormContext *s, double *out, int nb_samples, i
     }
 }
 
+static void lookahead_measure_block(LoudNormContext *s, const double *src, int nb_samples)
+{
+    const int64_t k = s->in_blocks++;
+    double momentary, peak = 0.;
+    int c;
+
+    ff_ebur128_add_frames_double(s->r128_in, src, nb_samples);
+    for (c = 0; c < s->channels; c++) {
+        double tmp;
+        ff_ebur128_prev_true_peak(s->r128_in, c, &tmp);
+        peak = FFMAX(peak, tmp);
+    }
+
+    /* the first gating block is only complete after 400 ms */
+    ff_ebur128_loudness_momentary(s->r128_in, &momentary);
+    s->block_energy[k % s->nb_blocks] = k < 3 ? 0. : pow(10., (momentary + 0.691) / 10.);
+    s->block_peak[k % s->nb_blocks] = peak;
+}
+
+static void lookahead_calc_gain(LoudNormContext *s)
+{
+    const double abs_gate = pow(10., (-70. + 0.691) / 10.);
+    const int64_t j = s->gain_blocks++;
+    const int64_t start = FFMAX(j - s->la_blocks, 0);
+    const int64_t end = FFMIN(j + s->la_blocks, s->in_blocks - 1);
+    double sum = 0., peak = 0., gain;
+    int64_t k;
+    int cnt = 0;
+
+    for (k = start; k <= end; k++) {
+        const double energy = s->block_energy[k % s->nb_blocks];
+        if (energy > abs_gate) {
+            sum += energy;
+            cnt++;
+        }
+    }
+
+    if (cnt) {
+        const double rel_gate = sum / cnt * 0.1;
+
+        sum = 0.;
+        cnt = 0;
+        for (k = start; k <= end; k++) {
+            const double energy = s->block_energy[k % s->nb_blocks];
+            if (energy > abs_gate && energy >= rel_gate) {
+                sum += energy;
+                cnt++;
+            }
+        }
+        s->prev_delta = pow(10., (s->target_i - (10. * log10(sum / cnt) - 0.691)) / 20.) * s->offset;
+    }
+
+    /* gain ramps between neighbouring blocks, so they bound the peak too */
+    for (k = FFMAX(j - 1, 0); k <= FFMIN(j + 1, s->in_blocks - 1); k++)
+        peak = FFMAX(peak, s->block_peak[k % s->nb_blocks]);
+
+    gain = s->prev_delta;
+    if (peak * gain > s->target_tp)
+        gain = s->target_tp / peak;
+    s->block_gain[j % s->nb_blocks] = gain;
+}
+
+static void lookahead_output_block(LoudNormContext *s, double *dst, int nb_samples)
+{
+    const int64_t j = s->out_blocks++;
+    const double *src = s->la_buf + (j % s->la_buf_blocks) * s->block_len * s->channels;
+    const double ceiling = s->target_tp;
+    double gain_prev, gain, gain_next, start, end;
+    int n, c;
+
+    while (s->gain_blocks <= FFMIN(j + 1, s->in_blocks - 1))
+        lookahead_calc_gain(s);
+
+    gain      = s->block_gain[j % s->nb_blocks];
+    gain_prev = j > 0 ? s->block_gain[(j - 1) % s->nb_blocks] : gain;
+    gain_next = j + 1 < s->in_blocks ? s->block_gain[(j + 1) % s->nb_blocks] : gain;
+    start     = FFMIN(gain_prev, gain);
+    end       = FFMIN(gain, gain_next);
+
+    for (n = 0; n < nb_samples; n++) {
+        const double env = start + ((double) n / s->block_len) * (end - start);
+
+        for (c = 0; c < s->channels; c++) {
+            dst[c] = src[c] * env;
+            if (fabs(dst[c]) > ceiling)
+                dst[c] = ceiling * (dst[c] < 0 ? -1 : 1);
+        }
+        src += s->channels;
+        dst += s->channels;
+    }
+}
+
+static int filter_frame_lookahead(AVFilterLink *inlink, AVFrame *in)
+{
+    AVFilterContext *ctx = inlink->dst;
+    LoudNormContext *s = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
+    const int channels = s->channels;
+    const double *src = (const double *)in->data[0];
+    const int64_t in_blocks = s->in_blocks + (s->in_fill + in->nb_samples) / s->block_len;
+    const int64_t nb_out = FFMAX(in_blocks - s->la_blocks - 1, 0) - s->out_blocks;
+    AVFrame *out = NULL;
+    double *dst = NULL;
+    int remaining = in->nb_samples;
+
+    if (s->pts == AV_NOPTS_VALUE)
+        s->pts = in->pts;
+
+    if (nb_out > 0) {
+        out = ff_get_audio_buffer(outlink, nb_out * s->block_len);
+        if (!out) {
+            av_frame_free(&in);
+            return AVERROR(ENOMEM);
+        }
+        av_frame_copy_props(out, in);
+        out->pts = s->pts;
+        dst = (double *)out->data[0];
+    }
+
+    while (remaining > 0) {
+        double *block = s->la_buf + (s->in_blocks % s->la_buf_blocks) * s->block_len * channels;
+        const int n = FFMIN(remaining, s->block_len - s->in_fill);
+
+        memcpy(block + s->in_fill * channels, src, n * channels * sizeof(*src));
+        src         += n * channels;
+        remaining   -= n;
+        s->in_fill  += n;
+
+        if (s->in_fill == s->block_len) {
+            lookahead_measure_block(s, block, s->block_len);
+            s->in_fill = 0;
+
+            while (s->out_blocks + s->la_blocks + 2 <= s->in_blocks) {
+                lookahead_output_block(s, dst, s->block_len);
+                dst += s->block_len * channels;
+            }
+        }
+    }
+
+    av_frame_free(&in);
+    if (!out)
+        return 0;
+
+    ff_ebur128_add_frames_double(s->r128_out, (double *)out->data[0], out->nb_samples);
+    s->pts += out->nb_samples;
+
+    return ff_filter_frame(outlink, out);
+}
+
+static int flush_lookahead(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    LoudNormContext *s = ctx->priv;
+    int last_len = s->block_len;
+    int64_t nb_samples;
+    AVFrame *out;
+    double *dst;
+
+    s->eof = 1;
+    if (s->in_fill) {
+        double *block = s->la_buf + (s->in_blocks % s->la_buf_blocks) * s->block_len * s->channels;
+
+        lookahead_measure_block(s, block, s->in_fill);
+        last_len = s->in_fill;
+        s->in_fill = 0;
+    }
+
+    nb_samples = (s->in_blocks - s->out_blocks - 1) * s->block_len + last_len;
+    if (s->in_blocks <= s->out_blocks || nb_samples <= 0)
+        return AVERROR_EOF;
+
+    out = ff_get_audio_buffer(outlink, nb_samples);
+    if (!out)
+        return AVERROR(ENOMEM);
+    out->pts = s->pts;
+    dst = (double *)out->data[0];
+
+    while (s->out_blocks < s->in_blocks) {
+        const int len = s->out_blocks + 1 < s->in_blocks ? s->block_len : last_len;
+
+        lookahead_output_block(s, dst, len);
+        dst += len * s->channels;
+    }
+
+    ff_ebur128_add_frames_double(s->r128_out, (double *)out->data[0], out->nb_samples);
+    s->pts += out->nb_samples;
+
+    return ff_filter_frame(outlink, out);
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -420,6 +627,9 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
     double gain, gain_next, env_global, env_shortterm,
     global, shortterm, lra, relative_threshold;
 
+    if (s->frame_type == LOOKAHEAD_MODE)
+        return filter_frame_lookahead(inlink, in);
+
     if (av_frame_is_writable(in)) {
         out = in;
     } else {
@@ -644,6 +854,9 @@ static int request_frame(AVFilterLink *outlink)
     LoudNormContext *s = ctx->priv;
 
     ret = ff_request_frame(inlink);
+    if (ret == AVERROR_EOF && s->frame_type == LOOKAHEAD_MODE && !s->eof)
+        return flush_lookahead(outlink);
+
     if (ret == AVERROR_EOF && s->frame_type == INNER_FRAME) {
         double *src;
         double *buf;
@@ -700,7 +913,7 @@ static int query_formats(AVFilterContext *ctx)
     if (ret < 0)
         return ret;
 
-    if (s->frame_type != LINEAR_MODE) {
+    if (s->frame_type != LINEAR_MODE && s->frame_type != LOOKAHEAD_MODE) {
         formats = ff_make_format_list(input_srate);
         if (!formats)
             return AVERROR(ENOMEM);
@@ -719,12 +932,14 @@ static int config_input(AVFilterLink *inlink)
 {
     AVFilterContext *ctx = inlink->dst;
     LoudNormContext *s = ctx->priv;
+    const int mode = FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA |
+                     (s->frame_type == LOOKAHEAD_MODE ? FF_EBUR128_MODE_TRUE_PEAK : FF_EBUR128_MODE_SAMPLE_PEAK);
 
-    s->r128_in = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
+    s->r128_in = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, mode);
     if (!s->r128_in)
         return AVERROR(ENOMEM);
 
-    s->r128_out = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, FF_EBUR128_MODE_I | FF_EBUR128_MODE_S | FF_EBUR128_MODE_LRA | FF_EBUR128_MODE_SAMPLE_PEAK);
+    s->r128_out = ff_ebur128_init(inlink->ch_layout.nb_channels, inlink->sample_rate, 0, mode);
     if (!s->r128_out)
         return AVERROR(ENOMEM);
 
@@ -749,7 +964,20 @@ static int config_input(AVFilterLink *inlink)
 
     init_gaussian_filter(s);
 
-    if (s->frame_type != LINEAR_MODE) {
+    if (s->frame_type == LOOKAHEAD_MODE) {
+        s->block_len     = (inlink->sample_rate + 5) / 10;
+        s->la_blocks     = FFMAX((s->lookahead + 99999) / 100000, 1);
+        s->la_buf_blocks = s->la_blocks + 4;
+        s->nb_blocks     = 2 * s->la_blocks + 8;
+
+        s->la_buf = av_malloc_array(s->la_buf_blocks * s->block_len,
+                                    inlink->ch_layout.nb_channels * sizeof(*s->la_buf));
+        s->block_energy = av_calloc(s->nb_blocks, sizeof(*s->block_energy));
+        s->block_peak   = av_calloc(s->nb_blocks, sizeof(*s->block_peak));
+        s->block_gain   = av_calloc(s->nb_blocks, sizeof(*s->block_gain));
+        if (!s->la_buf || !s->block_energy || !s->block_peak || !s->block_gain)
+            return AVERROR(ENOMEM);
+    } else if (s->frame_type != LINEAR_MODE) {
         inlink->min_samples =
         inlink->max_samples = frame_size(inlink->sample_rate, 3000);
     }
@@ -765,6 +993,7 @@ static int config_input(AVFilterLink *inlink)
     s->target_tp = pow(10., s->target_tp / 20.);
     s->attack_length = frame_size(inlink->sample_rate, 10);
     s->release_length = frame_size(inlink->sample_rate, 100);
+    s->prev_delta = s->offset;
 
     return 0;
 }
@@ -787,6 +1016,9 @@ static av_cold int init(AVFilterContext *ctx)
         }
     }
 
+    if (s->frame_type == FIRST_FRAME && s->lookahead)
+        s->frame_type = LOOKAHEAD_MODE;
+
     return 0;
 }
 
@@ -794,17 +1026,20 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     LoudNormContext *s = ctx->priv;
     double i_in, i_out, lra_in, lra_out, thresh_in, thresh_out, tp_in, tp_out;
+    int (*peak)(FFEBUR128State *st, unsigned int channel_number, double *out);
     int c;
 
     if (!s->r128_in || !s->r128_out)
         goto end;
 
+    peak = s->frame_type == LOOKAHEAD_MODE ? ff_ebur128_true_peak : ff_ebur128_sample_peak;
+
     ff_ebur128_loudness_range(s->r128_in, &lra_in);
     ff_ebur128_loudness_global(s->r128_in, &i_in);
     ff_ebur128_relative_threshold(s->r128_in, &thresh_in);
     for (c = 0; c < s->channels; c++) {
         double tmp;
-        ff_ebur128_sample_peak(s->r128_in, c, &tmp);
+        peak(s->r128_in, c, &tmp);
         if ((c == 0) || (tmp > tp_in))
             tp_in = tmp;
     }
@@ -814,7 +1049,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     ff_ebur128_relative_threshold(s->r128_out, &thresh_out);
     for (c = 0; c < s->channels; c++) {
         double tmp;
-        ff_ebur128_sample_peak(s->r128_out, c, &tmp);
+        peak(s->r128_out, c, &tmp);
         if ((c == 0) || (tmp > tp_out))
             tp_out = tmp;
     }
@@ -845,7 +1080,8 @@ static av_cold void uninit(AVFilterContext *ctx)
             20. * log10(tp_out),
             lra_out,
             thresh_out,
-            s->frame_type == LINEAR_MODE ? "linear" : "dynamic",
+            s->frame_type == LINEAR_MODE ? "linear" :
+            s->frame_type == LOOKAHEAD_MODE ? "lookahead" : "dynamic",
             s->target_i - i_out
         );
         break;
@@ -873,7 +1109,8 @@ static av_cold void uninit(AVFilterContext *ctx)
             20. * log10(tp_out),
             lra_out,
             thresh_out,
-            s->frame_type == LINEAR_MODE ? "Linear" : "Dynamic",
+            s->frame_type == LINEAR_MODE ? "Linear" :
+            s->frame_type == LOOKAHEAD_MODE ? "Lookahead" : "Dynamic",
             s->target_i - i_out
         );
         break;
@@ -887,6 +1124,10 @@ end:
     av_freep(&s->limiter_buf);
     av_freep(&s->prev_smp);
     av_freep(&s->buf);
+    av_freep(&s->la_buf);
+    av_freep(&s->block_energy);
+    av_freep(&s->block_peak);
+    av_freep(&s->block_gain);
 }
 
 static const AVFilterPad avfilter_af_loudnorm_inputs[] = {
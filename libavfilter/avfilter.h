@@ -924,6 +924,38 @@ typedef struct AVFilterGraph {
 
     char *aresample_swr_opts; ///< swr options to use for the auto-inserted aresample filters, Access ONLY through AVOptions
 
+    /**
+     * List of CPUs the worker threads of this graph are pinned to, e.g.
+     * "0-7,16-23". Each worker is bound to one CPU of the list, so the frame
+     * memory it touches first is allocated on that CPU's NUMA node. Graphs
+     * sharing a list continue the assignment after the CPUs taken by the
+     * previous ones. The thread running the graph also executes slice jobs
+     * and is not pinned by this option.
+     * May be set by the caller before adding any filters to the filtergraph.
+     * NULL (the default) leaves the threads unrestricted.
+     * Access ONLY through AVOptions.
+     */
+    char *thread_affinity;
+
+    /**
+     * Increment added to the nice value of the worker threads of this graph.
+     * Only supported where the nice value is a per-thread property, i.e. on
+     * Linux. May be set by the caller before adding any filters to the
+     * filtergraph. Access ONLY through AVOptions.
+     */
+    int thread_nice;
+
+    /**
+     * Shared thread pool to run slice threading jobs on, instead of threads
+     * private to this graph. nb_threads then limits the number of pool
+     * threads working on one filter at the same time.
+     *
+     * The pool must outlive the graph. May be set by the caller before adding
+     * any filters to the filtergraph; thread_affinity and thread_nice do not
+     * apply to it.
+     */
+    struct AVExecutor *executor;
+
     /**
      * Private fields
      *
@@ -51,6 +51,10 @@ static const AVOption filtergraph_options[] = {
     { "threads",     "Maximum number of threads", OFFSET(nb_threads), AV_OPT_TYPE_INT,
         { .i64 = 0 }, 0, INT_MAX, F|V|A, "threads"},
         {"auto", "autodetect a suitable number of threads to use", 0, AV_OPT_TYPE_CONST, {.i64 = 0 }, .flags = F|V|A, .unit = "threads"},
+    {"thread_affinity", "list of CPUs to pin the worker threads to", OFFSET(thread_affinity),
+        AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|V|A },
+    {"thread_nice", "nice value increment of the worker threads", OFFSET(thread_nice),
+        AV_OPT_TYPE_INT, {.i64 = 0}, -40, 40, F|V|A },
     {"scale_sws_opts"       , "default scale filter options"        , OFFSET(scale_sws_opts)        ,
         AV_OPT_TYPE_STRING, {.str = NULL}, 0, 0, F|V },
     {"aresample_swr_opts"   , "default aresample filter options"    , OFFSET(aresample_swr_opts)    ,
@@ -24,8 +24,8 @@
 
 #include "config.h"
 #include "avfilter.h"
+#include "motion_estimation.h"
 #include "transform.h"
-#include "libavutil/pixelutils.h"
 
 
 enum SearchMethod {
@@ -64,7 +64,9 @@ typedef struct DeshakeContext {
     int blocksize;             ///< Size of blocks to compare
     int contrast;              ///< Contrast threshold
     int search;                ///< Motion search method
-    av_pixelutils_sad_fn sad;  ///< Sum of the absolute difference function
+    AVMotionEstContext me_ctx; ///< Block matching context
+    IntMotionVector *block_mvs; ///< Scratch buffer for block motion vectors
+    unsigned block_mvs_size;
     Transform last;            ///< Transform from last frame
     int refcount;              ///< Number of reference frames (defines averaging window)
     FILE *fp;
@@ -42,10 +42,12 @@
 */
 
 #include "ebur128.h"
+#include "ebur128dsp.h"
 
 #include <float.h>
 #include <limits.h>
 #include <math.h>               /* You may have to define _USE_MATH_DEFINES if you use MSVC */
+#include <string.h>
 
 #include "libavutil/error.h"
 #include "libavutil/macros.h"
@@ -61,6 +63,9 @@
 
 #define ALMOST_ZERO 0.000001
 
+/* Frames oversampled per true peak DSP call. */
+#define TRUE_PEAK_FRAMES 1024
+
 #define RELATIVE_GATE         (-10.0)
 #define RELATIVE_GATE_FACTOR  pow(10.0, RELATIVE_GATE / 10.0)
 #define MINUS_20DB            pow(10.0, -20.0 / 10.0)
@@ -84,8 +89,8 @@ struct FFEBUR128StateInternal {
     double b[5];
     /** BS.1770 filter coefficients (denominator). */
     double a[5];
-    /** BS.1770 filter state. */
-    double v[5][5];
+    /** BS.1770 filter state, v[i-1] to v[i-4] of all channels, planar. */
+    double *filter_state;
     /** Histograms, used to calculate LRA. */
     unsigned long *block_energy_histogram;
     unsigned long *short_term_block_energy_histogram;
@@ -93,6 +98,18 @@ struct FFEBUR128StateInternal {
     size_t short_term_frame_counter;
     /** Maximum sample peak, one per channel */
     double *sample_peak;
+    /** Maximum true peak, one per channel */
+    double *true_peak;
+    /** Maximum true peak of the last add_frames() call, one per channel */
+    double *prev_true_peak;
+    /** Oversampling factor of the true peak interpolator. */
+    unsigned interp_factor;
+    /** Interpolator coefficients. */
+    double interp_coeffs[4 * EBUR128_TRUE_PEAK_TAPS];
+    /** Interleaved interpolator input, history followed by new samples. */
+    double *interp_buf;
+    /** K-weighting and true peak interpolator functions. */
+    EBUR128DSPContext dsp;
     /** The maximum window duration in ms. */
     unsigned long window;
     /** Data pointer array for interleaved data */
@@ -105,8 +122,6 @@ static DECLARE_ALIGNED(32, double, histogram_energy_boundaries)[1001];
 
 static void ebur128_init_filter(FFEBUR128State * st)
 {
-    int i, j;
-
     double f0 = 1681.974450955533;
     double G = 3.999843853973347;
     double Q = 0.7071752369554196;
@@ -145,12 +160,6 @@ static void ebur128_init_filter(FFEBUR128State * st)
     st->d->a[2] = pa[0] * ra[2] + pa[1] * ra[1] + pa[2] * ra[0];
     st->d->a[3] = pa[1] * ra[2] + pa[2] * ra[1];
     st->d->a[4] = pa[2] * ra[2];
-
-    for (i = 0; i < 5; ++i) {
-        for (j = 0; j < 5; ++j) {
-            st->d->v[i][j] = 0.0;
-        }
-    }
 }
 
 static int ebur128_init_channel_map(FFEBUR128State * st)
@@ -201,6 +210,31 @@ static int ebur128_init_channel_map(FFEBUR128State * st)
     return 0;
 }
 
+static int ebur128_init_true_peak(FFEBUR128State * st)
+{
+    struct FFEBUR128StateInternal *d = st->d;
+
+    d->true_peak      = av_calloc(st->channels, sizeof(*d->true_peak));
+    d->prev_true_peak = av_calloc(st->channels, sizeof(*d->prev_true_peak));
+    if (!d->true_peak || !d->prev_true_peak)
+        return AVERROR(ENOMEM);
+
+    d->interp_factor = st->samplerate < 96000  ? 4 :
+                       st->samplerate < 192000 ? 2 : 1;
+    if (d->interp_factor == 1)
+        return 0;
+
+    d->interp_buf = av_calloc(st->channels,
+                              (EBUR128_TRUE_PEAK_TAPS - 1 + TRUE_PEAK_FRAMES) *
+                              sizeof(*d->interp_buf));
+    if (!d->interp_buf)
+        return AVERROR(ENOMEM);
+
+    ff_ebur128_true_peak_coeffs(d->interp_coeffs, d->interp_factor);
+
+    return 0;
+}
+
 static inline void init_histogram(void)
 {
     int i;
@@ -226,7 +260,7 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
     st = (FFEBUR128State *) av_malloc(sizeof(*st));
     CHECK_ERROR(!st, 0, exit)
     st->d = (struct FFEBUR128StateInternal *)
-        av_malloc(sizeof(*st->d));
+        av_mallocz(sizeof(*st->d));
     CHECK_ERROR(!st->d, 0, free_state)
     st->channels = channels;
     errcode = ebur128_init_channel_map(st);
@@ -258,7 +292,11 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
                              st->channels * sizeof(*st->d->audio_data));
     CHECK_ERROR(!st->d->audio_data, 0, free_sample_peak)
 
+    st->d->filter_state =
+        (double *) av_calloc(4 * st->channels, sizeof(*st->d->filter_state));
+    CHECK_ERROR(!st->d->filter_state, 0, free_audio_data)
     ebur128_init_filter(st);
+    ff_ebur128_dsp_init(&st->d->dsp);
 
     st->d->block_energy_histogram =
         av_mallocz(1000 * sizeof(*st->d->block_energy_histogram));
@@ -281,13 +319,24 @@ FFEBUR128State *ff_ebur128_init(unsigned int channels,
     CHECK_ERROR(!st->d->data_ptrs, 0,
                 free_short_term_block_energy_histogram);
 
+    if ((mode & FF_EBUR128_MODE_TRUE_PEAK) == FF_EBUR128_MODE_TRUE_PEAK) {
+        errcode = ebur128_init_true_peak(st);
+        CHECK_ERROR(errcode, 0, free_true_peak)
+    }
+
     return st;
 
+free_true_peak:
+    av_free(st->d->interp_buf);
+    av_free(st->d->prev_true_peak);
+    av_free(st->d->true_peak);
+    av_free(st->d->data_ptrs);
 free_short_term_block_energy_histogram:
     av_free(st->d->short_term_block_energy_histogram);
 free_block_energy_histogram:
     av_free(st->d->block_energy_histogram);
 free_audio_data:
+    av_free(st->d->filter_state);
     av_free(st->d->audio_data);
 free_sample_peak:
     av_free(st->d->sample_peak);
@@ -306,14 +355,59 @@ void ff_ebur128_destroy(FFEBUR128State ** st)
     av_free((*st)->d->block_energy_histogram);
     av_free((*st)->d->short_term_block_energy_histogram);
     av_free((*st)->d->audio_data);
+    av_free((*st)->d->filter_state);
     av_free((*st)->d->channel_map);
     av_free((*st)->d->sample_peak);
+    av_free((*st)->d->true_peak);
+    av_free((*st)->d->prev_true_peak);
+    av_free((*st)->d->interp_buf);
     av_free((*st)->d->data_ptrs);
     av_free((*st)->d);
     av_free(*st);
     *st = NULL;
 }
 
+static void ebur128_check_true_peak(FFEBUR128State * st, const double **srcs,
+                                    size_t src_index, size_t frames,
+                                    int stride)
+{
+    struct FFEBUR128StateInternal *d = st->d;
+    const size_t history = (EBUR128_TRUE_PEAK_TAPS - 1) * st->channels;
+    double *buf = d->interp_buf;
+    size_t i, c;
+
+    if (d->interp_factor == 1) {
+        for (c = 0; c < st->channels; ++c) {
+            for (i = 0; i < frames; ++i) {
+                const double v = fabs(srcs[c][src_index + i * stride]);
+                if (v > d->prev_true_peak[c])
+                    d->prev_true_peak[c] = v;
+            }
+        }
+    }
+
+    while (d->interp_factor > 1 && frames > 0) {
+        const size_t n = FFMIN(frames, TRUE_PEAK_FRAMES);
+
+        for (c = 0; c < st->channels; ++c)
+            for (i = 0; i < n; ++i)
+                buf[history + i * st->channels + c] = srcs[c][src_index + i * stride];
+
+        if (d->interp_factor == 4)
+            d->dsp.true_peak_4x(d->prev_true_peak, d->interp_coeffs, buf, n, st->channels);
+        else
+            d->dsp.true_peak_2x(d->prev_true_peak, d->interp_coeffs, buf, n, st->channels);
+
+        memmove(buf, buf + n * st->channels, history * sizeof(*buf));
+        src_index += n * stride;
+        frames    -= n;
+    }
+
+    for (c = 0; c < st->channels; ++c)
+        if (d->prev_true_peak[c] > d->true_peak[c])
+            d->true_peak[c] = d->prev_true_peak[c];
+}
+
 #define EBUR128_FILTER(type, scaling_factor)                                       \
 static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,           \
                                   size_t src_index, size_t frames,                 \
@@ -336,32 +430,15 @@ static void ebur128_filter_##type(FFEBUR128State* st, const type** srcs,
             if (max > st->d->sample_peak[c]) st->d->sample_peak[c] = max;          \
         }                                                                          \
     }                                                                              \
-    for (c = 0; c < st->channels; ++c) {                                           \
-        int ci = st->d->channel_map[c] - 1;                                        \
-        if (ci < 0) continue;                                                      \
-        else if (ci == FF_EBUR128_DUAL_MONO - 1) ci = 0; /*dual mono */            \
-        for (i = 0; i < frames; ++i) {                                             \
-            st->d->v[ci][0] = (double) (srcs[c][src_index + i * stride] / scaling_factor) \
-                         - st->d->a[1] * st->d->v[ci][1]                           \
-                         - st->d->a[2] * st->d->v[ci][2]                           \
-                         - st->d->a[3] * st->d->v[ci][3]                           \
-                         - st->d->a[4] * st->d->v[ci][4];                          \
-            audio_data[i * st->channels + c] =                                     \
-                           st->d->b[0] * st->d->v[ci][0]                           \
-                         + st->d->b[1] * st->d->v[ci][1]                           \
-                         + st->d->b[2] * st->d->v[ci][2]                           \
-                         + st->d->b[3] * st->d->v[ci][3]                           \
-                         + st->d->b[4] * st->d->v[ci][4];                          \
-            st->d->v[ci][4] = st->d->v[ci][3];                                     \
-            st->d->v[ci][3] = st->d->v[ci][2];                                     \
-            st->d->v[ci][2] = st->d->v[ci][1];                                     \
-            st->d->v[ci][1] = st->d->v[ci][0];                                     \
-        }                                                                          \
-        st->d->v[ci][4] = fabs(st->d->v[ci][4]) < DBL_MIN ? 0.0 : st->d->v[ci][4]; \
-        st->d->v[ci][3] = fabs(st->d->v[ci][3]) < DBL_MIN ? 0.0 : st->d->v[ci][3]; \
-        st->d->v[ci][2] = fabs(st->d->v[ci][2]) < DBL_MIN ? 0.0 : st->d->v[ci][2]; \
-        st->d->v[ci][1] = fabs(st->d->v[ci][1]) < DBL_MIN ? 0.0 : st->d->v[ci][1]; \
-    }                                                                              \
+    if ((st->mode & FF_EBUR128_MODE_TRUE_PEAK) == FF_EBUR128_MODE_TRUE_PEAK)       \
+        ebur128_check_true_peak(st, srcs, src_index, frames, stride);              \
+    /* the input is interleaved, srcs[c] points to channel c of the first          \
+     * frame and stride is the number of channels */                               \
+    st->d->dsp.filter(st->d->b, st->d->a, st->d->filter_state, audio_data,         \
+                      srcs[0] + src_index, frames, st->channels);                  \
+    for (i = 0; i < 4 * st->channels; ++i)                                         \
+        if (fabs(st->d->filter_state[i]) < DBL_MIN)                                \
+            st->d->filter_state[i] = 0.0;                                          \
 }
 EBUR128_FILTER(double, 1.0)
 
@@ -508,6 +585,9 @@ void ff_ebur128_add_frames_##type(FFEBUR128State* st, const type* src,         \
   const type **buf = (const type**)st->d->data_ptrs;                           \
   for (i = 0; i < st->channels; i++)                                           \
     buf[i] = src + i;                                                          \
+  if ((st->mode & FF_EBUR128_MODE_TRUE_PEAK) == FF_EBUR128_MODE_TRUE_PEAK)     \
+    memset(st->d->prev_true_peak, 0,                                           \
+           st->channels * sizeof(*st->d->prev_true_peak));                     \
   ebur128_add_frames_planar_##type(st, buf, frames, st->channels);             \
 }
 FF_EBUR128_ADD_FRAMES(double)
@@ -614,6 +694,21 @@ static int ebur128_energy_shortterm(FFEBUR128State * st, double *out)
                                       out);
 }
 
+int ff_ebur128_loudness_momentary(FFEBUR128State * st, double *out)
+{
+    double energy;
+    int error = ebur128_energy_in_interval(st, st->d->samples_in_100ms * 4,
+                                           &energy);
+    if (error) {
+        return error;
+    } else if (energy <= 0.0) {
+        *out = -HUGE_VAL;
+        return 0;
+    }
+    *out = ebur128_energy_to_loudness(energy);
+    return 0;
+}
+
 int ff_ebur128_loudness_shortterm(FFEBUR128State * st, double *out)
 {
     double energy;
@@ -723,3 +818,29 @@ int ff_ebur128_sample_peak(FFEBUR128State * st,
     *out = st->d->sample_peak[channel_number];
     return 0;
 }
+
+int ff_ebur128_true_peak(FFEBUR128State * st,
+                         unsigned int channel_number, double *out)
+{
+    if ((st->mode & FF_EBUR128_MODE_TRUE_PEAK) !=
+        FF_EBUR128_MODE_TRUE_PEAK) {
+        return AVERROR(EINVAL);
+    } else if (channel_number >= st->channels) {
+        return AVERROR(EINVAL);
+    }
+    *out = st->d->true_peak[channel_number];
+    return 0;
+}
+
+int ff_ebur128_prev_true_peak(FFEBUR128State * st,
+                              unsigned int channel_number, double *out)
+{
+    if ((st->mode & FF_EBUR128_MODE_TRUE_PEAK) !=
+        FF_EBUR128_MODE_TRUE_PEAK) {
+        return AVERROR(EINVAL);
+    } else if (channel_number >= st->channels) {
+        return AVERROR(EINVAL);
+    }
+    *out = st->d->prev_true_peak[channel_number];
+    return 0;
+}
@@ -91,6 +91,8 @@ enum mode {
     FF_EBUR128_MODE_LRA = (1 << 3) | FF_EBUR128_MODE_S,
   /** can call ff_ebur128_sample_peak */
     FF_EBUR128_MODE_SAMPLE_PEAK = (1 << 4) | FF_EBUR128_MODE_M,
+  /** can call ff_ebur128_true_peak and ff_ebur128_prev_true_peak */
+    FF_EBUR128_MODE_TRUE_PEAK = (1 << 5) | FF_EBUR128_MODE_SAMPLE_PEAK,
 };
 
 /** forward declaration of FFEBUR128StateInternal */
@@ -165,6 +167,16 @@ void ff_ebur128_add_frames_double(FFEBUR128State * st,
  */
 int ff_ebur128_loudness_global(FFEBUR128State * st, double *out);
 
+/** \brief Get momentary loudness (last 400ms) in LUFS.
+ *
+ *  @param st library state.
+ *  @param out momentary loudness in LUFS. -HUGE_VAL if result is negative
+ *             infinity.
+ *  @return
+ *    - 0 on success.
+ */
+int ff_ebur128_loudness_momentary(FFEBUR128State * st, double *out);
+
 /** \brief Get short-term loudness (last 3s) in LUFS.
  *
  *  @param st library state.
@@ -216,6 +228,35 @@ int ff_ebur128_loudness_range_multiple(FFEBUR128State ** sts,
 int ff_ebur128_sample_peak(FFEBUR128State * st,
                            unsigned int channel_number, double *out);
 
+/** \brief Get maximum true peak of selected channel in float format.
+ *
+ *  Uses a polyphase interpolator to oversample the signal 4 times below
+ *  96kHz, 2 times below 192kHz and not at all above.
+ *
+ *  @param st library state
+ *  @param channel_number channel to analyse
+ *  @param out maximum true peak in float format (1.0 is 0 dBFS)
+ *  @return
+ *    - 0 on success.
+ *    - AVERROR(EINVAL) if mode "FF_EBUR128_MODE_TRUE_PEAK" has not been set.
+ *    - AVERROR(EINVAL) if invalid channel index.
+ */
+int ff_ebur128_true_peak(FFEBUR128State * st,
+                         unsigned int channel_number, double *out);
+
+/** \brief Get maximum true peak from the last call to add_frames().
+ *
+ *  @param st library state
+ *  @param channel_number channel to analyse
+ *  @param out maximum true peak in float format (1.0 is 0 dBFS)
+ *  @return
+ *    - 0 on success.
+ *    - AVERROR(EINVAL) if mode "FF_EBUR128_MODE_TRUE_PEAK" has not been set.
+ *    - AVERROR(EINVAL) if invalid channel index.
+ */
+int ff_ebur128_prev_true_peak(FFEBUR128State * st,
+                              unsigned int channel_number, double *out);
+
 /** \brief Get relative threshold in LUFS.
  *
  *  @param st library state
@@ -0,0 +1,190 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <math.h>
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/common.h"
+#include "libavutil/mathematics.h"
+#include "ebur128dsp.h"
+
+/* Kaiser window parameter of the interpolator. With 12 taps per phase this
+ * keeps 4x true peak readings of steady sines at 48kHz within 0.1dB of an
+ * ideal 4x oversampled reading up to 19kHz. Abrupt onsets still ring above
+ * the steady amplitude, as with any band-limited reconstruction. */
+#define TRUE_PEAK_KAISER_BETA 6.0
+
+static double bessel_i0(double x)
+{
+    double term = 1.0, sum = 1.0, last_sum, x2 = x / 2.0;
+    int i = 1;
+
+    do {
+        const double y = x2 / i++;
+
+        last_sum = sum;
+        sum += term *= y * y;
+    } while (sum != last_sum);
+
+    return sum;
+}
+
+av_cold void ff_ebur128_true_peak_coeffs(double *coeffs, int factor)
+{
+    const int len = factor * EBUR128_TRUE_PEAK_TAPS;
+    const double norm = 1.0 / bessel_i0(TRUE_PEAK_KAISER_BETA);
+    double sum = 0.0;
+    int i;
+
+    /* Kaiser windowed sinc low-pass at the input Nyquist frequency. Tap j of
+     * phase p is stored at j * factor + p with tap 0 applying to the oldest
+     * sample, so that all phases of an output sample come from the same
+     * input samples. */
+    for (i = 0; i < len; i++) {
+        const int phase = i % factor;
+        const int tap   = EBUR128_TRUE_PEAK_TAPS - 1 - i / factor;
+        const double x  = M_PI * (i - (len - 1) / 2.0) / factor;
+        const double r  = 2.0 * i / (len - 1) - 1.0;
+        double h = x == 0.0 ? 1.0 : sin(x) / x;
+
+        h *= bessel_i0(TRUE_PEAK_KAISER_BETA * sqrt(FFMAX(1.0 - r * r, 0.0))) * norm;
+        coeffs[tap * factor + phase] = h;
+        sum += h;
+    }
+    for (i = 0; i < len; i++)
+        coeffs[i] *= factor / sum;
+}
+
+static void filter_channels_c(const EBUR128Biquad *filters, double *state,
+                              const double *samples,
+                              double *cache_400, double *cache_3000,
+                              double *sum_400, double *sum_3000,
+                              int nb_channels)
+{
+    const EBUR128Biquad *pre = &filters[0];
+    const EBUR128Biquad *rlb = &filters[1];
+    double *x1 = state;
+    double *x2 = x1 + nb_channels;
+    double *y1 = x2 + nb_channels;
+    double *y2 = y1 + nb_channels;
+    double *z1 = y2 + nb_channels;
+    double *z2 = z1 + nb_channels;
+
+    for (int ch = 0; ch < nb_channels; ch++) {
+        /* Y[i] = X[i]*b0 + X[i-1]*b1 + X[i-2]*b2 - Y[i-1]*a1 - Y[i-2]*a2 */
+        const double x0 = samples[ch];
+        const double y0 = x0 * pre->b0 + x1[ch] * pre->b1 + x2[ch] * pre->b2
+                                       - y1[ch] * pre->a1 - y2[ch] * pre->a2;
+        const double z0 = y0 * rlb->b0 + y1[ch] * rlb->b1 + y2[ch] * rlb->b2
+                                       - z1[ch] * rlb->a1 - z2[ch] * rlb->a2;
+        const double bin = z0 * z0;
+
+        x2[ch] = x1[ch];
+        x1[ch] = x0;
+        y2[ch] = y1[ch];
+        y1[ch] = y0;
+        z2[ch] = z1[ch];
+        z1[ch] = z0;
+
+        /* add the new value, and limit the sum to the cache size (400ms or 3s)
+         * by removing the oldest one */
+        sum_400 [ch] = sum_400 [ch] + bin - cache_400 [ch];
+        sum_3000[ch] = sum_3000[ch] + bin - cache_3000[ch];
+
+        /* override old cache entry with the new value */
+        cache_400 [ch] = bin;
+        cache_3000[ch] = bin;
+    }
+}
+
+static void filter_c(const double *b, const double *a, double *state,
+                     double *dst, const double *src,
+                     int nb_samples, int nb_channels)
+{
+    for (int ch = 0; ch < nb_channels; ch++) {
+        double v1 = state[0 * nb_channels + ch];
+        double v2 = state[1 * nb_channels + ch];
+        double v3 = state[2 * nb_channels + ch];
+        double v4 = state[3 * nb_channels + ch];
+
+        for (int n = 0; n < nb_samples; n++) {
+            const double v0 = src[n * nb_channels + ch]
+                            - a[1] * v1 - a[2] * v2 - a[3] * v3 - a[4] * v4;
+
+            dst[n * nb_channels + ch] = b[0] * v0 + b[1] * v1 + b[2] * v2
+                                      + b[3] * v3 + b[4] * v4;
+            v4 = v3;
+            v3 = v2;
+            v2 = v1;
+            v1 = v0;
+        }
+
+        state[0 * nb_channels + ch] = v1;
+        state[1 * nb_channels + ch] = v2;
+        state[2 * nb_channels + ch] = v3;
+        state[3 * nb_channels + ch] = v4;
+    }
+}
+
+static av_always_inline void true_peak_c(double *peaks, const double *coeffs,
+                                         const double *src, int nb_samples,
+                                         int nb_channels, int factor)
+{
+    for (int ch = 0; ch < nb_channels; ch++) {
+        const double *x = src + ch;
+        double peak = peaks[ch];
+
+        for (int n = 0; n < nb_samples; n++) {
+            peak = FFMAX(peak, fabs(x[(EBUR128_TRUE_PEAK_TAPS - 1) * nb_channels]));
+            for (int p = 0; p < factor; p++) {
+                double sum = 0.0;
+
+                for (int j = 0; j < EBUR128_TRUE_PEAK_TAPS; j++)
+                    sum += coeffs[j * factor + p] * x[j * nb_channels];
+                peak = FFMAX(peak, fabs(sum));
+            }
+            x += nb_channels;
+        }
+        peaks[ch] = peak;
+    }
+}
+
+static void true_peak_4x_c(double *peaks, const double *coeffs,
+                           const double *src, int nb_samples, int nb_channels)
+{
+    true_peak_c(peaks, coeffs, src, nb_samples, nb_channels, 4);
+}
+
+static void true_peak_2x_c(double *peaks, const double *coeffs,
+                           const double *src, int nb_samples, int nb_channels)
+{
+    true_peak_c(peaks, coeffs, src, nb_samples, nb_channels, 2);
+}
+
+av_cold void ff_ebur128_dsp_init(EBUR128DSPContext *dsp)
+{
+    dsp->filter_channels = filter_channels_c;
+    dsp->filter          = filter_c;
+    dsp->true_peak_4x    = true_peak_4x_c;
+    dsp->true_peak_2x    = true_peak_2x_c;
+
+#if ARCH_X86
+    ff_ebur128_dsp_init_x86(dsp);
+#endif
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_EBUR128DSP_H
+#define AVFILTER_EBUR128DSP_H
+
+/**
+ * Number of taps of each phase of the true peak interpolator.
+ */
+#define EBUR128_TRUE_PEAK_TAPS 12
+
+typedef struct EBUR128Biquad {
+    double b0, b1, b2;
+    double a1, a2;
+} EBUR128Biquad;
+
+typedef struct EBUR128DSPContext {
+    /**
+     * Apply the K-weighting filters to one sample of every channel and add
+     * the squared result to the 400ms and 3s integrators.
+     *
+     * @param filters    pre-filter followed by RLB-filter
+     * @param state      x[i-1], x[i-2], y[i-1], y[i-2], z[i-1] and z[i-2]
+     *                   of all channels, one nb_channels long plane each
+     * @param samples    interleaved input sample
+     * @param cache_400  current bin of the 400ms cache, overwritten
+     * @param cache_3000 current bin of the 3s cache, overwritten
+     * @param sum_400    running sums of the 400ms cache
+     * @param sum_3000   running sums of the 3s cache
+     */
+    void (*filter_channels)(const EBUR128Biquad *filters, double *state,
+                            const double *samples,
+                            double *cache_400, double *cache_3000,
+                            double *sum_400, double *sum_3000,
+                            int nb_channels);
+
+    /**
+     * Apply the combined 4th order K-weighting filter of the ebur128 library
+     * to interleaved samples.
+     *
+     * @param b      numerator coefficients b[0] to b[4]
+     * @param a      denominator coefficients, a[0] is not used
+     * @param state  v[i-1] to v[i-4] of all channels, one nb_channels long
+     *               plane each
+     * @param dst    interleaved filtered output
+     * @param src    interleaved input
+     */
+    void (*filter)(const double *b, const double *a, double *state,
+                   double *dst, const double *src,
+                   int nb_samples, int nb_channels);
+
+    /**
+     * Oversample interleaved samples 4 times with the polyphase interpolator
+     * and raise each channel peak to the largest absolute value found,
+     * input samples included.
+     *
+     * @param peaks  peak of each channel, updated
+     * @param coeffs coefficients from ff_ebur128_true_peak_coeffs()
+     * @param src    input, preceded by EBUR128_TRUE_PEAK_TAPS - 1 samples
+     *               of history
+     */
+    void (*true_peak_4x)(double *peaks, const double *coeffs,
+                         const double *src, int nb_samples, int nb_channels);
+
+    /**
+     * Same as true_peak_4x(), oversampling 2 times.
+     */
+    void (*true_peak_2x)(double *peaks, const double *coeffs,
+                         const double *src, int nb_samples, int nb_channels);
+} EBUR128DSPContext;
+
+/**
+ * Compute the Kaiser windowed sinc interpolator for a given oversampling
+ * factor, EBUR128_TRUE_PEAK_TAPS * factor coefficients, tap-major.
+ */
+void ff_ebur128_true_peak_coeffs(double *coeffs, int factor);
+
+void ff_ebur128_dsp_init(EBUR128DSPContext *dsp);
+void ff_ebur128_dsp_init_x86(EBUR128DSPContext *dsp);
+
+#endif /* AVFILTER_EBUR128DSP_H */
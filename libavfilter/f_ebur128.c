@@ -36,9 +36,9 @@
 #include "libavutil/xga_font_data.h"
 #include "libavutil/opt.h"
 #include "libavutil/timestamp.h"
-#include "libswresample/swresample.h"
 #include "audio.h"
 #include "avfilter.h"
+#include "ebur128dsp.h"
 #include "filters.h"
 #include "formats.h"
 #include "internal.h"
@@ -62,7 +62,7 @@ struct hist_entry {
 };
 
 struct integrator {
-    double **cache;                 ///< window of filtered samples (N ms)
+    double *cache;                  ///< window of filtered samples (N ms), interleaved
     int cache_pos;                  ///< focus on the last added bin in the cache array
     int cache_size;
     double *sum;                    ///< sum of the last N ms filtered samples (cache content)
@@ -83,11 +83,9 @@ typedef struct EBUR128Context {
     double *true_peaks;             ///< true peaks per channel
     double *sample_peaks;           ///< sample peaks per channel
     double *true_peaks_per_frame;   ///< true peaks in a frame per channel
-#if CONFIG_SWRESAMPLE
-    SwrContext *swr_ctx;            ///< over-sampling context for true peak metering
-    double *swr_buf;                ///< resampled audio data for true peak metering
-    int swr_linesize;
-#endif
+    int tp_factor;                  ///< over-sampling factor for true peak metering
+    double tp_coeffs[4 * EBUR128_TRUE_PEAK_TAPS]; ///< true peak interpolator coefficients
+    double *tp_buf;                 ///< interpolator history followed by the frame samples
 
     /* video  */
     int do_video;                   ///< 1 if video output enabled, 0 otherwise
@@ -111,15 +109,11 @@ typedef struct EBUR128Context {
     int idx_insample;               ///< current sample position of processed samples in single input frame
     AVFrame *insamples;             ///< input samples reference, updated regularly
 
-    /* Filter caches.
-     * The mult by 3 in the following is for X[i], X[i-1] and X[i-2] */
-    double *x;                      ///< 3 input samples cache for each channel
-    double *y;                      ///< 3 pre-filter samples cache for each channel
-    double *z;                      ///< 3 RLB-filter samples cache for each channel
-    double pre_b[3];                ///< pre-filter numerator coefficients
-    double pre_a[3];                ///< pre-filter denominator coefficients
-    double rlb_b[3];                ///< rlb-filter numerator coefficients
-    double rlb_a[3];                ///< rlb-filter denominator coefficients
+    /* Filter caches: X[i-1], X[i-2] of the input, Y[i-1], Y[i-2] of the
+     * pre-filter and Z[i-1], Z[i-2] of the RLB-filter, one plane each */
+    double *filter_state;
+    EBUR128Biquad filters[2];       ///< pre-filter and RLB-filter coefficients
+    EBUR128DSPContext dsp;
 
     struct integrator i400;         ///< 400ms integrator, used for Momentary loudness  (M), and Integrated loudness (I)
     struct integrator i3000;        ///<    3s integrator, used for Short term loudness (S), and Loudness Range      (LRA)
@@ -394,28 +388,26 @@ static int config_audio_input(AVFilterLink *inlink)
 
     double a0 = 1.0 + K / Q + K * K;
 
-    ebur128->pre_b[0] = (Vh + Vb * K / Q + K * K) / a0;
-    ebur128->pre_b[1] = 2.0 * (K * K - Vh) / a0;
-    ebur128->pre_b[2] = (Vh - Vb * K / Q + K * K) / a0;
-    ebur128->pre_a[1] = 2.0 * (K * K - 1.0) / a0;
-    ebur128->pre_a[2] = (1.0 - K / Q + K * K) / a0;
+    ebur128->filters[0].b0 = (Vh + Vb * K / Q + K * K) / a0;
+    ebur128->filters[0].b1 = 2.0 * (K * K - Vh) / a0;
+    ebur128->filters[0].b2 = (Vh - Vb * K / Q + K * K) / a0;
+    ebur128->filters[0].a1 = 2.0 * (K * K - 1.0) / a0;
+    ebur128->filters[0].a2 = (1.0 - K / Q + K * K) / a0;
 
     f0 = 38.13547087602444;
     Q = 0.5003270373238773;
     K = tan(M_PI * f0 / (double)inlink->sample_rate);
 
-    ebur128->rlb_b[0] = 1.0;
-    ebur128->rlb_b[1] = -2.0;
-    ebur128->rlb_b[2] = 1.0;
-    ebur128->rlb_a[1] = 2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
-    ebur128->rlb_a[2] = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
+    ebur128->filters[1].b0 = 1.0;
+    ebur128->filters[1].b1 = -2.0;
+    ebur128->filters[1].b2 = 1.0;
+    ebur128->filters[1].a1 = 2.0 * (K * K - 1.0) / (1.0 + K / Q + K * K);
+    ebur128->filters[1].a2 = (1.0 - K / Q + K * K) / (1.0 + K / Q + K * K);
 
     /* Force 100ms framing in case of metadata injection: the frames must have
      * a granularity of the window overlap to be accurately exploited.
-     * As for the true peaks mode, it just simplifies the resampling buffer
-     * allocation and the lookup in it (since sample buffers differ in size, it
-     * can be more complex to integrate in the one-sample loop of
-     * filter_frame()). */
+     * As for the true peaks mode, it just simplifies the interpolation buffer
+     * allocation. */
     if (ebur128->metadata || (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS))
         ebur128->nb_samples = inlink->sample_rate / 10;
     return 0;
@@ -434,20 +426,24 @@ static int config_audio_output(AVFilterLink *outlink)
                    AV_CH_SURROUND_DIRECT_LEFT               |AV_CH_SURROUND_DIRECT_RIGHT)
 
     ebur128->nb_channels  = nb_channels;
-    ebur128->x            = av_calloc(nb_channels, 3 * sizeof(*ebur128->x));
-    ebur128->y            = av_calloc(nb_channels, 3 * sizeof(*ebur128->y));
-    ebur128->z            = av_calloc(nb_channels, 3 * sizeof(*ebur128->z));
+    ebur128->filter_state = av_calloc(nb_channels, 6 * sizeof(*ebur128->filter_state));
     ebur128->ch_weighting = av_calloc(nb_channels, sizeof(*ebur128->ch_weighting));
-    if (!ebur128->ch_weighting || !ebur128->x || !ebur128->y || !ebur128->z)
+    if (!ebur128->ch_weighting || !ebur128->filter_state)
         return AVERROR(ENOMEM);
 
 #define I400_BINS(x)  ((x) * 4 / 10)
 #define I3000_BINS(x) ((x) * 3)
 
-    ebur128->i400.sum = av_calloc(nb_channels, sizeof(*ebur128->i400.sum));
-    ebur128->i3000.sum = av_calloc(nb_channels, sizeof(*ebur128->i3000.sum));
-    ebur128->i400.cache = av_calloc(nb_channels, sizeof(*ebur128->i400.cache));
-    ebur128->i3000.cache = av_calloc(nb_channels, sizeof(*ebur128->i3000.cache));
+    /* bins buffer for the two integration window (400ms and 3s), the
+     * channels of a bin are interleaved so that they are filtered at once */
+    ebur128->i400.cache_size  = I400_BINS(outlink->sample_rate);
+    ebur128->i3000.cache_size = I3000_BINS(outlink->sample_rate);
+    ebur128->i400.sum    = av_calloc(nb_channels, sizeof(*ebur128->i400.sum));
+    ebur128->i3000.sum   = av_calloc(nb_channels, sizeof(*ebur128->i3000.sum));
+    ebur128->i400.cache  = av_calloc(nb_channels * ebur128->i400.cache_size,
+                                     sizeof(*ebur128->i400.cache));
+    ebur128->i3000.cache = av_calloc(nb_channels * ebur128->i3000.cache_size,
+                                     sizeof(*ebur128->i3000.cache));
     if (!ebur128->i400.sum || !ebur128->i3000.sum ||
         !ebur128->i400.cache || !ebur128->i3000.cache)
         return AVERROR(ENOMEM);
@@ -462,44 +458,22 @@ static int config_audio_output(AVFilterLink *outlink)
         } else {
             ebur128->ch_weighting[i] = 1.0;
         }
-
-        if (!ebur128->ch_weighting[i])
-            continue;
-
-        /* bins buffer for the two integration window (400ms and 3s) */
-        ebur128->i400.cache_size = I400_BINS(outlink->sample_rate);
-        ebur128->i3000.cache_size = I3000_BINS(outlink->sample_rate);
-        ebur128->i400.cache[i]  = av_calloc(ebur128->i400.cache_size,  sizeof(*ebur128->i400.cache[0]));
-        ebur128->i3000.cache[i] = av_calloc(ebur128->i3000.cache_size, sizeof(*ebur128->i3000.cache[0]));
-        if (!ebur128->i400.cache[i] || !ebur128->i3000.cache[i])
-            return AVERROR(ENOMEM);
     }
 
-#if CONFIG_SWRESAMPLE
     if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS) {
-        int ret;
+        /* over-sample to at least 192kHz, the input frames are 100ms long */
+        ebur128->tp_factor = outlink->sample_rate <  96000 ? 4 :
+                             outlink->sample_rate < 192000 ? 2 : 1;
+        ff_ebur128_true_peak_coeffs(ebur128->tp_coeffs, ebur128->tp_factor);
 
-        ebur128->swr_buf    = av_malloc_array(nb_channels, 19200 * sizeof(double));
+        ebur128->tp_buf     = av_calloc(nb_channels, (EBUR128_TRUE_PEAK_TAPS - 1 +
+                                                      ebur128->nb_samples) * sizeof(*ebur128->tp_buf));
         ebur128->true_peaks = av_calloc(nb_channels, sizeof(*ebur128->true_peaks));
         ebur128->true_peaks_per_frame = av_calloc(nb_channels, sizeof(*ebur128->true_peaks_per_frame));
-        ebur128->swr_ctx    = swr_alloc();
-        if (!ebur128->swr_buf || !ebur128->true_peaks ||
-            !ebur128->true_peaks_per_frame || !ebur128->swr_ctx)
+        if (!ebur128->tp_buf || !ebur128->true_peaks ||
+            !ebur128->true_peaks_per_frame)
             return AVERROR(ENOMEM);
-
-        av_opt_set_chlayout(ebur128->swr_ctx, "in_ch_layout",   &outlink->ch_layout, 0);
-        av_opt_set_int(ebur128->swr_ctx, "in_sample_rate",       outlink->sample_rate, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "in_sample_fmt", outlink->format, 0);
-
-        av_opt_set_chlayout(ebur128->swr_ctx, "out_ch_layout",   &outlink->ch_layout, 0);
-        av_opt_set_int(ebur128->swr_ctx, "out_sample_rate",       192000, 0);
-        av_opt_set_sample_fmt(ebur128->swr_ctx, "out_sample_fmt", outlink->format, 0);
-
-        ret = swr_init(ebur128->swr_ctx);
-        if (ret < 0)
-            return ret;
     }
-#endif
 
     if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS) {
         ebur128->sample_peaks = av_calloc(nb_channels, sizeof(*ebur128->sample_peaks));
@@ -542,12 +516,6 @@ static av_cold int init(AVFilterContext *ctx)
             ebur128->loglevel = AV_LOG_INFO;
     }
 
-    if (!CONFIG_SWRESAMPLE && (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS)) {
-        av_log(ctx, AV_LOG_ERROR,
-               "True-peak mode requires libswresample to be performed\n");
-        return AVERROR(EINVAL);
-    }
-
     // if meter is  +9 scale, scale range is from -18 LU to  +9 LU (or 3*9)
     // if meter is +18 scale, scale range is from -36 LU to +18 LU (or 3*18)
     ebur128->scale_range = 3 * ebur128->meter;
@@ -560,6 +528,8 @@ static av_cold int init(AVFilterContext *ctx)
     ebur128->integrated_loudness = ABS_THRES;
     ebur128->loudness_range = 0;
 
+    ff_ebur128_dsp_init(&ebur128->dsp);
+
     /* insert output pads */
     if (ebur128->do_video) {
         pad = (AVFilterPad){
@@ -623,25 +593,33 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
     const double *samples = (double *)insamples->data[0];
     AVFrame *pic = ebur128->outpicref;
 
-#if CONFIG_SWRESAMPLE
     if (ebur128->peak_mode & PEAK_MODE_TRUE_PEAKS && ebur128->idx_insample == 0) {
-        const double *swr_samples = ebur128->swr_buf;
-        int ret = swr_convert(ebur128->swr_ctx, (uint8_t**)&ebur128->swr_buf, 19200,
-                              (const uint8_t **)insamples->data, nb_samples);
-        if (ret < 0)
-            return ret;
+        const int history = (EBUR128_TRUE_PEAK_TAPS - 1) * nb_channels;
+        double *tp_peaks = ebur128->true_peaks_per_frame;
+
         for (ch = 0; ch < nb_channels; ch++)
-            ebur128->true_peaks_per_frame[ch] = 0.0;
-        for (idx_insample = 0; idx_insample < ret; idx_insample++) {
-            for (ch = 0; ch < nb_channels; ch++) {
-                ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], fabs(*swr_samples));
-                ebur128->true_peaks_per_frame[ch] = FFMAX(ebur128->true_peaks_per_frame[ch],
-                                                          fabs(*swr_samples));
-                swr_samples++;
-            }
+            tp_peaks[ch] = 0.0;
+
+        if (ebur128->tp_factor == 1) {
+            for (idx_insample = 0; idx_insample < nb_samples; idx_insample++)
+                for (ch = 0; ch < nb_channels; ch++)
+                    tp_peaks[ch] = FFMAX(tp_peaks[ch], fabs(samples[idx_insample * nb_channels + ch]));
+        } else {
+            memcpy(ebur128->tp_buf + history, samples,
+                   nb_samples * nb_channels * sizeof(*samples));
+            if (ebur128->tp_factor == 4)
+                ebur128->dsp.true_peak_4x(tp_peaks, ebur128->tp_coeffs,
+                                          ebur128->tp_buf, nb_samples, nb_channels);
+            else
+                ebur128->dsp.true_peak_2x(tp_peaks, ebur128->tp_coeffs,
+                                          ebur128->tp_buf, nb_samples, nb_channels);
+            memmove(ebur128->tp_buf, ebur128->tp_buf + nb_samples * nb_channels,
+                    history * sizeof(*ebur128->tp_buf));
         }
+
+        for (ch = 0; ch < nb_channels; ch++)
+            ebur128->true_peaks[ch] = FFMAX(ebur128->true_peaks[ch], tp_peaks[ch]);
     }
-#endif
 
     for (idx_insample = ebur128->idx_insample; idx_insample < nb_samples; idx_insample++) {
         const int bin_id_400  = ebur128->i400.cache_pos;
@@ -659,44 +637,15 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *insamples)
         MOVE_TO_NEXT_CACHED_ENTRY(400);
         MOVE_TO_NEXT_CACHED_ENTRY(3000);
 
-        for (ch = 0; ch < nb_channels; ch++) {
-            double bin;
-
-            if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS)
+        if (ebur128->peak_mode & PEAK_MODE_SAMPLES_PEAKS)
+            for (ch = 0; ch < nb_channels; ch++)
                 ebur128->sample_peaks[ch] = FFMAX(ebur128->sample_peaks[ch], fabs(samples[idx_insample * nb_channels + ch]));
 
-            ebur128->x[ch * 3] = samples[idx_insample * nb_channels + ch]; // set X[i]
-
-            if (!ebur128->ch_weighting[ch])
-                continue;
-
-            /* Y[i] = X[i]*b0 + X[i-1]*b1 + X[i-2]*b2 - Y[i-1]*a1 - Y[i-2]*a2 */
-#define FILTER(Y, X, NUM, DEN) do {                                             \
-            double *dst = ebur128->Y + ch*3;                                    \
-            double *src = ebur128->X + ch*3;                                    \
-            dst[2] = dst[1];                                                    \
-            dst[1] = dst[0];                                                    \
-            dst[0] = src[0]*NUM[0] + src[1]*NUM[1] + src[2]*NUM[2]              \
-                                   - dst[1]*DEN[1] - dst[2]*DEN[2];             \
-} while (0)
-
-            // TODO: merge both filters in one?
-            FILTER(y, x, ebur128->pre_b, ebur128->pre_a);  // apply pre-filter
-            ebur128->x[ch * 3 + 2] = ebur128->x[ch * 3 + 1];
-            ebur128->x[ch * 3 + 1] = ebur128->x[ch * 3    ];
-            FILTER(z, y, ebur128->rlb_b, ebur128->rlb_a);  // apply RLB-filter
-
-            bin = ebur128->z[ch * 3] * ebur128->z[ch * 3];
-
-            /* add the new value, and limit the sum to the cache size (400ms or 3s)
-             * by removing the oldest one */
-            ebur128->i400.sum [ch] = ebur128->i400.sum [ch] + bin - ebur128->i400.cache [ch][bin_id_400];
-            ebur128->i3000.sum[ch] = ebur128->i3000.sum[ch] + bin - ebur128->i3000.cache[ch][bin_id_3000];
-
-            /* override old cache entry with the new value */
-            ebur128->i400.cache [ch][bin_id_400 ] = bin;
-            ebur128->i3000.cache[ch][bin_id_3000] = bin;
-        }
+        ebur128->dsp.filter_channels(ebur128->filters, ebur128->filter_state,
+                                     samples + idx_insample * nb_channels,
+                                     ebur128->i400.cache  + bin_id_400  * nb_channels,
+                                     ebur128->i3000.cache + bin_id_3000 * nb_channels,
+                                     ebur128->i400.sum, ebur128->i3000.sum, nb_channels);
 
         /* For integrated loudness, gating blocks are 400ms long with 75%
          * overlap (see BS.1770-2 p5), so a re-computation is needed each 100ms
@@ -1013,7 +962,6 @@ static int query_formats(AVFilterContext *ctx)
 
 static av_cold void uninit(AVFilterContext *ctx)
 {
-    int i;
     EBUR128Context *ebur128 = ctx->priv;
 
     /* dual-mono correction */
@@ -1055,9 +1003,7 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_log(ctx, AV_LOG_INFO, "\n");
 
     av_freep(&ebur128->y_line_ref);
-    av_freep(&ebur128->x);
-    av_freep(&ebur128->y);
-    av_freep(&ebur128->z);
+    av_freep(&ebur128->filter_state);
     av_freep(&ebur128->ch_weighting);
     av_freep(&ebur128->true_peaks);
     av_freep(&ebur128->sample_peaks);
@@ -1066,19 +1012,10 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_freep(&ebur128->i3000.sum);
     av_freep(&ebur128->i400.histogram);
     av_freep(&ebur128->i3000.histogram);
-    for (i = 0; i < ebur128->nb_channels; i++) {
-        if (ebur128->i400.cache)
-            av_freep(&ebur128->i400.cache[i]);
-        if (ebur128->i3000.cache)
-            av_freep(&ebur128->i3000.cache[i]);
-    }
     av_freep(&ebur128->i400.cache);
     av_freep(&ebur128->i3000.cache);
+    av_freep(&ebur128->tp_buf);
     av_frame_free(&ebur128->outpicref);
-#if CONFIG_SWRESAMPLE
-    av_freep(&ebur128->swr_buf);
-    swr_free(&ebur128->swr_ctx);
-#endif
 }
 
 static const AVFilterPad ebur128_inputs[] = {
@@ -19,6 +19,8 @@
  */
 
 #include "libavutil/common.h"
+#include "libavutil/internal.h"
+#include "internal.h"
 #include "motion_estimation.h"
 
 static const int8_t sqr1[8][2]  = {{ 0,-1}, { 0, 1}, {-1, 0}, { 1, 0}, {-1,-1}, {-1, 1}, { 1,-1}, { 1, 1}};
@@ -46,6 +48,8 @@ if (x >= x_min && x <= x_max && y >= y_min && y <= y_max)\
 void ff_me_init_context(AVMotionEstContext *me_ctx, int mb_size, int search_param,
                         int width, int height, int x_min, int x_max, int y_min, int y_max)
 {
+    int i;
+
     me_ctx->width = width;
     me_ctx->height = height;
     me_ctx->mb_size = mb_size;
@@ -55,26 +59,123 @@ void ff_me_init_context(AVMotionEstContext *me_ctx, int mb_size, int search_para
     me_ctx->x_max = x_max;
     me_ctx->y_min = y_min;
     me_ctx->y_max = y_max;
+
+    for (i = 0; i < FF_ARRAY_ELEMS(me_ctx->sad); i++)
+        me_ctx->sad[i] = av_pixelutils_get_sad_fn(i + 1, i + 1, 0, NULL);
 }
 
-uint64_t ff_me_cmp_sad(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int x_mv, int y_mv)
+uint64_t ff_me_block_sad(const AVMotionEstContext *me_ctx,
+                         const uint8_t *src1, const uint8_t *src2, int size)
 {
     const int linesize = me_ctx->linesize;
-    uint8_t *data_ref = me_ctx->data_ref;
-    uint8_t *data_cur = me_ctx->data_cur;
+    const int n = av_log2(size);
     uint64_t sad = 0;
     int i, j;
 
-    data_ref += y_mv * linesize;
-    data_cur += y_mb * linesize;
+    if (size == 1 << n && n >= 1 && n <= FF_ARRAY_ELEMS(me_ctx->sad) && me_ctx->sad[n - 1])
+        return me_ctx->sad[n - 1](src1, linesize, src2, linesize);
 
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sad += FFABS(data_ref[x_mv + i + j * linesize] - data_cur[x_mb + i + j * linesize]);
+    for (j = 0; j < size; j++)
+        for (i = 0; i < size; i++)
+            sad += FFABS(src1[i + j * linesize] - src2[i + j * linesize]);
 
     return sad;
 }
 
+uint64_t ff_me_cmp_sad(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int x_mv, int y_mv)
+{
+    const int linesize = me_ctx->linesize;
+
+    return ff_me_block_sad(me_ctx, me_ctx->data_ref + x_mv + y_mv * linesize,
+                                   me_ctx->data_cur + x_mb + y_mb * linesize, me_ctx->mb_size);
+}
+
+typedef struct SearchThreadData {
+    AVMotionEstContext *me_ctx;
+    int b_width, b_height;
+    int diag;
+    void (*search_block)(AVMotionEstContext *me_ctx, void *opaque, int mb_x, int mb_y);
+    void *opaque;
+    int pred[2];
+} SearchThreadData;
+
+static int search_blocks_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SearchThreadData *td = arg;
+    AVMotionEstContext me_ctx = *td->me_ctx;
+    int mb_x, mb_y, last;
+
+    if (td->diag < 0) {
+        const int slice_start = (td->b_height *  jobnr   ) / nb_jobs;
+        const int slice_end   = (td->b_height * (jobnr+1)) / nb_jobs;
+
+        for (mb_y = slice_start; mb_y < slice_end; mb_y++)
+            for (mb_x = 0; mb_x < td->b_width; mb_x++)
+                td->search_block(&me_ctx, td->opaque, mb_x, mb_y);
+
+        last = slice_end == td->b_height;
+    } else {
+        /* the blocks with mb_x + 2 * mb_y == diag, all the neighbours used
+         * as predictors of which lie on earlier diagonals */
+        const int y_min = FFMAX(td->diag - td->b_width + 2, 0) / 2;
+        const int y_max = FFMIN(td->diag / 2, td->b_height - 1);
+        const int slice_start = y_min + ((y_max - y_min + 1) *  jobnr   ) / nb_jobs;
+        const int slice_end   = y_min + ((y_max - y_min + 1) * (jobnr+1)) / nb_jobs;
+
+        for (mb_y = slice_start; mb_y < slice_end; mb_y++)
+            td->search_block(&me_ctx, td->opaque, td->diag - 2 * mb_y, mb_y);
+
+        last = td->diag == td->b_width - 1 + 2 * (td->b_height - 1);
+    }
+    emms_c();
+
+    if (last) {
+        td->pred[0] = me_ctx.pred_x;
+        td->pred[1] = me_ctx.pred_y;
+    }
+
+    return 0;
+}
+
+int ff_me_search_blocks(AVFilterContext *ctx, AVMotionEstContext *me_ctx,
+                        int b_width, int b_height, int wavefront,
+                        void (*search_block)(AVMotionEstContext *me_ctx, void *opaque, int mb_x, int mb_y),
+                        void *opaque)
+{
+    const int nb_threads = ff_filter_get_nb_threads(ctx);
+    SearchThreadData td;
+
+    if (b_width <= 0 || b_height <= 0)
+        return 0;
+
+    td.me_ctx       = me_ctx;
+    td.b_width      = b_width;
+    td.b_height     = b_height;
+    td.search_block = search_block;
+    td.opaque       = opaque;
+    td.pred[0]      = me_ctx->pred_x;
+    td.pred[1]      = me_ctx->pred_y;
+
+    if (!wavefront || nb_threads == 1) {
+        td.diag = -1;
+        ff_filter_execute(ctx, search_blocks_slice, &td, NULL,
+                          FFMIN(b_height, nb_threads));
+    } else {
+        for (td.diag = 0; td.diag < b_width + 2 * (b_height - 1); td.diag++) {
+            const int y_min = FFMAX(td.diag - b_width + 2, 0) / 2;
+            const int y_max = FFMIN(td.diag / 2, b_height - 1);
+
+            ff_filter_execute(ctx, search_blocks_slice, &td, NULL,
+                              FFMIN(y_max - y_min + 1, nb_threads));
+        }
+    }
+
+    me_ctx->pred_x = td.pred[0];
+    me_ctx->pred_y = td.pred[1];
+
+    return 0;
+}
+
 uint64_t ff_me_search_esa(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int *mv)
 {
     int x, y;
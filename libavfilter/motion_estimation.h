@@ -23,6 +23,10 @@
 
 #include <stdint.h>
 
+#include "libavutil/pixelutils.h"
+
+struct AVFilterContext;
+
 #define AV_ME_METHOD_ESA        1
 #define AV_ME_METHOD_TSS        2
 #define AV_ME_METHOD_TDLS       3
@@ -57,6 +61,12 @@ typedef struct AVMotionEstContext {
     int pred_y;     ///< median predictor y
     AVMotionEstPredictor preds[2];
 
+    /**
+     * SAD of square blocks from 2x2 to 32x32, indexed by log2 of the block
+     * size minus one; an entry is NULL if no function is available.
+     */
+    av_pixelutils_sad_fn sad[5];
+
     uint64_t (*get_cost)(struct AVMotionEstContext *me_ctx, int x_mb, int y_mb,
                          int mv_x, int mv_y);
 } AVMotionEstContext;
@@ -64,8 +74,30 @@ typedef struct AVMotionEstContext {
 void ff_me_init_context(AVMotionEstContext *me_ctx, int mb_size, int search_param,
                         int width, int height, int x_min, int x_max, int y_min, int y_max);
 
+/**
+ * Compute the SAD of two size x size blocks, both using me_ctx->linesize.
+ */
+uint64_t ff_me_block_sad(const AVMotionEstContext *me_ctx,
+                         const uint8_t *src1, const uint8_t *src2, int size);
+
 uint64_t ff_me_cmp_sad(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int x_mv, int y_mv);
 
+/**
+ * Search a b_width x b_height grid of blocks with slice threading.
+ *
+ * search_block() is called once per block with a copy of me_ctx private to
+ * the calling job, so it may change the predictors. If wavefront is set, the
+ * left, top-left, top and top-right neighbours of a block are searched before
+ * the block itself, as the predictive methods require. The predictor left by
+ * the last block is copied back to me_ctx, as a serial search would leave it.
+ *
+ * @return 0 on success, a negative AVERROR on error
+ */
+int ff_me_search_blocks(struct AVFilterContext *ctx, AVMotionEstContext *me_ctx,
+                        int b_width, int b_height, int wavefront,
+                        void (*search_block)(AVMotionEstContext *me_ctx, void *opaque, int mb_x, int mb_y),
+                        void *opaque);
+
 uint64_t ff_me_search_esa(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int *mv);
 
 uint64_t ff_me_search_tss(AVMotionEstContext *me_ctx, int x_mb, int y_mb, int *mv);
@@ -0,0 +1,43 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVFILTER_PALETTEUSE_H
+#define AVFILTER_PALETTEUSE_H
+
+#include <stdint.h>
+
+typedef struct PaletteUseDSPContext {
+    /**
+     * Brute-force search of the 256 entries palette entry nearest to a color.
+     *
+     * @param pal_rg red and green of each entry, interleaved
+     * @param pal_ba blue and alpha of each entry, interleaved
+     * @param skip   INT_MAX for the entries to ignore, 0 for the others
+     * @param rg     red | green << 16 of the color
+     * @param ba     blue | alpha << 16 of the color
+     * @return squared distance << 8 | index of the nearest entry, the lowest
+     *         index among equally near entries, INT_MAX if all are ignored
+     */
+    int (*nearest)(const int16_t *pal_rg, const int16_t *pal_ba,
+                   const int32_t *skip, int rg, int ba);
+} PaletteUseDSPContext;
+
+void ff_paletteuse_init(PaletteUseDSPContext *dsp);
+void ff_paletteuse_init_x86(PaletteUseDSPContext *dsp);
+
+#endif /* AVFILTER_PALETTEUSE_H */
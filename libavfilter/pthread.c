@@ -24,6 +24,8 @@
 #include <stddef.h>
 
 #include "libavutil/error.h"
+#include "libavutil/executor.h"
+#include "libavutil/log.h"
 #include "libavutil/macros.h"
 #include "libavutil/mem.h"
 #include "libavutil/slicethread.h"
@@ -35,14 +37,22 @@
 typedef struct ThreadContext {
     AVFilterGraph *graph;
     AVSliceThread *thread;
+    AVExecutor    *executor;
     avfilter_action_func *func;
 
     /* per-execute parameters */
     AVFilterContext *ctx;
     void *arg;
     int   *rets;
+    int    nb_jobs;
 } ThreadContext;
 
+static int executor_func(void *priv, int jobnr, int threadnr)
+{
+    ThreadContext *c = priv;
+    return c->func(c->ctx, c->arg, jobnr, c->nb_jobs);
+}
+
 static void worker_func(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
 {
     ThreadContext *c = priv;
@@ -67,8 +77,12 @@ static int thread_execute(AVFilterContext *ctx, avfilter_action_func *func,
     c->arg         = arg;
     c->func        = func;
     c->rets        = ret;
+    c->nb_jobs     = nb_jobs;
 
-    avpriv_slicethread_execute(c->thread, nb_jobs, 0);
+    if (c->executor)
+        av_executor_execute(c->executor, executor_func, c, ret, nb_jobs, ctx->graph->nb_threads);
+    else
+        avpriv_slicethread_execute(c->thread, nb_jobs, 0);
     return 0;
 }
 
@@ -80,10 +94,46 @@ static int thread_init_internal(ThreadContext *c, int nb_threads)
     return FFMAX(nb_threads, 1);
 }
 
+static int executor_init_internal(ThreadContext *c, AVExecutor *executor, int nb_threads)
+{
+    int nb_pool_threads = av_executor_get_nb_threads(executor) + 1;
+
+    c->executor = executor;
+    return nb_threads ? FFMIN(nb_threads, nb_pool_threads) : nb_pool_threads;
+}
+
+static int thread_set_params(AVFilterGraph *graph)
+{
+    ThreadContext *c = graph->internal->thread;
+    int ret;
+
+    if (graph->thread_nice &&
+        avpriv_slicethread_set_priority(c->thread, graph->thread_nice) < 0)
+        av_log(graph, AV_LOG_WARNING, "Changing the thread priority is not supported on this platform.\n");
+
+    if (!graph->thread_affinity || !*graph->thread_affinity)
+        return 0;
+
+    ret = avpriv_slicethread_set_affinity(c->thread, graph->thread_affinity, 1);
+    if (ret == AVERROR(ENOSYS)) {
+        av_log(graph, AV_LOG_WARNING, "Thread affinity is not supported on this platform.\n");
+        return 0;
+    }
+    return ret;
+}
+
 int ff_graph_thread_init(AVFilterGraph *graph)
 {
     int ret;
 
+    if (graph->thread_affinity && *graph->thread_affinity) {
+        ret = avpriv_thread_check_affinity(graph->thread_affinity);
+        if (ret < 0) {
+            av_log(graph, AV_LOG_ERROR, "Invalid CPU list '%s'.\n", graph->thread_affinity);
+            return ret;
+        }
+    }
+
     if (graph->nb_threads == 1) {
         graph->thread_type = 0;
         return 0;
@@ -93,7 +143,11 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     if (!graph->internal->thread)
         return AVERROR(ENOMEM);
 
-    ret = thread_init_internal(graph->internal->thread, graph->nb_threads);
+    if (graph->executor)
+        ret = executor_init_internal(graph->internal->thread, graph->executor,
+                                     graph->nb_threads);
+    else
+        ret = thread_init_internal(graph->internal->thread, graph->nb_threads);
     if (ret <= 1) {
         av_freep(&graph->internal->thread);
         graph->thread_type = 0;
@@ -102,6 +156,14 @@ int ff_graph_thread_init(AVFilterGraph *graph)
     }
     graph->nb_threads = ret;
 
+    if (!graph->executor) {
+        ret = thread_set_params(graph);
+        if (ret < 0) {
+            ff_graph_thread_free(graph);
+            return ret;
+        }
+    }
+
     graph->internal->thread_execute = thread_execute;
 
     return 0;
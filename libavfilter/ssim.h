@@ -31,6 +31,14 @@ typedef struct SSIMDSPContext {
     double (*ssim_end_line)(const int (*sum0)[4], const int (*sum1)[4], int w);
 } SSIMDSPContext;
 
+void ff_ssim_init(SSIMDSPContext *dsp);
 void ff_ssim_init_x86(SSIMDSPContext *dsp);
 
+/* High bit depth versions, the sums do not fit in 32 bits. */
+void ff_ssim_4x4xn_16bit(const uint8_t *main8, ptrdiff_t main_stride,
+                         const uint8_t *ref8, ptrdiff_t ref_stride,
+                         int64_t (*sums)[4], int width);
+float ff_ssim_endn_16bit(const int64_t (*sum0)[4], const int64_t (*sum1)[4],
+                         int width, int max);
+
 #endif /* AVFILTER_SSIM_H */
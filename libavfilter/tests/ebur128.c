@@ -0,0 +1,145 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Check the true peak measurement against sines of known amplitude. The
+ * interpolator outputs points at 1/(2 * factor) + p / factor of a sample
+ * period after each input sample, for each phase p, in addition to the
+ * input samples themselves. The reading must be within the tolerance of
+ * the largest value of the sine at those points.
+ */
+
+#include <math.h>
+#include <stdio.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem.h"
+#include "libavfilter/ebur128.h"
+
+#define AMPLITUDE    0.5
+#define TOLERANCE_DB 0.1
+#define NB_PHASES    8
+#define DURATION_MS  500
+#define FADE_MS      50
+#define CHUNK        1024
+
+static const struct {
+    int rate, factor;
+    int freqs[8];
+} tests[] = {
+    { 48000, 4, { 997, 5000, 10000, 12000, 15000, 17000, 18000, 19000 } },
+    { 44100, 4, { 997, 5000, 10000, 12000, 15000, 16000, 17000, 17500 } },
+    { 96000, 2, { 997, 5000, 10000, 20000, 25000, 30000, 32000, 34000 } },
+};
+
+static double *gen_sines(int rate, const int *freqs, int nb_freqs,
+                         double phase, int nb_samples)
+{
+    double *buf = av_malloc_array(nb_samples, nb_freqs * sizeof(*buf));
+    const int fade = rate * FADE_MS / 1000;
+
+    if (!buf)
+        return NULL;
+
+    /* fade in, so that the onset does not ring above the amplitude */
+    for (int n = 0; n < nb_samples; n++) {
+        const double gain = n < fade ? 0.5 - 0.5 * cos(M_PI * n / fade) : 1.0;
+
+        for (int i = 0; i < nb_freqs; i++)
+            buf[n * nb_freqs + i] = gain * AMPLITUDE *
+                                    sin(2.0 * M_PI * freqs[i] * n / rate + phase);
+    }
+    return buf;
+}
+
+/* largest value of the sine at the points the interpolator computes */
+static double ideal_peak(int rate, int factor, int freq, double phase, int nb_samples)
+{
+    const int fade = rate * FADE_MS / 1000;
+    double peak = 0.0;
+
+    for (int n = fade; n < nb_samples; n++) {
+        peak = FFMAX(peak, fabs(sin(2.0 * M_PI * freq * n / rate + phase)));
+        for (int p = 0; p < factor; p++) {
+            const double t = n + (0.5 + p) / factor;
+            peak = FFMAX(peak, fabs(sin(2.0 * M_PI * freq * t / rate + phase)));
+        }
+    }
+    return AMPLITUDE * peak;
+}
+
+int main(void)
+{
+    int ret = 0;
+
+    for (int t = 0; t < FF_ARRAY_ELEMS(tests); t++) {
+        const int rate       = tests[t].rate;
+        const int nb_freqs   = FF_ARRAY_ELEMS(tests[t].freqs);
+        const int nb_samples = rate * DURATION_MS / 1000;
+        double err_db[FF_ARRAY_ELEMS(tests[t].freqs)] = { 0 };
+
+        for (int p = 0; p < NB_PHASES; p++) {
+            FFEBUR128State *st;
+            double *buf;
+
+            st  = ff_ebur128_init(nb_freqs, rate, 0, FF_EBUR128_MODE_M |
+                                                     FF_EBUR128_MODE_TRUE_PEAK);
+            buf = gen_sines(rate, tests[t].freqs, nb_freqs,
+                            M_PI * p / NB_PHASES, nb_samples);
+            if (!st || !buf) {
+                if (st)
+                    ff_ebur128_destroy(&st);
+                av_free(buf);
+                return 1;
+            }
+
+            for (int n = 0; n < nb_samples; n += CHUNK)
+                ff_ebur128_add_frames_double(st, buf + n * nb_freqs,
+                                             FFMIN(CHUNK, nb_samples - n));
+
+            for (int i = 0; i < nb_freqs; i++) {
+                const double ideal = ideal_peak(rate, tests[t].factor, tests[t].freqs[i],
+                                                M_PI * p / NB_PHASES, nb_samples);
+                double peak, err;
+
+                ff_ebur128_true_peak(st, i, &peak);
+                err = 20.0 * log10(peak / ideal);
+                if (fabs(err) > fabs(err_db[i]))
+                    err_db[i] = err;
+            }
+
+            ff_ebur128_destroy(&st);
+            av_free(buf);
+        }
+
+        for (int i = 0; i < nb_freqs; i++) {
+            const int ok = fabs(err_db[i]) <= TOLERANCE_DB;
+
+            printf("%d Hz at %d Hz: %s\n", tests[t].freqs[i], rate,
+                   ok ? "ok" : "out of range");
+            if (!ok) {
+                fprintf(stderr, "%d Hz at %d Hz: %+.3f dB from the ideal reading\n",
+                        tests[t].freqs[i], rate, err_db[i]);
+                ret = 1;
+            }
+        }
+    }
+
+    return ret;
+}
@@ -126,7 +126,7 @@ int ff_affine_transform(const uint8_t *src, uint8_t *dst,
                         int src_stride, int dst_stride,
                         int width, int height, const float *matrix,
                         enum InterpolateMethod interpolate,
-                        enum FillMethod fill)
+                        enum FillMethod fill, int slice_start, int slice_end)
 {
     int x, y;
     float x_s, y_s;
@@ -147,7 +147,7 @@ int ff_affine_transform(const uint8_t *src, uint8_t *dst,
             return AVERROR(EINVAL);
     }
 
-    for (y = 0; y < height; y++) {
+    for (y = slice_start; y < slice_end; y++) {
         for(x = 0; x < width; x++) {
             x_s = x * matrix[0] + y * matrix[1] + matrix[2];
             y_s = x * matrix[3] + y * matrix[4] + matrix[5];
@@ -86,7 +86,8 @@ void ff_get_matrix(
 /**
  * Do an affine transformation with the given interpolation method. This
  * multiplies each vector [x,y,1] by the matrix and then interpolates to
- * get the final value.
+ * get the final value. Only the destination rows from slice_start to
+ * slice_end are written, so that slices can be transformed in parallel.
  *
  * @param src         source image
  * @param dst         destination image
@@ -97,12 +98,14 @@ void ff_get_matrix(
  * @param matrix      9-item affine transformation matrix
  * @param interpolate pixel interpolation method
  * @param fill        edge fill method
+ * @param slice_start first destination row to write
+ * @param slice_end   row after the last destination row to write
  * @return negative on error
  */
 int ff_affine_transform(const uint8_t *src, uint8_t *dst,
                         int src_stride, int dst_stride,
                         int width, int height, const float *matrix,
                         enum InterpolateMethod interpolate,
-                        enum FillMethod fill);
+                        enum FillMethod fill, int slice_start, int slice_end);
 
 #endif /* AVFILTER_TRANSFORM_H */
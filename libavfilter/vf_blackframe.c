@@ -44,6 +44,8 @@ typedef struct BlackFrameContext {
     unsigned int frame;   ///< frame number
     unsigned int nblack;  ///< number of black pixels counted so far
     unsigned int last_keyframe; ///< frame number of the last received key-frame
+    int nb_threads;
+    unsigned int *counter;      ///< number of black pixels counted by each job
 } BlackFrameContext;
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -56,21 +58,56 @@ static const enum AVPixelFormat pix_fmts[] = {
     snprintf(buf, sizeof(buf), format, value);  \
     av_dict_set(metadata, key, buf, 0)
 
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    BlackFrameContext *s = ctx->priv;
+
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->counter = av_calloc(s->nb_threads, sizeof(*s->counter));
+    if (!s->counter)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
+static int black_counter(AVFilterContext *ctx, void *arg,
+                         int jobnr, int nb_jobs)
+{
+    BlackFrameContext *s = ctx->priv;
+    const unsigned int threshold = s->bthresh;
+    AVFrame *frame = arg;
+    const int linesize = frame->linesize[0];
+    const int w = frame->width;
+    const int start = (frame->height * jobnr) / nb_jobs;
+    const int end = (frame->height * (jobnr+1)) / nb_jobs;
+    const uint8_t *p = frame->data[0] + start * linesize;
+    unsigned int counter = 0;
+
+    for (int i = start; i < end; i++) {
+        for (int x = 0; x < w; x++)
+            counter += p[x] < threshold;
+        p += linesize;
+    }
+
+    s->counter[jobnr] = counter;
+
+    return 0;
+}
+
 static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
     AVFilterContext *ctx = inlink->dst;
     BlackFrameContext *s = ctx->priv;
-    int x, i;
+    const int nb_jobs = FFMIN(frame->height, s->nb_threads);
     int pblack = 0;
-    uint8_t *p = frame->data[0];
     AVDictionary **metadata;
     char buf[32];
 
-    for (i = 0; i < frame->height; i++) {
-        for (x = 0; x < inlink->w; x++)
-            s->nblack += p[x] < s->bthresh;
-        p += frame->linesize[0];
-    }
+    ff_filter_execute(ctx, black_counter, frame, NULL, nb_jobs);
+
+    for (int i = 0; i < nb_jobs; i++)
+        s->nblack += s->counter[i];
 
     if (frame->key_frame)
         s->last_keyframe = s->frame;
@@ -93,6 +130,13 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
     return ff_filter_frame(inlink->dst->outputs[0], frame);
 }
 
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    BlackFrameContext *s = ctx->priv;
+
+    av_freep(&s->counter);
+}
+
 #define OFFSET(x) offsetof(BlackFrameContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 static const AVOption blackframe_options[] = {
@@ -111,6 +155,7 @@ static const AVFilterPad avfilter_vf_blackframe_inputs[] = {
     {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
         .filter_frame = filter_frame,
     },
 };
@@ -127,7 +172,8 @@ const AVFilter ff_vf_blackframe = {
     .description   = NULL_IF_CONFIG_SMALL("Detect frames that are (almost) black."),
     .priv_size     = sizeof(BlackFrameContext),
     .priv_class    = &blackframe_class,
-    .flags         = AVFILTER_FLAG_METADATA_ONLY,
+    .uninit        = uninit,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS | AVFILTER_FLAG_METADATA_ONLY,
     FILTER_INPUTS(avfilter_vf_blackframe_inputs),
     FILTER_OUTPUTS(avfilter_vf_blackframe_outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
@@ -42,8 +42,18 @@ typedef struct CropDetectContext {
     int frame_nb;
     int max_pixsteps[4];
     int max_outliers;
+
+    int nb_threads;
+    int *row_avg;               ///< average luma of each row
+    int *col_avg;               ///< average luma of each column
+    int64_t *col_sums;          ///< partial column sums, one line per job
 } CropDetectContext;
 
+typedef struct ThreadData {
+    AVFrame *frame;
+    int start, end;             ///< range of rows or columns to analyse
+} ThreadData;
+
 static const enum AVPixelFormat pix_fmts[] = {
     AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUVJ420P,
     AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUVJ422P,
@@ -116,6 +126,90 @@ static int checkline(void *ctx, const unsigned char *src, int stride, int len, i
     return total;
 }
 
+static int analyse_rows(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    CropDetectContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int bpp = s->max_pixsteps[0];
+    const int start = td->start + ((td->end - td->start) *  jobnr   ) / nb_jobs;
+    const int end   = td->start + ((td->end - td->start) * (jobnr+1)) / nb_jobs;
+
+    for (int y = start; y < end; y++)
+        s->row_avg[y] = checkline(ctx, frame->data[0] + frame->linesize[0] * y,
+                                  bpp, frame->width, bpp);
+
+    return 0;
+}
+
+static int analyse_columns(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    CropDetectContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *frame = td->frame;
+    const int bpp = s->max_pixsteps[0];
+    const int slice_start = (frame->height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (frame->height * (jobnr+1)) / nb_jobs;
+    int64_t *sum = s->col_sums + jobnr * frame->width;
+
+    memset(sum + td->start, 0, (td->end - td->start) * sizeof(*sum));
+
+    /* accumulate the columns row by row, for better locality than
+     * walking down each column */
+    for (int y = slice_start; y < slice_end; y++) {
+        const uint8_t *src = frame->data[0] + frame->linesize[0] * y;
+        const uint16_t *src16 = (const uint16_t *)src;
+
+        switch (bpp) {
+        case 1:
+            for (int x = td->start; x < td->end; x++)
+                sum[x] += src[x];
+            break;
+        case 2:
+            for (int x = td->start; x < td->end; x++)
+                sum[x] += src16[x];
+            break;
+        case 3:
+        case 4:
+            for (int x = td->start; x < td->end; x++)
+                sum[x] += src[x * bpp] + src[x * bpp + 1] + src[x * bpp + 2];
+            break;
+        }
+    }
+
+    return 0;
+}
+
+static void analyse_lines(AVFilterContext *ctx, AVFrame *frame,
+                          int columns, int start, int end)
+{
+    CropDetectContext *s = ctx->priv;
+    ThreadData td = { .frame = frame, .start = start, .end = end };
+    int nb_jobs;
+
+    if (start >= end)
+        return;
+
+    if (!columns) {
+        ff_filter_execute(ctx, analyse_rows, &td, NULL,
+                          FFMIN(end - start, s->nb_threads));
+        return;
+    }
+
+    nb_jobs = FFMIN(frame->height, s->nb_threads);
+    ff_filter_execute(ctx, analyse_columns, &td, NULL, nb_jobs);
+
+    for (int x = start; x < end; x++) {
+        const int div = frame->height * (s->max_pixsteps[0] >= 3 ? 3 : 1);
+        int64_t total = 0;
+
+        for (int j = 0; j < nb_jobs; j++)
+            total += s->col_sums[j * frame->width + x];
+        s->col_avg[x] = total / div;
+        av_log(ctx, AV_LOG_DEBUG, "total:%d\n", s->col_avg[x]);
+    }
+}
+
 static av_cold int init(AVFilterContext *ctx)
 {
     CropDetectContext *s = ctx->priv;
@@ -144,6 +238,13 @@ static int config_input(AVFilterLink *inlink)
     s->x2 = 0;
     s->y2 = 0;
 
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->row_avg  = av_calloc(inlink->h, sizeof(*s->row_avg));
+    s->col_avg  = av_calloc(inlink->w, sizeof(*s->col_avg));
+    s->col_sums = av_calloc(inlink->w, s->nb_threads * sizeof(*s->col_sums));
+    if (!s->row_avg || !s->col_avg || !s->col_sums)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -154,8 +255,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
 {
     AVFilterContext *ctx = inlink->dst;
     CropDetectContext *s = ctx->priv;
-    int bpp = s->max_pixsteps[0];
-    int w, h, x, y, shrink_by;
+    int w, h, x, y, shrink_by, prev;
     AVDictionary **metadata;
     int outliers, last_y;
     int limit = lrint(s->limit);
@@ -173,10 +273,10 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
             s->frame_nb = 1;
         }
 
-#define FIND(DST, FROM, NOEND, INC, STEP0, STEP1, LEN) \
+#define FIND(DST, FROM, NOEND, INC, AVG) \
         outliers = 0;\
         for (last_y = y = FROM; NOEND; y = y INC) {\
-            if (checkline(ctx, frame->data[0] + STEP0 * y, STEP1, LEN, bpp) > limit) {\
+            if (AVG[y] > limit) {\
                 if (++outliers > s->max_outliers) { \
                     DST = last_y;\
                     break;\
@@ -185,10 +285,21 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
                 last_y = y INC;\
         }
 
-        FIND(s->y1,                 0,               y < s->y1, +1, frame->linesize[0], bpp, frame->width);
-        FIND(s->y2, frame->height - 1, y > FFMAX(s->y2, s->y1), -1, frame->linesize[0], bpp, frame->width);
-        FIND(s->x1,                 0,               y < s->x1, +1, bpp, frame->linesize[0], frame->height);
-        FIND(s->x2,  frame->width - 1, y > FFMAX(s->x2, s->x1), -1, bpp, frame->linesize[0], frame->height);
+        /* The averages of all the lines each search may reach are computed
+         * in parallel beforehand, in steady state these are the borders the
+         * searches walk through anyway. Lines already computed for the first
+         * search of a direction are reused by the second one. */
+        prev = s->y1;
+        analyse_lines(ctx, frame, 0, 0, s->y1);
+        FIND(s->y1,                 0,               y < s->y1, +1, s->row_avg);
+        analyse_lines(ctx, frame, 0, FFMAX3(s->y2, s->y1, prev - 1) + 1, frame->height);
+        FIND(s->y2, frame->height - 1, y > FFMAX(s->y2, s->y1), -1, s->row_avg);
+
+        prev = s->x1;
+        analyse_lines(ctx, frame, 1, 0, s->x1);
+        FIND(s->x1,                 0,               y < s->x1, +1, s->col_avg);
+        analyse_lines(ctx, frame, 1, FFMAX3(s->x2, s->x1, prev - 1) + 1, frame->width);
+        FIND(s->x2,  frame->width - 1, y > FFMAX(s->x2, s->x1), -1, s->col_avg);
 
 
         // round x and y (up), important for yuv colorspaces
@@ -233,6 +344,15 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
     return ff_filter_frame(inlink->dst->outputs[0], frame);
 }
 
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    CropDetectContext *s = ctx->priv;
+
+    av_freep(&s->row_avg);
+    av_freep(&s->col_avg);
+    av_freep(&s->col_sums);
+}
+
 #define OFFSET(x) offsetof(CropDetectContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 
@@ -270,8 +390,10 @@ const AVFilter ff_vf_cropdetect = {
     .priv_size     = sizeof(CropDetectContext),
     .priv_class    = &cropdetect_class,
     .init          = init,
+    .uninit        = uninit,
     FILTER_INPUTS(avfilter_vf_cropdetect_inputs),
     FILTER_OUTPUTS(avfilter_vf_cropdetect_outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_METADATA_ONLY,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC | AVFILTER_FLAG_METADATA_ONLY |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
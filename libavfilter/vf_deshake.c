@@ -117,17 +117,15 @@ static double clean_mean(double *values, int count)
  * and ry attributes. Searches using a simple matrix of those shifts and
  * chooses the most likely shift by the smallest difference in blocks.
  */
-static void find_block_motion(DeshakeContext *deshake, uint8_t *src1,
-                              uint8_t *src2, int cx, int cy, int stride,
-                              IntMotionVector *mv)
+static void find_block_motion(DeshakeContext *deshake, AVMotionEstContext *me_ctx,
+                              int cx, int cy, IntMotionVector *mv)
 {
     int x, y;
     int diff;
     int smallest = INT_MAX;
     int tmp, tmp2;
 
-    #define CMP(i, j) deshake->sad(src1 + cy  * stride + cx,  stride,\
-                                   src2 + (j) * stride + (i), stride)
+    #define CMP(i, j) me_ctx->get_cost(me_ctx, cx, cy, i, j)
 
     if (deshake->search == EXHAUSTIVE) {
         // Compare every possible position - this is sloooow!
@@ -177,7 +175,6 @@ static void find_block_motion(DeshakeContext *deshake, uint8_t *src1,
         mv->x = -1;
         mv->y = -1;
     }
-    emms_c();
     //av_log(NULL, AV_LOG_ERROR, "%d\n", smallest);
     //av_log(NULL, AV_LOG_ERROR, "Final: (%d, %d) = %d x %d\n", cx, cy, mv->x, mv->y);
 }
@@ -225,6 +222,31 @@ static double block_angle(int x, int y, int cx, int cy, IntMotionVector *shift)
            diff;
 }
 
+typedef struct ThreadData {
+    DeshakeContext *deshake;
+    int b_width;
+} ThreadData;
+
+static void search_block(AVMotionEstContext *me_ctx, void *opaque, int mb_x, int mb_y)
+{
+    ThreadData *td = opaque;
+    DeshakeContext *deshake = td->deshake;
+    const int x = deshake->rx + mb_x * 16;
+    const int y = deshake->ry + mb_y * deshake->blocksize * 2;
+    IntMotionVector *mv = &deshake->block_mvs[mb_x + mb_y * td->b_width];
+
+    // If the contrast is too low, just skip this block as it probably
+    // won't be very useful to us.
+    if (block_contrast(me_ctx->data_ref, x, y, me_ctx->linesize, deshake->blocksize) > deshake->contrast) {
+        mv->x = 0;
+        mv->y = 0;
+        find_block_motion(deshake, me_ctx, x, y, mv);
+    } else {
+        mv->x = -1;
+        mv->y = -1;
+    }
+}
+
 /**
  * Find the estimated global motion for a scene given the most likely shift
  * for each block in the frame. The global motion is estimated to be the
@@ -232,19 +254,29 @@ static double block_angle(int x, int y, int cx, int cy, IntMotionVector *shift)
  * move one pixel to the right and two pixels down, this would yield a
  * motion vector (1, -2).
  */
-static void find_motion(DeshakeContext *deshake, uint8_t *src1, uint8_t *src2,
-                        int width, int height, int stride, Transform *t)
+static int find_motion(AVFilterContext *ctx, uint8_t *src1, uint8_t *src2,
+                       int width, int height, int stride, Transform *t)
 {
-    int x, y;
-    IntMotionVector mv = {0, 0};
+    DeshakeContext *deshake = ctx->priv;
+    ThreadData td;
+    int x, y, mb_x, mb_y;
+    int b_width = 0, b_height = 0;
     int count_max_value = 0;
-    int contrast;
 
     int pos;
     int center_x = 0, center_y = 0;
     double p_x, p_y;
 
+    // We use a width of 16 here to match the sad function
+    for (x = deshake->rx; x < width - deshake->rx - 16; x += 16)
+        b_width++;
+    for (y = deshake->ry; y < height - deshake->ry - (deshake->blocksize * 2); y += deshake->blocksize * 2)
+        b_height++;
+
     av_fast_malloc(&deshake->angles, &deshake->angles_size, width * height / (16 * deshake->blocksize) * sizeof(*deshake->angles));
+    av_fast_malloc(&deshake->block_mvs, &deshake->block_mvs_size, b_width * b_height * sizeof(*deshake->block_mvs));
+    if (!deshake->angles || !deshake->block_mvs)
+        return AVERROR(ENOMEM);
 
     // Reset counts to zero
     for (x = 0; x < deshake->rx * 2 + 1; x++) {
@@ -253,25 +285,29 @@ static void find_motion(DeshakeContext *deshake, uint8_t *src1, uint8_t *src2,
         }
     }
 
+    // Find motion for every block
+    deshake->me_ctx.data_cur = src1;
+    deshake->me_ctx.data_ref = src2;
+    deshake->me_ctx.linesize = stride;
+    td.deshake = deshake;
+    td.b_width = b_width;
+    ff_me_search_blocks(ctx, &deshake->me_ctx, b_width, b_height, 0, search_block, &td);
+
+    // Store the motion vectors in the counts
     pos = 0;
-    // Find motion for every block and store the motion vector in the counts
-    for (y = deshake->ry; y < height - deshake->ry - (deshake->blocksize * 2); y += deshake->blocksize * 2) {
-        // We use a width of 16 here to match the sad function
-        for (x = deshake->rx; x < width - deshake->rx - 16; x += 16) {
-            // If the contrast is too low, just skip this block as it probably
-            // won't be very useful to us.
-            contrast = block_contrast(src2, x, y, stride, deshake->blocksize);
-            if (contrast > deshake->contrast) {
-                //av_log(NULL, AV_LOG_ERROR, "%d\n", contrast);
-                find_block_motion(deshake, src1, src2, x, y, stride, &mv);
-                if (mv.x != -1 && mv.y != -1) {
-                    deshake->counts[mv.x + deshake->rx][mv.y + deshake->ry] += 1;
-                    if (x > deshake->rx && y > deshake->ry)
-                        deshake->angles[pos++] = block_angle(x, y, 0, 0, &mv);
-
-                    center_x += mv.x;
-                    center_y += mv.y;
-                }
+    for (mb_y = 0; mb_y < b_height; mb_y++) {
+        for (mb_x = 0; mb_x < b_width; mb_x++) {
+            IntMotionVector *mv = &deshake->block_mvs[mb_x + mb_y * b_width];
+
+            x = deshake->rx + mb_x * 16;
+            y = deshake->ry + mb_y * deshake->blocksize * 2;
+            if (mv->x != -1 && mv->y != -1) {
+                deshake->counts[mv->x + deshake->rx][mv->y + deshake->ry] += 1;
+                if (x > deshake->rx && y > deshake->ry)
+                    deshake->angles[pos++] = block_angle(x, y, 0, 0, mv);
+
+                center_x += mv->x;
+                center_y += mv->y;
             }
         }
     }
@@ -310,33 +346,58 @@ static void find_motion(DeshakeContext *deshake, uint8_t *src1, uint8_t *src2,
     t->angle = av_clipf(t->angle, -0.1, 0.1);
 
     //av_log(NULL, AV_LOG_ERROR, "%d x %d\n", avg->x, avg->y);
+    return 0;
 }
 
-static int deshake_transform_c(AVFilterContext *ctx,
-                                    int width, int height, int cw, int ch,
-                                    const float *matrix_y, const float *matrix_uv,
-                                    enum InterpolateMethod interpolate,
-                                    enum FillMethod fill, AVFrame *in, AVFrame *out)
-{
-    int i = 0, ret = 0;
+typedef struct TransformThreadData {
+    AVFrame *in, *out;
     const float *matrixs[3];
     int plane_w[3], plane_h[3];
-    matrixs[0] = matrix_y;
-    matrixs[1] =  matrixs[2] = matrix_uv;
-    plane_w[0] = width;
-    plane_w[1] = plane_w[2] = cw;
-    plane_h[0] = height;
-    plane_h[1] = plane_h[2] = ch;
+    enum InterpolateMethod interpolate;
+    enum FillMethod fill;
+} TransformThreadData;
+
+static int transform_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    TransformThreadData *td = arg;
+    int i, ret;
 
     for (i = 0; i < 3; i++) {
+        const int slice_start = (td->plane_h[i] *  jobnr   ) / nb_jobs;
+        const int slice_end   = (td->plane_h[i] * (jobnr+1)) / nb_jobs;
+
         // Transform the luma and chroma planes
-        ret = ff_affine_transform(in->data[i], out->data[i], in->linesize[i],
-                                  out->linesize[i], plane_w[i], plane_h[i],
-                                  matrixs[i], interpolate, fill);
+        ret = ff_affine_transform(td->in->data[i], td->out->data[i], td->in->linesize[i],
+                                  td->out->linesize[i], td->plane_w[i], td->plane_h[i],
+                                  td->matrixs[i], td->interpolate, td->fill,
+                                  slice_start, slice_end);
         if (ret < 0)
             return ret;
     }
-    return ret;
+    return 0;
+}
+
+static int deshake_transform_c(AVFilterContext *ctx,
+                                    int width, int height, int cw, int ch,
+                                    const float *matrix_y, const float *matrix_uv,
+                                    enum InterpolateMethod interpolate,
+                                    enum FillMethod fill, AVFrame *in, AVFrame *out)
+{
+    TransformThreadData td;
+
+    td.in  = in;
+    td.out = out;
+    td.matrixs[0] = matrix_y;
+    td.matrixs[1] = td.matrixs[2] = matrix_uv;
+    td.plane_w[0] = width;
+    td.plane_w[1] = td.plane_w[2] = cw;
+    td.plane_h[0] = height;
+    td.plane_h[1] = td.plane_h[2] = ch;
+    td.interpolate = interpolate;
+    td.fill        = fill;
+
+    return ff_filter_execute(ctx, transform_slice, &td, NULL,
+                             FFMIN(ch, ff_filter_get_nb_threads(ctx)));
 }
 
 static av_cold int init(AVFilterContext *ctx)
@@ -388,6 +449,10 @@ static int config_props(AVFilterLink *link)
     deshake->last.angle = 0;
     deshake->last.zoom = 0;
 
+    // Blocks are compared with a width and height of 16
+    ff_me_init_context(&deshake->me_ctx, 16, FFMAX(deshake->rx, deshake->ry),
+                       link->w, link->h, 0, link->w - 16, 0, link->h - 16);
+
     return 0;
 }
 
@@ -397,6 +462,8 @@ static av_cold void uninit(AVFilterContext *ctx)
     av_frame_free(&deshake->ref);
     av_freep(&deshake->angles);
     deshake->angles_size = 0;
+    av_freep(&deshake->block_mvs);
+    deshake->block_mvs_size = 0;
     if (deshake->fp)
         fclose(deshake->fp);
 }
@@ -414,7 +481,6 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(link->format);
     const int chroma_width  = AV_CEIL_RSHIFT(link->w, desc->log2_chroma_w);
     const int chroma_height = AV_CEIL_RSHIFT(link->h, desc->log2_chroma_h);
-    int aligned;
     float transform_zoom;
 
     out = ff_get_video_buffer(outlink, outlink->w, outlink->h);
@@ -424,14 +490,9 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
     }
     av_frame_copy_props(out, in);
 
-    aligned = !((intptr_t)in->data[0] & 15 | in->linesize[0] & 15);
-    deshake->sad = av_pixelutils_get_sad_fn(4, 4, aligned, deshake); // 16x16, 2nd source unaligned
-    if (!deshake->sad)
-        return AVERROR(EINVAL);
-
     if (deshake->cx < 0 || deshake->cy < 0 || deshake->cw < 0 || deshake->ch < 0) {
         // Find the most likely global motion for the current frame
-        find_motion(deshake, (deshake->ref == NULL) ? in->data[0] : deshake->ref->data[0], in->data[0], link->w, link->h, in->linesize[0], &t);
+        ret = find_motion(link->dst, (deshake->ref == NULL) ? in->data[0] : deshake->ref->data[0], in->data[0], link->w, link->h, in->linesize[0], &t);
     } else {
         uint8_t *src1 = (deshake->ref == NULL) ? in->data[0] : deshake->ref->data[0];
         uint8_t *src2 = in->data[0];
@@ -448,7 +509,11 @@ static int filter_frame(AVFilterLink *link, AVFrame *in)
         src1 += deshake->cy * in->linesize[0] + deshake->cx;
         src2 += deshake->cy * in->linesize[0] + deshake->cx;
 
-        find_motion(deshake, src1, src2, deshake->cw, deshake->ch, in->linesize[0], &t);
+        ret = find_motion(link->dst, src1, src2, deshake->cw, deshake->ch, in->linesize[0], &t);
+    }
+    if (ret < 0) {
+        av_frame_free(&in);
+        goto fail;
     }
 
 
@@ -552,4 +617,5 @@ const AVFilter ff_vf_deshake = {
     FILTER_OUTPUTS(deshake_outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
     .priv_class    = &deshake_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -28,6 +28,7 @@
 
 #include "avfilter.h"
 #include "filters.h"
+#include "internal.h"
 #include "scene_sad.h"
 
 typedef struct FreezeDetectContext {
@@ -44,8 +45,15 @@ typedef struct FreezeDetectContext {
 
     double noise;
     int64_t duration;            ///< minimum duration of frozen frame until notification
+
+    int nb_threads;
+    uint64_t *sads;              ///< SAD of each slice
 } FreezeDetectContext;
 
+typedef struct ThreadData {
+    AVFrame *reference, *frame;
+} ThreadData;
+
 #define OFFSET(x) offsetof(FreezeDetectContext, x)
 #define V AV_OPT_FLAG_VIDEO_PARAM
 #define F AV_OPT_FLAG_FILTERING_PARAM
@@ -106,6 +114,11 @@ static int config_input(AVFilterLink *inlink)
     if (!s->sad)
         return AVERROR(EINVAL);
 
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->sads = av_calloc(s->nb_threads, sizeof(*s->sads));
+    if (!s->sads)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -113,23 +126,51 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     FreezeDetectContext *s = ctx->priv;
     av_frame_free(&s->reference_frame);
+    av_freep(&s->sads);
 }
 
-static int is_frozen(FreezeDetectContext *s, AVFrame *reference, AVFrame *frame)
+static int sad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
+    FreezeDetectContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *reference = td->reference;
+    AVFrame *frame = td->frame;
     uint64_t sad = 0;
-    uint64_t count = 0;
-    double mafd;
+
     for (int plane = 0; plane < 4; plane++) {
-        if (s->width[plane]) {
+        const ptrdiff_t slice_start = (s->height[plane] *  jobnr   ) / nb_jobs;
+        const ptrdiff_t slice_end   = (s->height[plane] * (jobnr+1)) / nb_jobs;
+
+        if (s->width[plane] && slice_end > slice_start) {
             uint64_t plane_sad;
-            s->sad(frame->data[plane], frame->linesize[plane],
-                   reference->data[plane], reference->linesize[plane],
-                   s->width[plane], s->height[plane], &plane_sad);
+            s->sad(frame->data[plane] + slice_start * frame->linesize[plane],
+                   frame->linesize[plane],
+                   reference->data[plane] + slice_start * reference->linesize[plane],
+                   reference->linesize[plane],
+                   s->width[plane], slice_end - slice_start, &plane_sad);
             sad += plane_sad;
-            count += s->width[plane] * s->height[plane];
         }
     }
+    s->sads[jobnr] = sad;
+
+    return 0;
+}
+
+static int is_frozen(AVFilterContext *ctx, AVFrame *reference, AVFrame *frame)
+{
+    FreezeDetectContext *s = ctx->priv;
+    ThreadData td = { .reference = reference, .frame = frame };
+    const int nb_jobs = FFMIN(s->height[0], s->nb_threads);
+    uint64_t sad = 0;
+    uint64_t count = 0;
+    double mafd;
+
+    ff_filter_execute(ctx, sad_slice, &td, NULL, nb_jobs);
+
+    for (int i = 0; i < nb_jobs; i++)
+        sad += s->sads[i];
+    for (int plane = 0; plane < 4; plane++)
+        count += s->width[plane] * s->height[plane];
     emms_c();
     mafd = (double)sad / count / (1ULL << s->bitdepth);
     return (mafd <= s->noise);
@@ -166,7 +207,7 @@ static int activate(AVFilterContext *ctx)
             else
                 duration = av_rescale_q(frame->pts - s->reference_frame->pts, inlink->time_base, AV_TIME_BASE_Q);
 
-            frozen = is_frozen(s, s->reference_frame, frame);
+            frozen = is_frozen(ctx, s->reference_frame, frame);
             if (duration >= s->duration) {
                 if (!s->frozen)
                     set_meta(s, frame, "lavfi.freezedetect.freeze_start", av_ts2timestr(s->reference_frame->pts, &inlink->time_base));
@@ -217,7 +258,7 @@ const AVFilter ff_vf_freezedetect = {
     .priv_size     = sizeof(FreezeDetectContext),
     .priv_class    = &freezedetect_class,
     .uninit        = uninit,
-    .flags         = AVFILTER_FLAG_METADATA_ONLY,
+    .flags         = AVFILTER_FLAG_METADATA_ONLY | AVFILTER_FLAG_SLICE_THREADS,
     FILTER_INPUTS(freezedetect_inputs),
     FILTER_OUTPUTS(freezedetect_outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
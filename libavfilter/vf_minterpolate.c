@@ -247,6 +247,14 @@ static const enum AVPixelFormat pix_fmts[] = {
     AV_PIX_FMT_NONE
 };
 
+typedef struct ThreadData {
+    MIContext *mi_ctx;
+    Block *blocks;
+    int dir;
+    AVFrame *out;
+    int alpha;
+} ThreadData;
+
 static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int y_mv)
 {
     uint8_t *data_cur = me_ctx->data_cur;
@@ -254,20 +262,16 @@ static uint64_t get_sbad(AVMotionEstContext *me_ctx, int x, int y, int x_mv, int
     int linesize = me_ctx->linesize;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, me_ctx->x_min, me_ctx->x_max);
     y = av_clip(y, me_ctx->y_min, me_ctx->y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - me_ctx->x_min, me_ctx->x_max - x), FFMIN(x - me_ctx->x_min, me_ctx->x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - me_ctx->y_min, me_ctx->y_max - y), FFMIN(y - me_ctx->y_min, me_ctx->y_max - y));
 
-    data_cur += (y + mv_y) * linesize;
-    data_next += (y - mv_y) * linesize;
-
-    for (j = 0; j < me_ctx->mb_size; j++)
-        for (i = 0; i < me_ctx->mb_size; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + j * linesize] - data_next[x - mv_x + i + j * linesize]);
+    sbad = ff_me_block_sad(me_ctx, data_cur  + x + mv_x + (y + mv_y) * linesize,
+                                   data_next + x - mv_x + (y - mv_y) * linesize, me_ctx->mb_size);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -281,19 +285,19 @@ static uint64_t get_sbad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv,
     int x_max = me_ctx->x_max - me_ctx->mb_size / 2;
     int y_min = me_ctx->y_min + me_ctx->mb_size / 2;
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
+    int ob = me_ctx->mb_size / 2;
     int mv_x1 = x_mv - x;
     int mv_y1 = y_mv - y;
-    int mv_x, mv_y, i, j;
-    uint64_t sbad = 0;
+    int mv_x, mv_y;
+    uint64_t sbad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     mv_x = av_clip(x_mv - x, -FFMIN(x - x_min, x_max - x), FFMIN(x - x_min, x_max - x));
     mv_y = av_clip(y_mv - y, -FFMIN(y - y_min, y_max - y), FFMIN(y - y_min, y_max - y));
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sbad += FFABS(data_cur[x + mv_x + i + (y + mv_y + j) * linesize] - data_next[x - mv_x + i + (y - mv_y + j) * linesize]);
+    sbad = ff_me_block_sad(me_ctx, data_cur  + x + mv_x - ob + (y + mv_y - ob) * linesize,
+                                   data_next + x - mv_x - ob + (y - mv_y - ob) * linesize, me_ctx->mb_size + 2 * ob);
 
     return sbad + (FFABS(mv_x1 - me_ctx->pred_x) + FFABS(mv_y1 - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -307,19 +311,18 @@ static uint64_t get_sad_ob(AVMotionEstContext *me_ctx, int x, int y, int x_mv, i
     int x_max = me_ctx->x_max - me_ctx->mb_size / 2;
     int y_min = me_ctx->y_min + me_ctx->mb_size / 2;
     int y_max = me_ctx->y_max - me_ctx->mb_size / 2;
+    int ob = me_ctx->mb_size / 2;
     int mv_x = x_mv - x;
     int mv_y = y_mv - y;
-    int i, j;
-    uint64_t sad = 0;
+    uint64_t sad;
 
     x = av_clip(x, x_min, x_max);
     y = av_clip(y, y_min, y_max);
     x_mv = av_clip(x_mv, x_min, x_max);
     y_mv = av_clip(y_mv, y_min, y_max);
 
-    for (j = -me_ctx->mb_size / 2; j < me_ctx->mb_size * 3 / 2; j++)
-        for (i = -me_ctx->mb_size / 2; i < me_ctx->mb_size * 3 / 2; i++)
-            sad += FFABS(data_ref[x_mv + i + (y_mv + j) * linesize] - data_cur[x + i + (y + j) * linesize]);
+    sad = ff_me_block_sad(me_ctx, data_ref + x_mv - ob + (y_mv - ob) * linesize,
+                                  data_cur + x    - ob + (y    - ob) * linesize, me_ctx->mb_size + 2 * ob);
 
     return sad + (FFABS(mv_x - me_ctx->pred_x) + FFABS(mv_y - me_ctx->pred_y)) * COST_PRED_SCALE;
 }
@@ -413,9 +416,9 @@ static int config_output(AVFilterLink *outlink)
         preds.nb++;\
     } while(0)
 
-static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int dir)
+static void search_mv(MIContext *mi_ctx, AVMotionEstContext *me_ctx,
+                      Block *blocks, int mb_x, int mb_y, int dir)
 {
-    AVMotionEstContext *me_ctx = &mi_ctx->me_ctx;
     AVMotionEstPredictor *preds = me_ctx->preds;
     Block *block = &blocks[mb_x + mb_y * mi_ctx->b_width];
 
@@ -555,8 +558,31 @@ static void search_mv(MIContext *mi_ctx, Block *blocks, int mb_x, int mb_y, int
     block->mvs[dir][1] = mv[1] - y_mb;
 }
 
-static void bilateral_me(MIContext *mi_ctx)
+static void search_mv_block(AVMotionEstContext *me_ctx, void *opaque, int mb_x, int mb_y)
+{
+    ThreadData *td = opaque;
+
+    search_mv(td->mi_ctx, me_ctx, td->blocks, mb_x, mb_y, td->dir);
+}
+
+static void search_mvs(AVFilterContext *ctx, Block *blocks, int dir)
 {
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData td;
+
+    td.mi_ctx = mi_ctx;
+    td.blocks = blocks;
+    td.dir    = dir;
+
+    ff_me_search_blocks(ctx, &mi_ctx->me_ctx, mi_ctx->b_width, mi_ctx->b_height,
+                        mi_ctx->me_method == AV_ME_METHOD_EPZS ||
+                        mi_ctx->me_method == AV_ME_METHOD_UMH,
+                        search_mv_block, &td);
+}
+
+static void bilateral_me(AVFilterContext *ctx)
+{
+    MIContext *mi_ctx = ctx->priv;
     Block *block;
     int mb_x, mb_y;
 
@@ -571,9 +597,7 @@ static void bilateral_me(MIContext *mi_ctx)
             block->mvs[0][1] = 0;
         }
 
-    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-            search_mv(mi_ctx, mi_ctx->int_blocks, mb_x, mb_y, 0);
+    search_mvs(ctx, mi_ctx->int_blocks, 0);
 }
 
 static int var_size_bme(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n)
@@ -728,6 +752,26 @@ static int cluster_mvs(MIContext *mi_ctx)
     return 0;
 }
 
+static int block_sbad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    const int slice_start = (mi_ctx->b_height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (mi_ctx->b_height * (jobnr+1)) / nb_jobs;
+    int mb_x, mb_y;
+
+    for (mb_y = slice_start; mb_y < slice_end; mb_y++)
+        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+            int x_mb = mb_x << mi_ctx->log2_mb_size;
+            int y_mb = mb_y << mi_ctx->log2_mb_size;
+            Block *block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+            block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
+        }
+    emms_c();
+
+    return 0;
+}
+
 static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -756,9 +800,7 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
                     mi_ctx->me_ctx.data_cur = mi_ctx->frames[2].avf->data[0];
                     mi_ctx->me_ctx.data_ref = mi_ctx->frames[dir ? 3 : 1].avf->data[0];
 
-                    for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                        for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++)
-                            search_mv(mi_ctx, mi_ctx->frames[2].blocks, mb_x, mb_y, dir);
+                    search_mvs(ctx, mi_ctx->frames[2].blocks, dir);
                 }
             }
 
@@ -773,19 +815,11 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
             mi_ctx->me_ctx.data_cur = mi_ctx->frames[1].avf->data[0];
             mi_ctx->me_ctx.data_ref = mi_ctx->frames[2].avf->data[0];
 
-            bilateral_me(mi_ctx);
+            bilateral_me(ctx);
 
-            if (mi_ctx->mc_mode == MC_MODE_AOBMC) {
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        int x_mb = mb_x << mi_ctx->log2_mb_size;
-                        int y_mb = mb_y << mi_ctx->log2_mb_size;
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
-
-                        block->sbad = get_sbad(&mi_ctx->me_ctx, x_mb, y_mb, x_mb + block->mvs[0][0], y_mb + block->mvs[0][1]);
-                    }
-            }
+            if (mi_ctx->mc_mode == MC_MODE_AOBMC)
+                ff_filter_execute(ctx, block_sbad_slice, NULL, NULL,
+                                  FFMIN(mi_ctx->b_height, ff_filter_get_nb_threads(ctx)));
 
             if (mi_ctx->vsbmc) {
 
@@ -805,7 +839,9 @@ static int inject_frame(AVFilterLink *inlink, AVFrame *avf_in)
 
                 mi_ctx->clusters[0].nb = mi_ctx->b_count;
 
-                if (ret = cluster_mvs(mi_ctx))
+                ret = cluster_mvs(mi_ctx);
+                emms_c();
+                if (ret)
                     return ret;
             }
         }
@@ -855,17 +891,13 @@ static int detect_scene_change(AVFilterContext *ctx)
         pixel_refs->nb++;\
     } while(0)
 
-static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
+static void bidirectional_obmc(MIContext *mi_ctx, int alpha, int slice_start, int slice_end)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
     int height = mi_ctx->frames[0].avf->height;
     int mb_y, mb_x, dir;
 
-    for (y = 0; y < height; y++)
-        for (x = 0; x < width; x++)
-            mi_ctx->pixel_refs[x + y * width].nb = 0;
-
     for (dir = 0; dir < 2; dir++)
         for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
             for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
@@ -883,6 +915,9 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
                 endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
                 endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
 
+                startc_y = FFMAX(startc_y, slice_start);
+                endc_y   = FFMIN(endc_y, slice_end);
+
                 if (dir) {
                     mv_x = -mv_x;
                     mv_y = -mv_y;
@@ -905,16 +940,16 @@ static void bidirectional_obmc(MIContext *mi_ctx, int alpha)
             }
 }
 
-static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
+static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out,
+                           int slice_start, int slice_end)
 {
     int x, y, plane;
 
     for (plane = 0; plane < mi_ctx->nb_planes; plane++) {
         int width = avf_out->width;
-        int height = avf_out->height;
         int chroma = plane == 1 || plane == 2;
 
-        for (y = 0; y < height; y++)
+        for (y = slice_start; y < slice_end; y++)
             for (x = 0; x < width; x++) {
                 int x_mv, y_mv;
                 int weight_sum = 0;
@@ -963,7 +998,8 @@ static void set_frame_data(MIContext *mi_ctx, int alpha, AVFrame *avf_out)
     }
 }
 
-static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha)
+static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, int n, int alpha,
+                         int slice_start, int slice_end)
 {
     int sb_x, sb_y;
     int width = mi_ctx->frames[0].avf->width;
@@ -974,7 +1010,8 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
             Block *sb = &block->subs[sb_x + sb_y * 2];
 
             if (sb->sb)
-                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha);
+                var_size_bmc(mi_ctx, sb, x_mb + (sb_x << (n - 1)), y_mb + (sb_y << (n - 1)), n - 1, alpha,
+                             slice_start, slice_end);
             else {
                 int x, y;
                 int mv_x = sb->mvs[0][0] * 2;
@@ -985,7 +1022,7 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
                 int end_x = start_x + (1 << (n - 1));
                 int end_y = start_y + (1 << (n - 1));
 
-                for (y = start_y; y < end_y; y++)  {
+                for (y = FFMAX(start_y, slice_start); y < FFMIN(end_y, slice_end); y++)  {
                     int y_min = -y;
                     int y_max = height - y - 1;
                     for (x = start_x; x < end_x; x++) {
@@ -1002,7 +1039,8 @@ static void var_size_bmc(MIContext *mi_ctx, Block *block, int x_mb, int y_mb, in
         }
 }
 
-static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha)
+static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y, int alpha,
+                           int slice_start, int slice_end)
 {
     int x, y;
     int width = mi_ctx->frames[0].avf->width;
@@ -1017,6 +1055,19 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     int start_x, start_y;
     int startc_x, startc_y, endc_x, endc_y;
 
+    start_x = (mb_x << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
+    start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
+
+    startc_x = av_clip(start_x, 0, width - 1);
+    startc_y = av_clip(start_y, 0, height - 1);
+    endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
+    endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
+
+    startc_y = FFMAX(startc_y, slice_start);
+    endc_y   = FFMIN(endc_y, slice_end);
+    if (startc_y >= endc_y)
+        return;
+
     if (mi_ctx->mc_mode == MC_MODE_AOBMC)
         for (nb_y = FFMAX(0, mb_y - 1); nb_y < FFMIN(mb_y + 2, mi_ctx->b_height); nb_y++)
             for (nb_x = FFMAX(0, mb_x - 1); nb_x < FFMIN(mb_x + 2, mi_ctx->b_width); nb_x++) {
@@ -1027,14 +1078,6 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
                     sbads[nb_x - mb_x + 1 + (nb_y - mb_y + 1) * 3] = get_sbad(&mi_ctx->me_ctx, x_nb, y_nb, x_nb + block->mvs[0][0], y_nb + block->mvs[0][1]);
             }
 
-    start_x = (mb_x << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
-    start_y = (mb_y << mi_ctx->log2_mb_size) - mi_ctx->mb_size / 2;
-
-    startc_x = av_clip(start_x, 0, width - 1);
-    startc_y = av_clip(start_y, 0, height - 1);
-    endc_x = av_clip(start_x + (2 << mi_ctx->log2_mb_size), 0, width - 1);
-    endc_y = av_clip(start_y + (2 << mi_ctx->log2_mb_size), 0, height - 1);
-
     for (y = startc_y; y < endc_y; y++) {
         int y_min = -y;
         int y_max = height - y - 1;
@@ -1066,6 +1109,45 @@ static void bilateral_obmc(MIContext *mi_ctx, Block *block, int mb_x, int mb_y,
     }
 }
 
+static int mc_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    MIContext *mi_ctx = ctx->priv;
+    ThreadData *td = arg;
+    const int width  = td->out->width;
+    const int height = td->out->height;
+    /* keep the luma rows sharing a chroma row within one job */
+    const int c_height = AV_CEIL_RSHIFT(height, mi_ctx->log2_chroma_h);
+    const int slice_start = ((c_height *  jobnr   ) / nb_jobs) << mi_ctx->log2_chroma_h;
+    const int slice_end   = FFMIN(((c_height * (jobnr+1)) / nb_jobs) << mi_ctx->log2_chroma_h, height);
+    int x, y;
+
+    for (y = slice_start; y < slice_end; y++)
+        for (x = 0; x < width; x++)
+            mi_ctx->pixel_refs[x + y * width].nb = 0;
+
+    if (mi_ctx->me_mode == ME_MODE_BIDIR) {
+        bidirectional_obmc(mi_ctx, td->alpha, slice_start, slice_end);
+    } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
+        int mb_x, mb_y;
+
+        for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
+            for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
+                Block *block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
+
+                if (block->sb)
+                    var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size,
+                                 mi_ctx->log2_mb_size, td->alpha, slice_start, slice_end);
+
+                bilateral_obmc(mi_ctx, block, mb_x, mb_y, td->alpha, slice_start, slice_end);
+            }
+    }
+
+    set_frame_data(mi_ctx, td->alpha, td->out, slice_start, slice_end);
+    emms_c();
+
+    return 0;
+}
+
 static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
 {
     AVFilterContext *ctx = inlink->dst;
@@ -1118,34 +1200,17 @@ static void interpolate(AVFilterLink *inlink, AVFrame *avf_out)
             }
 
             break;
-        case MI_MODE_MCI:
-            if (mi_ctx->me_mode == ME_MODE_BIDIR) {
-                bidirectional_obmc(mi_ctx, alpha);
-                set_frame_data(mi_ctx, alpha, avf_out);
-
-            } else if (mi_ctx->me_mode == ME_MODE_BILAT) {
-                int mb_x, mb_y;
-                Block *block;
+        case MI_MODE_MCI: {
+            ThreadData td;
 
-                for (y = 0; y < mi_ctx->frames[0].avf->height; y++)
-                    for (x = 0; x < mi_ctx->frames[0].avf->width; x++)
-                        mi_ctx->pixel_refs[x + y * mi_ctx->frames[0].avf->width].nb = 0;
-
-                for (mb_y = 0; mb_y < mi_ctx->b_height; mb_y++)
-                    for (mb_x = 0; mb_x < mi_ctx->b_width; mb_x++) {
-                        block = &mi_ctx->int_blocks[mb_x + mb_y * mi_ctx->b_width];
-
-                        if (block->sb)
-                            var_size_bmc(mi_ctx, block, mb_x << mi_ctx->log2_mb_size, mb_y << mi_ctx->log2_mb_size, mi_ctx->log2_mb_size, alpha);
-
-                        bilateral_obmc(mi_ctx, block, mb_x, mb_y, alpha);
-
-                    }
-
-                set_frame_data(mi_ctx, alpha, avf_out);
-            }
+            td.out   = avf_out;
+            td.alpha = alpha;
+            ff_filter_execute(ctx, mc_slice, &td, NULL,
+                              FFMIN(AV_CEIL_RSHIFT(avf_out->height, mi_ctx->log2_chroma_h),
+                                    ff_filter_get_nb_threads(ctx)));
 
             break;
+        }
     }
 }
 
@@ -1256,4 +1321,5 @@ const AVFilter ff_vf_minterpolate = {
     FILTER_INPUTS(minterpolate_inputs),
     FILTER_OUTPUTS(minterpolate_outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
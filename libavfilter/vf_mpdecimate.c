@@ -49,8 +49,19 @@ typedef struct DecimateContext {
     int hsub, vsub;                ///< chroma subsampling values
     AVFrame *ref;                  ///< reference picture
     av_pixelutils_sad_fn sad;      ///< sum of absolute difference function
+
+    int nb_threads;
+    int *counts;                   ///< number of blocks above lo found by each job,
+                                   ///< -1 if a block above hi was found
 } DecimateContext;
 
+typedef struct ThreadData {
+    uint8_t *cur, *ref;
+    int cur_linesize, ref_linesize;
+    int w, h;
+    int t;
+} ThreadData;
+
 #define OFFSET(x) offsetof(DecimateContext, x)
 #define FLAGS AV_OPT_FLAG_VIDEO_PARAM|AV_OPT_FLAG_FILTERING_PARAM
 
@@ -65,40 +76,75 @@ static const AVOption mpdecimate_options[] = {
 
 AVFILTER_DEFINE_CLASS(mpdecimate);
 
-/**
- * Return 1 if the two planes are different, 0 otherwise.
- */
-static int diff_planes(AVFilterContext *ctx,
-                       uint8_t *cur, int cur_linesize,
-                       uint8_t *ref, int ref_linesize,
-                       int w, int h)
+static int diff_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
 {
     DecimateContext *decimate = ctx->priv;
-
+    ThreadData *td = arg;
+    const int nb_rows = (td->h - 8) / 4 + 1;
+    const int slice_start = (nb_rows *  jobnr   ) / nb_jobs * 4;
+    const int slice_end   = (nb_rows * (jobnr+1)) / nb_jobs * 4;
     int x, y;
     int d, c = 0;
-    int t = (w/16)*(h/16)*decimate->frac;
 
-    /* compute difference for blocks of 8x8 bytes */
-    for (y = 0; y < h-7; y += 4) {
-        for (x = 8; x < w-7; x += 4) {
-            d = decimate->sad(cur + y*cur_linesize + x, cur_linesize,
-                              ref + y*ref_linesize + x, ref_linesize);
+    /* compute difference for blocks of 8x8 bytes, stopping as soon as the
+     * plane is known to be different */
+    for (y = slice_start; y < slice_end; y += 4) {
+        for (x = 8; x < td->w-7; x += 4) {
+            d = decimate->sad(td->cur + y*td->cur_linesize + x, td->cur_linesize,
+                              td->ref + y*td->ref_linesize + x, td->ref_linesize);
             if (d > decimate->hi) {
                 av_log(ctx, AV_LOG_DEBUG, "%d>=hi ", d);
-                return 1;
+                c = -1;
+                goto end;
             }
             if (d > decimate->lo) {
                 c++;
-                if (c > t) {
-                    av_log(ctx, AV_LOG_DEBUG, "lo:%d>=%d ", c, t);
-                    return 1;
-                }
+                if (c > td->t)
+                    goto end;
             }
         }
     }
 
-    av_log(ctx, AV_LOG_DEBUG, "lo:%d<%d ", c, t);
+end:
+    emms_c();
+    decimate->counts[jobnr] = c;
+
+    return 0;
+}
+
+/**
+ * Return 1 if the two planes are different, 0 otherwise.
+ */
+static int diff_planes(AVFilterContext *ctx,
+                       uint8_t *cur, int cur_linesize,
+                       uint8_t *ref, int ref_linesize,
+                       int w, int h)
+{
+    DecimateContext *decimate = ctx->priv;
+    ThreadData td = {
+        .cur = cur, .cur_linesize = cur_linesize,
+        .ref = ref, .ref_linesize = ref_linesize,
+        .w = w, .h = h,
+        .t = (w/16)*(h/16)*decimate->frac,
+    };
+    const int nb_jobs = h > 7 ? FFMIN((h - 8) / 4 + 1, decimate->nb_threads) : 0;
+    int c = 0;
+
+    if (nb_jobs)
+        ff_filter_execute(ctx, diff_slice, &td, NULL, nb_jobs);
+
+    for (int j = 0; j < nb_jobs; j++) {
+        if (decimate->counts[j] < 0)
+            return 1;
+        c += decimate->counts[j];
+    }
+
+    if (c > td.t) {
+        av_log(ctx, AV_LOG_DEBUG, "lo:%d>=%d ", c, td.t);
+        return 1;
+    }
+
+    av_log(ctx, AV_LOG_DEBUG, "lo:%d<%d ", c, td.t);
     return 0;
 }
 
@@ -131,13 +177,10 @@ static int decimate_frame(AVFilterContext *ctx,
                         cur->data[plane], cur->linesize[plane],
                         ref->data[plane], ref->linesize[plane],
                         AV_CEIL_RSHIFT(ref->width,  hsub),
-                        AV_CEIL_RSHIFT(ref->height, vsub))) {
-            emms_c();
+                        AV_CEIL_RSHIFT(ref->height, vsub)))
             return 0;
-        }
     }
 
-    emms_c();
     return 1;
 }
 
@@ -159,6 +202,7 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     DecimateContext *decimate = ctx->priv;
     av_frame_free(&decimate->ref);
+    av_freep(&decimate->counts);
 }
 
 static const enum AVPixelFormat pix_fmts[] = {
@@ -185,6 +229,11 @@ static int config_input(AVFilterLink *inlink)
     decimate->hsub = pix_desc->log2_chroma_w;
     decimate->vsub = pix_desc->log2_chroma_h;
 
+    decimate->nb_threads = ff_filter_get_nb_threads(ctx);
+    decimate->counts = av_calloc(decimate->nb_threads, sizeof(*decimate->counts));
+    if (!decimate->counts)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -243,4 +292,5 @@ const AVFilter ff_vf_mpdecimate = {
     FILTER_INPUTS(mpdecimate_inputs),
     FILTER_OUTPUTS(mpdecimate_outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -51,6 +51,16 @@ struct hist_node {
     int nb_entries;
 };
 
+/* Colors seen by one slice job in the current frame, in order of first
+ * appearance, indexed by an open addressing hash table */
+struct hist_shard {
+    struct color_ref *entries;
+    unsigned entries_size;
+    int nb_entries;
+    uint32_t *table;        // index + 1 in entries, 0 for a free slot
+    int table_bits;
+};
+
 enum {
     STATS_MODE_ALL_FRAMES,
     STATS_MODE_DIFF_FRAMES,
@@ -71,12 +81,15 @@ typedef struct PaletteGenContext {
 
     AVFrame *prev_frame;                    // previous frame used for the diff stats_mode
     struct hist_node histogram[HIST_SIZE];  // histogram/hashtable of the colors
-    struct color_ref **refs;                // references of all the colors used in the stream
+    struct color_ref *refs;                 // all the colors used in the stream
     int nb_refs;                            // number of color references (or number of different colors)
     struct range_box boxes[256];            // define the segmentation of the colorspace (the final palette)
     int nb_boxes;                           // number of boxes (increase will segmenting them)
     int palette_pushed;                     // if the palette frame is pushed into the outlink or not
     uint8_t transparency_color[4];          // background color for transparency
+    struct hist_shard *shards;              // per slice job frame histograms
+    int *job_ret;
+    int nb_threads;
 } PaletteGenContext;
 
 #define OFFSET(x) offsetof(PaletteGenContext, x)
@@ -108,15 +121,12 @@ static int query_formats(AVFilterContext *ctx)
     return 0;
 }
 
-typedef int (*cmp_func)(const void *, const void *);
-
 #define DECLARE_CMP_FUNC(name, pos)                     \
-static int cmp_##name(const void *pa, const void *pb)   \
+static inline int cmp_##name(const struct color_ref *a, \
+                             const struct color_ref *b) \
 {                                                       \
-    const struct color_ref * const *a = pa;             \
-    const struct color_ref * const *b = pb;             \
-    return   (int)((*a)->color >> (8 * (3 - (pos))) & 0xff)  \
-           - (int)((*b)->color >> (8 * (3 - (pos))) & 0xff); \
+    return   (int)(a->color >> (8 * (3 - (pos))) & 0xff)  \
+           - (int)(b->color >> (8 * (3 - (pos))) & 0xff); \
 }
 
 DECLARE_CMP_FUNC(a, 0)
@@ -124,7 +134,19 @@ DECLARE_CMP_FUNC(r, 1)
 DECLARE_CMP_FUNC(g, 2)
 DECLARE_CMP_FUNC(b, 3)
 
-static const cmp_func cmp_funcs[] = {cmp_a, cmp_r, cmp_g, cmp_b};
+/**
+ * Sort a range of colors by one of its components. Each axis gets its own
+ * instance of the sort so that the comparison is inlined.
+ */
+static void sort_refs(struct color_ref *refs, int len, int axis)
+{
+    switch (axis) {
+    case 0: AV_QSORT(refs, len, struct color_ref, cmp_a); break;
+    case 1: AV_QSORT(refs, len, struct color_ref, cmp_r); break;
+    case 2: AV_QSORT(refs, len, struct color_ref, cmp_g); break;
+    case 3: AV_QSORT(refs, len, struct color_ref, cmp_b); break;
+    }
+}
 
 /**
  * Simple color comparison for sorting the final palette
@@ -177,7 +199,7 @@ static int get_next_box_id_to_split(PaletteGenContext *s)
                 int64_t variance = 0;
 
                 for (i = 0; i < box->len; i++) {
-                    const struct color_ref *ref = s->refs[box->start + i];
+                    const struct color_ref *ref = &s->refs[box->start + i];
                     if (s->use_alpha)
                         variance += (int64_t)diff_alpha(ref->color, box->color) * ref->count;
                     else
@@ -200,7 +222,7 @@ static int get_next_box_id_to_split(PaletteGenContext *s)
  * Get the 32-bit average color for the range of RGB colors enclosed in the
  * specified box. Takes into account the weight of each color.
  */
-static uint32_t get_avg_color(struct color_ref * const *refs,
+static uint32_t get_avg_color(const struct color_ref *refs,
                               const struct range_box *box, int use_alpha)
 {
     int i;
@@ -208,7 +230,7 @@ static uint32_t get_avg_color(struct color_ref * const *refs,
     uint64_t a = 0, r = 0, g = 0, b = 0, div = 0;
 
     for (i = 0; i < n; i++) {
-        const struct color_ref *ref = refs[box->start + i];
+        const struct color_ref *ref = &refs[box->start + i];
         if (use_alpha)
             a += (ref->color >> 24 & 0xff) * ref->count;
         r += (ref->color     >> 16 & 0xff) * ref->count;
@@ -283,13 +305,13 @@ static void write_palette(AVFilterContext *ctx, AVFrame *out)
 
 /**
  * Crawl the histogram to get all the defined colors, and create a linear list
- * of them (each color reference entry is a pointer to the value in the
- * histogram/hash table).
+ * of them (each color reference entry is a copy of the value in the
+ * histogram/hash table, so that the median cut works on contiguous memory).
  */
-static struct color_ref **load_color_refs(const struct hist_node *hist, int nb_refs)
+static struct color_ref *load_color_refs(const struct hist_node *hist, int nb_refs)
 {
-    int i, j, k = 0;
-    struct color_ref **refs = av_malloc_array(nb_refs, sizeof(*refs));
+    int j, k = 0;
+    struct color_ref *refs = av_malloc_array(nb_refs, sizeof(*refs));
 
     if (!refs)
         return NULL;
@@ -297,8 +319,10 @@ static struct color_ref **load_color_refs(const struct hist_node *hist, int nb_r
     for (j = 0; j < HIST_SIZE; j++) {
         const struct hist_node *node = &hist[j];
 
-        for (i = 0; i < node->nb_entries; i++)
-            refs[k++] = &node->entries[i];
+        if (!node->nb_entries)
+            continue;
+        memcpy(&refs[k], node->entries, node->nb_entries * sizeof(*refs));
+        k += node->nb_entries;
     }
 
     return refs;
@@ -356,7 +380,7 @@ static AVFrame *get_palette_frame(AVFilterContext *ctx)
         uint8_t min[4] = {0xff, 0xff, 0xff, 0xff};
         uint8_t max[4] = {0x00, 0x00, 0x00, 0x00};
         for (i = box->start; i < box->start + box->len; i++) {
-            const struct color_ref *ref = s->refs[i];
+            const struct color_ref *ref = &s->refs[i];
             const uint32_t rgb = ref->color;
             const uint8_t a = rgb >> 24 & 0xff, r = rgb >> 16 & 0xff, g = rgb >> 8 & 0xff, b = rgb & 0xff;
             min[0] = FFMIN(a, min[0]); max[0] = FFMAX(a, max[0]);
@@ -389,8 +413,7 @@ static AVFrame *get_palette_frame(AVFilterContext *ctx)
 
         /* sort the range by its longest axis if it's not already sorted */
         if (box->sorted_by != longest) {
-            cmp_func cmpf = cmp_funcs[longest];
-            AV_QSORT(&s->refs[box->start], box->len, const struct color_ref *, cmpf);
+            sort_refs(&s->refs[box->start], box->len, longest);
             box->sorted_by = longest;
         }
 
@@ -400,7 +423,7 @@ static AVFrame *get_palette_frame(AVFilterContext *ctx)
         /* if you have 2 boxes, the maximum is actually #0: you must have at
          * least 1 color on each side of the split, hence the -2 */
         for (i = box->start; i < box->start + box->len - 2; i++) {
-            box_weight += s->refs[i]->count;
+            box_weight += s->refs[i].count;
             if (box_weight > median)
                 break;
         }
@@ -442,9 +465,9 @@ static inline unsigned color_hash(uint32_t color, int use_alpha)
 }
 
 /**
- * Locate the color in the hash table and increment its counter.
+ * Locate the color in the hash table and add count to its counter.
  */
-static int color_inc(struct hist_node *hist, uint32_t color, int use_alpha)
+static int color_add(struct hist_node *hist, uint32_t color, uint64_t count, int use_alpha)
 {
     int i;
     const unsigned hash = color_hash(color, use_alpha);
@@ -454,7 +477,7 @@ static int color_inc(struct hist_node *hist, uint32_t color, int use_alpha)
     for (i = 0; i < node->nb_entries; i++) {
         e = &node->entries[i];
         if (e->color == color) {
-            e->count++;
+            e->count += count;
             return 0;
         }
     }
@@ -464,52 +487,155 @@ static int color_inc(struct hist_node *hist, uint32_t color, int use_alpha)
     if (!e)
         return AVERROR(ENOMEM);
     e->color = color;
-    e->count = 1;
+    e->count = count;
     return 1;
 }
 
+static inline uint32_t shard_hash(uint32_t color, int bits)
+{
+    return (color * 0x9E3779B1U) >> (32 - bits);
+}
+
+static int shard_grow_table(struct hist_shard *shard)
+{
+    const int bits = shard->table_bits ? shard->table_bits + 1 : 12;
+    const uint32_t mask = (1U << bits) - 1;
+    uint32_t *table = av_calloc(1U << bits, sizeof(*table));
+
+    if (!table)
+        return AVERROR(ENOMEM);
+
+    for (int i = 0; i < shard->nb_entries; i++) {
+        uint32_t slot = shard_hash(shard->entries[i].color, bits);
+        while (table[slot])
+            slot = (slot + 1) & mask;
+        table[slot] = i + 1;
+    }
+
+    av_free(shard->table);
+    shard->table      = table;
+    shard->table_bits = bits;
+    return 0;
+}
+
+/**
+ * Locate the color in the slice hash table and increment its counter.
+ */
+static int shard_inc(struct hist_shard *shard, uint32_t color)
+{
+    const uint32_t mask = (1U << shard->table_bits) - 1;
+    uint32_t slot = shard_hash(color, shard->table_bits);
+    struct color_ref *e;
+    uint32_t idx;
+
+    while ((idx = shard->table[slot])) {
+        e = &shard->entries[idx - 1];
+        if (e->color == color) {
+            e->count++;
+            return 0;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    /* keep the table at most half full */
+    if (2 * (shard->nb_entries + 1) > 1 << shard->table_bits) {
+        int ret = shard_grow_table(shard);
+        if (ret < 0)
+            return ret;
+        return shard_inc(shard, color);
+    }
+
+    e = av_fast_realloc(shard->entries, &shard->entries_size,
+                        (shard->nb_entries + 1) * sizeof(*shard->entries));
+    if (!e)
+        return AVERROR(ENOMEM);
+    shard->entries = e;
+    e = &shard->entries[shard->nb_entries++];
+    e->color = color;
+    e->count = 1;
+    shard->table[slot] = shard->nb_entries;
+    return 0;
+}
+
+typedef struct ThreadData {
+    const AVFrame *f1, *f2;
+} ThreadData;
+
 /**
- * Update histogram when pixels differ from previous frame.
+ * Build the histogram of a slice of f1, only for the pixels differing from
+ * f2 if it is set.
  */
-static int update_histogram_diff(struct hist_node *hist,
-                                 const AVFrame *f1, const AVFrame *f2, int use_alpha)
+static int update_histogram_slice(AVFilterContext *ctx, void *arg,
+                                  int jobnr, int nb_jobs)
 {
-    int x, y, ret, nb_diff_colors = 0;
+    PaletteGenContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const AVFrame *f1 = td->f1, *f2 = td->f2;
+    struct hist_shard *shard = &s->shards[jobnr];
+    const int slice_start = (f1->height *  jobnr   ) / nb_jobs;
+    const int slice_end   = (f1->height * (jobnr+1)) / nb_jobs;
+    int ret;
 
-    for (y = 0; y < f1->height; y++) {
+    if (!shard->table && (ret = shard_grow_table(shard)) < 0)
+        return ret;
+
+    for (int y = slice_start; y < slice_end; y++) {
         const uint32_t *p = (const uint32_t *)(f1->data[0] + y*f1->linesize[0]);
-        const uint32_t *q = (const uint32_t *)(f2->data[0] + y*f2->linesize[0]);
+        const uint32_t *q = f2 ? (const uint32_t *)(f2->data[0] + y*f2->linesize[0]) : NULL;
 
-        for (x = 0; x < f1->width; x++) {
-            if (p[x] == q[x])
+        for (int x = 0; x < f1->width; x++) {
+            if (q && p[x] == q[x])
                 continue;
-            ret = color_inc(hist, p[x], use_alpha);
+            ret = shard_inc(shard, p[x]);
             if (ret < 0)
                 return ret;
-            nb_diff_colors += ret;
         }
     }
-    return nb_diff_colors;
+    return 0;
 }
 
 /**
- * Simple histogram of the frame.
+ * Update the histogram with the pixels of f1, or only with the ones differing
+ * from f2 if it is set. The slices are hashed in parallel then merged in
+ * order, so that the colors are inserted in the same order as with a
+ * sequential scan and the resulting palette does not depend on the number
+ * of threads.
  */
-static int update_histogram_frame(struct hist_node *hist, const AVFrame *f, int use_alpha)
+static int update_histogram(AVFilterContext *ctx, const AVFrame *f1, const AVFrame *f2)
 {
-    int x, y, ret, nb_diff_colors = 0;
+    PaletteGenContext *s = ctx->priv;
+    const int nb_jobs = FFMIN(f1->height, s->nb_threads);
+    ThreadData td = { .f1 = f1, .f2 = f2 };
+    int ret = 0, nb_diff_colors = 0;
 
-    for (y = 0; y < f->height; y++) {
-        const uint32_t *p = (const uint32_t *)(f->data[0] + y*f->linesize[0]);
+    ff_filter_execute(ctx, update_histogram_slice, &td, s->job_ret, nb_jobs);
 
-        for (x = 0; x < f->width; x++) {
-            ret = color_inc(hist, p[x], use_alpha);
-            if (ret < 0)
-                return ret;
-            nb_diff_colors += ret;
+    for (int j = 0; j < nb_jobs; j++) {
+        struct hist_shard *shard = &s->shards[j];
+
+        if (s->job_ret[j] < 0)
+            ret = s->job_ret[j];
+
+        for (int i = 0; i < shard->nb_entries && ret >= 0; i++) {
+            const struct color_ref *e = &shard->entries[i];
+            ret = color_add(s->histogram, e->color, e->count, s->use_alpha);
+            if (ret > 0)
+                nb_diff_colors++;
+        }
+
+        /* Free the slots in reverse insertion order, so that the probe
+         * sequences of the remaining entries stay intact. */
+        for (int i = shard->nb_entries - 1; i >= 0; i--) {
+            const uint32_t mask = (1U << shard->table_bits) - 1;
+            uint32_t slot = shard_hash(shard->entries[i].color, shard->table_bits);
+            while (shard->table[slot] != i + 1)
+                slot = (slot + 1) & mask;
+            shard->table[slot] = 0;
         }
+        shard->nb_entries = 0;
     }
-    return nb_diff_colors;
+
+    return ret < 0 ? ret : nb_diff_colors;
 }
 
 /**
@@ -519,11 +645,14 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *in)
 {
     AVFilterContext *ctx = inlink->dst;
     PaletteGenContext *s = ctx->priv;
-    int ret = s->prev_frame ? update_histogram_diff(s->histogram, s->prev_frame, in, s->use_alpha)
-                            : update_histogram_frame(s->histogram, in, s->use_alpha);
+    int ret = s->prev_frame ? update_histogram(ctx, s->prev_frame, in)
+                            : update_histogram(ctx, in, NULL);
 
-    if (ret > 0)
-        s->nb_refs += ret;
+    if (ret < 0) {
+        av_frame_free(&in);
+        return ret;
+    }
+    s->nb_refs += ret;
 
     if (s->stats_mode == STATS_MODE_DIFF_FRAMES) {
         av_frame_free(&s->prev_frame);
@@ -569,6 +698,20 @@ static int request_frame(AVFilterLink *outlink)
     return r;
 }
 
+static int config_input(AVFilterLink *inlink)
+{
+    AVFilterContext *ctx = inlink->dst;
+    PaletteGenContext *s = ctx->priv;
+
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->shards  = av_calloc(s->nb_threads, sizeof(*s->shards));
+    s->job_ret = av_calloc(s->nb_threads, sizeof(*s->job_ret));
+    if (!s->shards || !s->job_ret)
+        return AVERROR(ENOMEM);
+
+    return 0;
+}
+
 /**
  * The output is one simple 16x16 squared-pixels palette.
  */
@@ -598,12 +741,20 @@ static av_cold void uninit(AVFilterContext *ctx)
         av_freep(&s->histogram[i].entries);
     av_freep(&s->refs);
     av_frame_free(&s->prev_frame);
+
+    for (i = 0; i < s->nb_threads && s->shards; i++) {
+        av_freep(&s->shards[i].entries);
+        av_freep(&s->shards[i].table);
+    }
+    av_freep(&s->shards);
+    av_freep(&s->job_ret);
 }
 
 static const AVFilterPad palettegen_inputs[] = {
     {
         .name         = "default",
         .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input,
         .filter_frame = filter_frame,
     },
 };
@@ -627,4 +778,5 @@ const AVFilter ff_vf_palettegen = {
     FILTER_OUTPUTS(palettegen_outputs),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &palettegen_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -25,11 +25,13 @@
 
 #include "libavutil/bprint.h"
 #include "libavutil/internal.h"
+#include "libavutil/mem_internal.h"
 #include "libavutil/opt.h"
 #include "libavutil/qsort.h"
 #include "avfilter.h"
 #include "framesync.h"
 #include "internal.h"
+#include "paletteuse.h"
 
 enum dithering_mode {
     DITHERING_NONE,
@@ -64,6 +66,10 @@ struct color_node {
 #define NBITS 5
 #define CACHE_SIZE (1<<(4*NBITS))
 
+/* the lookup table is filled by blocks of 8x8x8 colors */
+#define LUT_BLOCK_BITS 3
+#define LUT_NB_BLOCKS (1<<(3*(8-LUT_BLOCK_BITS)))
+
 struct cached_color {
     uint32_t color;
     uint8_t pal_entry;
@@ -76,15 +82,22 @@ struct cache_node {
 
 struct PaletteUseContext;
 
-typedef int (*set_frame_func)(struct PaletteUseContext *s, AVFrame *out, AVFrame *in,
+typedef int (*set_frame_func)(struct PaletteUseContext *s, struct cache_node *cache,
+                              AVFrame *out, AVFrame *in,
                               int x_start, int y_start, int width, int height);
 
 typedef struct PaletteUseContext {
     const AVClass *class;
     FFFrameSync fs;
-    struct cache_node cache[CACHE_SIZE];    /* lookup cache */
+    struct cache_node *cache;               /* lookup caches, one of CACHE_SIZE entries per slice job */
+    int nb_jobs;
     struct color_node map[AVPALETTE_COUNT]; /* 3D-Tree (KD-Tree with K=3) for reverse colormap */
     uint32_t palette[AVPALETTE_COUNT];
+    /* palette layout of the brute-force search, see PaletteUseDSPContext */
+    DECLARE_ALIGNED(32, int16_t, pal_rg)[2*AVPALETTE_COUNT];
+    DECLARE_ALIGNED(32, int16_t, pal_ba)[2*AVPALETTE_COUNT];
+    DECLARE_ALIGNED(32, int32_t, pal_skip)[AVPALETTE_COUNT];
+    PaletteUseDSPContext dsp;
     int transparency_index; /* index in the palette of transparency. -1 if there is no transparency in the palette. */
     int trans_thresh;
     int use_alpha;
@@ -97,6 +110,13 @@ typedef struct PaletteUseContext {
     int diff_mode;
     AVFrame *last_in;
     AVFrame *last_out;
+    int use_lut;
+    uint8_t *lut;           /* palette entry of each RGB color, for a static palette */
+    uint8_t *lut_filled;    /* whether each block of the lookup table is set */
+    uint8_t *lut_needed;    /* blocks used by the current frame, LUT_NB_BLOCKS per slice job */
+    int *lut_todo;          /* blocks to fill before mapping the current frame */
+    int nb_lut_todo;
+    int *job_ret;
 
     /* debug options */
     char *dot_filename;
@@ -121,6 +141,7 @@ static const AVOption paletteuse_options[] = {
     { "new", "take new palette for each output frame", OFFSET(new), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS },
     { "alpha_threshold", "set the alpha threshold for transparency", OFFSET(trans_thresh), AV_OPT_TYPE_INT, {.i64=128}, 0, 255, FLAGS },
     { "use_alpha", "use alpha channel for mapping", OFFSET(use_alpha), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS },
+    { "lut", "keep the palette entry of every color in a lookup table", OFFSET(use_lut), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS },
 
     /* following are the debug options, not part of the official API */
     { "debug_kdtree", "save Graphviz graph of the kdtree in specified file", OFFSET(dot_filename), AV_OPT_TYPE_STRING, {.str=NULL}, 0, 0, FLAGS },
@@ -182,28 +203,50 @@ static av_always_inline int diff(const uint8_t *c1, const uint8_t *c2, const Pal
     }
 }
 
-static av_always_inline uint8_t colormap_nearest_bruteforce(const PaletteUseContext *s, const uint8_t *argb)
+static int palette_nearest_c(const int16_t *pal_rg, const int16_t *pal_ba,
+                             const int32_t *skip, int rg, int ba)
 {
-    int i, pal_id = -1, min_dist = INT_MAX;
+    const int r = rg & 0xffff, g = rg >> 16;
+    const int b = ba & 0xffff, a = ba >> 16;
+    int i, min_key = INT_MAX;
 
     for (i = 0; i < AVPALETTE_COUNT; i++) {
-        const uint32_t c = s->palette[i];
+        const int dr = pal_rg[2*i    ] - r;
+        const int dg = pal_rg[2*i + 1] - g;
+        const int db = pal_ba[2*i    ] - b;
+        const int da = pal_ba[2*i + 1] - a;
+        const int key = (dr*dr + dg*dg + db*db + da*da) << 8 | i | skip[i];
 
-        if (s->use_alpha || c >> 24 >= s->trans_thresh) { // ignore transparent entry
-            const uint8_t palargb[] = {
-                s->palette[i]>>24 & 0xff,
-                s->palette[i]>>16 & 0xff,
-                s->palette[i]>> 8 & 0xff,
-                s->palette[i]     & 0xff,
-            };
-            const int d = diff(palargb, argb, s);
-            if (d < min_dist) {
-                pal_id = i;
-                min_dist = d;
-            }
-        }
+        min_key = FFMIN(min_key, key);
     }
-    return pal_id;
+    return min_key;
+}
+
+void ff_paletteuse_init(PaletteUseDSPContext *dsp)
+{
+    dsp->nearest = palette_nearest_c;
+#if ARCH_X86
+    ff_paletteuse_init_x86(dsp);
+#endif
+}
+
+static av_always_inline uint8_t colormap_nearest_bruteforce(const PaletteUseContext *s, const uint8_t *argb)
+{
+    int i, key;
+
+    if (!s->use_alpha && argb[0] < s->trans_thresh) {
+        /* all the opaque entries are at the same distance */
+        for (i = 0; i < AVPALETTE_COUNT; i++)
+            if (!s->pal_skip[i])
+                return i;
+        return -1;
+    }
+
+    /* without use_alpha, the alpha of the entries is set to 0 as well */
+    key = s->dsp.nearest(s->pal_rg, s->pal_ba, s->pal_skip,
+                         argb[1] | argb[2] << 16,
+                         argb[3] | (s->use_alpha ? argb[0] << 16 : 0));
+    return key == INT_MAX ? -1 : key & 0xff;
 }
 
 /* Recursive form, simpler but a bit slower. Kept for reference. */
@@ -338,7 +381,36 @@ end:
  * Note: a, r, g, and b are the components of color, but are passed as well to avoid
  * recomputing them (they are generally computed by the caller for other uses).
  */
-static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
+static av_always_inline int lut_block(uint32_t color)
+{
+    const int r = color >> (16 + LUT_BLOCK_BITS) & ((1 << (8 - LUT_BLOCK_BITS)) - 1);
+    const int g = color >> ( 8 + LUT_BLOCK_BITS) & ((1 << (8 - LUT_BLOCK_BITS)) - 1);
+    const int b = color >> (     LUT_BLOCK_BITS) & ((1 << (8 - LUT_BLOCK_BITS)) - 1);
+    return r << (2 * (8 - LUT_BLOCK_BITS)) | g << (8 - LUT_BLOCK_BITS) | b;
+}
+
+static void fill_lut_block(PaletteUseContext *s, int block)
+{
+    const int search = s->color_search_method;
+    const int bsize  = 1 << LUT_BLOCK_BITS;
+    const int rmask  = (1 << (8 - LUT_BLOCK_BITS)) - 1;
+    const int r0 = (block >> (2 * (8 - LUT_BLOCK_BITS))     ) << LUT_BLOCK_BITS;
+    const int g0 = (block >> (     8 - LUT_BLOCK_BITS) & rmask) << LUT_BLOCK_BITS;
+    const int b0 = (block                              & rmask) << LUT_BLOCK_BITS;
+
+    /* only opaque colors go through the table, the result only depends on
+     * their RGB components */
+    for (int r = r0; r < r0 + bsize; r++)
+        for (int g = g0; g < g0 + bsize; g++)
+            for (int b = b0; b < b0 + bsize; b++) {
+                const uint8_t argb[] = {0xff, r, g, b};
+                s->lut[r << 16 | g << 8 | b] = COLORMAP_NEAREST(s, search, s->map, argb);
+            }
+    s->lut_filled[block] = 1;
+}
+
+static av_always_inline int color_get(PaletteUseContext *s, struct cache_node *cache,
+                                      uint32_t color,
                                       uint8_t a, uint8_t r, uint8_t g, uint8_t b,
                                       const enum color_search_method search_method)
 {
@@ -348,7 +420,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     const uint8_t ghash = g & ((1<<NBITS)-1);
     const uint8_t bhash = b & ((1<<NBITS)-1);
     const unsigned hash = rhash<<(NBITS*2) | ghash<<NBITS | bhash;
-    struct cache_node *node = &s->cache[hash];
+    struct cache_node *node = &cache[hash];
     struct cached_color *e;
 
     // first, check for transparency
@@ -356,6 +428,13 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
         return s->transparency_index;
     }
 
+    if (s->lut && a >= s->trans_thresh) {
+        const int block = lut_block(color);
+        if (!s->lut_filled[block])
+            fill_lut_block(s, block);
+        return s->lut[color & 0xffffff];
+    }
+
     for (i = 0; i < node->nb_entries; i++) {
         e = &node->entries[i];
         if (e->color == color)
@@ -372,7 +451,7 @@ static av_always_inline int color_get(PaletteUseContext *s, uint32_t color,
     return e->pal_entry;
 }
 
-static av_always_inline int get_dst_color_err(PaletteUseContext *s,
+static av_always_inline int get_dst_color_err(PaletteUseContext *s, struct cache_node *cache,
                                               uint32_t c, int *ea, int *er, int *eg, int *eb,
                                               const enum color_search_method search_method)
 {
@@ -381,7 +460,7 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     const uint8_t g = c >>  8 & 0xff;
     const uint8_t b = c       & 0xff;
     uint32_t dstc;
-    const int dstx = color_get(s, c, a, r, g, b, search_method);
+    const int dstx = color_get(s, cache, c, a, r, g, b, search_method);
     if (dstx < 0)
         return dstx;
     dstc = s->palette[dstx];
@@ -396,7 +475,17 @@ static av_always_inline int get_dst_color_err(PaletteUseContext *s,
     return dstx;
 }
 
-static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFrame *in,
+static av_always_inline uint32_t bayer_color(const PaletteUseContext *s, uint32_t px, int x, int y)
+{
+    const int d = s->ordered_dither[(y & 7)<<3 | (x & 7)];
+    const uint8_t r = av_clip_uint8((px >> 16 & 0xff) + d);
+    const uint8_t g = av_clip_uint8((px >>  8 & 0xff) + d);
+    const uint8_t b = av_clip_uint8((px       & 0xff) + d);
+    return (px & 0xff000000) | r << 16 | g << 8 | b;
+}
+
+static av_always_inline int set_frame(PaletteUseContext *s, struct cache_node *cache,
+                                      AVFrame *out, AVFrame *in,
                                       int x_start, int y_start, int w, int h,
                                       enum dithering_mode dither,
                                       const enum color_search_method search_method)
@@ -415,16 +504,12 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             int ea, er, eg, eb;
 
             if (dither == DITHERING_BAYER) {
-                const int d = s->ordered_dither[(y & 7)<<3 | (x & 7)];
-                const uint8_t a8 = src[x] >> 24 & 0xff;
-                const uint8_t r8 = src[x] >> 16 & 0xff;
-                const uint8_t g8 = src[x] >>  8 & 0xff;
-                const uint8_t b8 = src[x]       & 0xff;
-                const uint8_t r = av_clip_uint8(r8 + d);
-                const uint8_t g = av_clip_uint8(g8 + d);
-                const uint8_t b = av_clip_uint8(b8 + d);
-                const uint32_t color_new = (unsigned)(a8) << 24 | r << 16 | g << 8 | b;
-                const int color = color_get(s, color_new, a8, r, g, b, search_method);
+                const uint32_t color_new = bayer_color(s, src[x], x, y);
+                const uint8_t a8 = color_new >> 24 & 0xff;
+                const uint8_t r  = color_new >> 16 & 0xff;
+                const uint8_t g  = color_new >>  8 & 0xff;
+                const uint8_t b  = color_new       & 0xff;
+                const int color = color_get(s, cache, color_new, a8, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -432,7 +517,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_HECKBERT) {
                 const int right = x < w - 1, down = y < h - 1;
-                const int color = get_dst_color_err(s, src[x], &ea, &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &ea, &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -444,7 +529,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_FLOYD_STEINBERG) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &ea, &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &ea, &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -458,7 +543,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
             } else if (dither == DITHERING_SIERRA2) {
                 const int right  = x < w - 1, down  = y < h - 1, left  = x > x_start;
                 const int right2 = x < w - 2,                    left2 = x > x_start + 1;
-                const int color = get_dst_color_err(s, src[x], &ea, &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &ea, &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -477,7 +562,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
 
             } else if (dither == DITHERING_SIERRA2_4A) {
                 const int right = x < w - 1, down = y < h - 1, left = x > x_start;
-                const int color = get_dst_color_err(s, src[x], &ea, &er, &eg, &eb, search_method);
+                const int color = get_dst_color_err(s, cache, src[x], &ea, &er, &eg, &eb, search_method);
 
                 if (color < 0)
                     return color;
@@ -492,7 +577,7 @@ static av_always_inline int set_frame(PaletteUseContext *s, AVFrame *out, AVFram
                 const uint8_t r = src[x] >> 16 & 0xff;
                 const uint8_t g = src[x] >>  8 & 0xff;
                 const uint8_t b = src[x]       & 0xff;
-                const int color = color_get(s, src[x], a, r, g, b, search_method);
+                const int color = color_get(s, cache, src[x], a, r, g, b, search_method);
 
                 if (color < 0)
                     return color;
@@ -794,6 +879,15 @@ static void load_colormap(PaletteUseContext *s)
 
     colormap_insert(s->map, color_used, &nb_used, s, &box);
 
+    for (i = 0; i < AVPALETTE_COUNT; i++) {
+        const uint32_t c = s->palette[i];
+        s->pal_rg[2*i    ] = c >> 16 & 0xff;
+        s->pal_rg[2*i + 1] = c >>  8 & 0xff;
+        s->pal_ba[2*i    ] = c       & 0xff;
+        s->pal_ba[2*i + 1] = s->use_alpha ? c >> 24 & 0xff : 0;
+        s->pal_skip[i]     = !s->use_alpha && c >> 24 < s->trans_thresh ? INT_MAX : 0;
+    }
+
     if (s->dot_filename)
         disp_tree(s->map, s->dot_filename);
 
@@ -924,6 +1018,96 @@ static void set_processing_window(enum diff_mode diff_mode,
     *hp = height;
 }
 
+typedef struct ThreadData {
+    AVFrame *in, *out;
+    int x, y, w, h;
+} ThreadData;
+
+static int mark_lut_blocks(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const int slice_start = td->y + (td->h *  jobnr   ) / nb_jobs;
+    const int slice_end   = td->y + (td->h * (jobnr+1)) / nb_jobs;
+    const int src_linesize = td->in->linesize[0] >> 2;
+    const uint32_t *src = (const uint32_t *)td->in->data[0] + slice_start * src_linesize;
+    uint8_t *needed = s->lut_needed + jobnr * LUT_NB_BLOCKS;
+
+    memset(needed, 0, LUT_NB_BLOCKS);
+    for (int y = slice_start; y < slice_end; y++) {
+        for (int x = td->x; x < td->x + td->w; x++) {
+            const uint32_t c = s->dither == DITHERING_BAYER ? bayer_color(s, src[x], x, y) : src[x];
+            if (c >> 24 >= s->trans_thresh)
+                needed[lut_block(c)] = 1;
+        }
+        src += src_linesize;
+    }
+    return 0;
+}
+
+static int fill_lut_blocks(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const int start = (s->nb_lut_todo *  jobnr   ) / nb_jobs;
+    const int end   = (s->nb_lut_todo * (jobnr+1)) / nb_jobs;
+
+    for (int i = start; i < end; i++)
+        fill_lut_block(s, s->lut_todo[i]);
+    return 0;
+}
+
+static int set_frame_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    PaletteUseContext *s = ctx->priv;
+    const ThreadData *td = arg;
+    const int slice_start = td->y + (td->h *  jobnr   ) / nb_jobs;
+    const int slice_end   = td->y + (td->h * (jobnr+1)) / nb_jobs;
+
+    return s->set_frame(s, s->cache + jobnr * CACHE_SIZE, td->out, td->in,
+                        td->x, slice_start, td->w, slice_end - slice_start);
+}
+
+/**
+ * Map the pixels of the processing window. Without error diffusion, the
+ * pixels are independent and the window is split among the slice threads,
+ * each with its own lookup cache. The blocks of the lookup table the frame
+ * needs are filled before, so that the threads only read the table.
+ */
+static int map_frame(AVFilterContext *ctx, AVFrame *out, AVFrame *in,
+                     int x, int y, int w, int h)
+{
+    PaletteUseContext *s = ctx->priv;
+    ThreadData td = { .in = in, .out = out, .x = x, .y = y, .w = w, .h = h };
+    const int nb_jobs = FFMIN(h, s->nb_jobs);
+
+    if (nb_jobs < 2 || (s->dither != DITHERING_NONE && s->dither != DITHERING_BAYER))
+        return s->set_frame(s, s->cache, out, in, x, y, w, h);
+
+    if (s->lut) {
+        ff_filter_execute(ctx, mark_lut_blocks, &td, NULL, nb_jobs);
+        s->nb_lut_todo = 0;
+        for (int b = 0; b < LUT_NB_BLOCKS; b++) {
+            if (s->lut_filled[b])
+                continue;
+            for (int j = 0; j < nb_jobs; j++) {
+                if (s->lut_needed[j * LUT_NB_BLOCKS + b]) {
+                    s->lut_todo[s->nb_lut_todo++] = b;
+                    break;
+                }
+            }
+        }
+        if (s->nb_lut_todo)
+            ff_filter_execute(ctx, fill_lut_blocks, NULL, NULL,
+                              FFMIN(s->nb_lut_todo, s->nb_jobs));
+    }
+
+    ff_filter_execute(ctx, set_frame_slice, &td, s->job_ret, nb_jobs);
+    for (int j = 0; j < nb_jobs; j++)
+        if (s->job_ret[j] < 0)
+            return s->job_ret[j];
+    return 0;
+}
+
 static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
 {
     int x, y, w, h, ret;
@@ -953,7 +1137,7 @@ static int apply_palette(AVFilterLink *inlink, AVFrame *in, AVFrame **outf)
     ff_dlog(ctx, "%dx%d rect: (%d;%d) -> (%d,%d) [area:%dx%d]\n",
             w, h, x, y, x+w, y+h, in->width, in->height);
 
-    ret = s->set_frame(s, out, in, x, y, w, h);
+    ret = map_frame(ctx, out, in, x, y, w, h);
     if (ret < 0) {
         av_frame_free(&out);
         *outf = NULL;
@@ -979,6 +1163,23 @@ static int config_output(AVFilterLink *outlink)
     s->fs.in[1].before = s->fs.in[1].after = EXT_INFINITY;
     s->fs.on_event = load_apply_palette;
 
+    if (!s->cache) {
+        s->nb_jobs = ff_filter_get_nb_threads(ctx);
+        s->cache   = av_calloc(s->nb_jobs * CACHE_SIZE, sizeof(*s->cache));
+        s->job_ret = av_calloc(s->nb_jobs, sizeof(*s->job_ret));
+        if (!s->cache || !s->job_ret)
+            return AVERROR(ENOMEM);
+    }
+
+    if (s->use_lut && !s->lut) {
+        s->lut        = av_malloc(1 << 24);
+        s->lut_filled = av_calloc(LUT_NB_BLOCKS, sizeof(*s->lut_filled));
+        s->lut_needed = av_calloc(s->nb_jobs, LUT_NB_BLOCKS);
+        s->lut_todo   = av_calloc(LUT_NB_BLOCKS, sizeof(*s->lut_todo));
+        if (!s->lut || !s->lut_filled || !s->lut_needed || !s->lut_todo)
+            return AVERROR(ENOMEM);
+    }
+
     outlink->w = ctx->inputs[0]->w;
     outlink->h = ctx->inputs[0]->h;
 
@@ -1014,9 +1215,9 @@ static void load_palette(PaletteUseContext *s, const AVFrame *palette_frame)
     if (s->new) {
         memset(s->palette, 0, sizeof(s->palette));
         memset(s->map, 0, sizeof(s->map));
-        for (i = 0; i < CACHE_SIZE; i++)
+        for (i = 0; i < s->nb_jobs * CACHE_SIZE; i++)
             av_freep(&s->cache[i].entries);
-        memset(s->cache, 0, sizeof(s->cache));
+        memset(s->cache, 0, s->nb_jobs * CACHE_SIZE * sizeof(*s->cache));
     }
 
     i = 0;
@@ -1064,10 +1265,12 @@ static int load_apply_palette(FFFrameSync *fs)
 }
 
 #define DEFINE_SET_FRAME(color_search, name, value)                             \
-static int set_frame_##name(PaletteUseContext *s, AVFrame *out, AVFrame *in,    \
+static int set_frame_##name(PaletteUseContext *s, struct cache_node *cache,     \
+                            AVFrame *out, AVFrame *in,                          \
                             int x_start, int y_start, int w, int h)             \
 {                                                                               \
-    return set_frame(s, out, in, x_start, y_start, w, h, value, color_search);  \
+    return set_frame(s, cache, out, in, x_start, y_start, w, h,                 \
+                     value, color_search);                                      \
 }
 
 #define DEFINE_SET_FRAME_COLOR_SEARCH(color_search, color_search_macro)                                 \
@@ -1115,6 +1318,13 @@ static av_cold int init(AVFilterContext *ctx)
         return AVERROR(ENOMEM);
 
     s->set_frame = set_frame_lut[s->color_search_method][s->dither];
+    ff_paletteuse_init(&s->dsp);
+
+    if (s->use_lut && (s->new || s->use_alpha)) {
+        av_log(ctx, AV_LOG_WARNING, "The lookup table needs a static palette "
+               "and is not used with new or use_alpha\n");
+        s->use_lut = 0;
+    }
 
     if (s->dither == DITHERING_BAYER) {
         int i;
@@ -1139,8 +1349,14 @@ static av_cold void uninit(AVFilterContext *ctx)
     PaletteUseContext *s = ctx->priv;
 
     ff_framesync_uninit(&s->fs);
-    for (i = 0; i < CACHE_SIZE; i++)
+    for (i = 0; i < s->nb_jobs * CACHE_SIZE && s->cache; i++)
         av_freep(&s->cache[i].entries);
+    av_freep(&s->cache);
+    av_freep(&s->job_ret);
+    av_freep(&s->lut);
+    av_freep(&s->lut_filled);
+    av_freep(&s->lut_needed);
+    av_freep(&s->lut_todo);
     av_frame_free(&s->last_in);
     av_frame_free(&s->last_out);
 }
@@ -1175,4 +1391,5 @@ const AVFilter ff_vf_paletteuse = {
     FILTER_OUTPUTS(paletteuse_outputs),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &paletteuse_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -0,0 +1,480 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Calculate several full reference quality metrics between two input videos
+ * in a single pass.
+ *
+ * Every plane is split in bands of 4 lines, the granularity of the SSIM
+ * block sums. Each band of both frames is consumed by all enabled metrics
+ * before moving on to the next one, so the input is only streamed from
+ * memory once no matter how many metrics are computed. The results are
+ * identical to the ones of the psnr and ssim filters.
+ */
+
+#include "libavutil/avstring.h"
+#include "libavutil/opt.h"
+#include "libavutil/pixdesc.h"
+#include "avfilter.h"
+#include "drawutils.h"
+#include "formats.h"
+#include "framesync.h"
+#include "internal.h"
+#include "psnr.h"
+#include "ssim.h"
+#include "video.h"
+
+enum Metric {
+    METRIC_PSNR = 1 << 0,
+    METRIC_SSIM = 1 << 1,
+};
+
+typedef struct QualityMetricsContext {
+    const AVClass *class;
+    FFFrameSync fs;
+    int metrics;
+    int nb_components;
+    int nb_threads;
+    int depth;
+    int max[4], average_max;
+    int is_rgb;
+    uint8_t rgba_map[4];
+    int planewidth[4];
+    int planeheight[4];
+    double planeweight[4];
+    uint64_t nb_frames;
+
+    double mse, min_mse, max_mse, mse_comp[4];
+    double ssim[4], ssim_total;
+
+    uint64_t **sse;
+    double **ssim_score;
+    void **temp;
+    PSNRDSPContext psnr_dsp;
+    SSIMDSPContext ssim_dsp;
+} QualityMetricsContext;
+
+#define OFFSET(x) offsetof(QualityMetricsContext, x)
+#define FLAGS AV_OPT_FLAG_FILTERING_PARAM|AV_OPT_FLAG_VIDEO_PARAM
+
+static const AVOption qualitymetrics_options[] = {
+    { "metrics", "set the metrics to compute", OFFSET(metrics), AV_OPT_TYPE_FLAGS, {.i64=METRIC_PSNR|METRIC_SSIM}, 0, METRIC_PSNR|METRIC_SSIM, FLAGS, "metrics" },
+        { "psnr", "peak signal to noise ratio", 0, AV_OPT_TYPE_CONST, {.i64=METRIC_PSNR}, 0, 0, FLAGS, "metrics" },
+        { "ssim", "structural similarity",      0, AV_OPT_TYPE_CONST, {.i64=METRIC_SSIM}, 0, 0, FLAGS, "metrics" },
+    { NULL }
+};
+
+FRAMESYNC_DEFINE_CLASS(qualitymetrics, QualityMetricsContext, fs);
+
+static inline unsigned pow_2(unsigned base)
+{
+    return base*base;
+}
+
+static inline double get_psnr(double mse, uint64_t nb_frames, int max)
+{
+    return 10.0 * log10(pow_2(max) / (mse / nb_frames));
+}
+
+static double ssim_db(double ssim, double weight)
+{
+    return (fabs(weight - ssim) > 1e-9) ? 10.0 * log10(weight / (weight - ssim)) : INFINITY;
+}
+
+static void set_meta(AVDictionary **metadata, const char *key, char comp, float d)
+{
+    char value[128];
+    snprintf(value, sizeof(value), "%f", d);
+    if (comp) {
+        char key2[128];
+        snprintf(key2, sizeof(key2), "%s%c", key, comp);
+        av_dict_set(metadata, key2, value, 0);
+    } else {
+        av_dict_set(metadata, key, value, 0);
+    }
+}
+
+#define SUM_LEN(w) (((w) >> 2) + 3)
+
+typedef struct ThreadData {
+    AVFrame *main, *ref;
+} ThreadData;
+
+static int compute_metrics(AVFilterContext *ctx, void *arg,
+                           int jobnr, int nb_jobs)
+{
+    QualityMetricsContext *s = ctx->priv;
+    ThreadData *td = arg;
+    const int do_psnr = s->metrics & METRIC_PSNR;
+    const int do_ssim = s->metrics & METRIC_SSIM;
+    const PSNRDSPContext *psnr_dsp = &s->psnr_dsp;
+    const SSIMDSPContext *ssim_dsp = &s->ssim_dsp;
+    void *temp = s->temp[jobnr];
+
+    for (int c = 0; c < s->nb_components; c++) {
+        const ptrdiff_t main_stride = td->main->linesize[c];
+        const ptrdiff_t ref_stride = td->ref->linesize[c];
+        const uint8_t *main_data = td->main->data[c];
+        const uint8_t *ref_data = td->ref->data[c];
+        const int w = s->planewidth[c];
+        const int h = s->planeheight[c];
+        const int bw = w >> 2;
+        const int slice_start = ((h >> 2) * jobnr) / nb_jobs;
+        const int slice_end = ((h >> 2) * (jobnr+1)) / nb_jobs;
+        /* The lines past the last complete band only count for PSNR. */
+        const int line_end = jobnr == nb_jobs - 1 ? h : 4 * slice_end;
+        const int ystart = FFMAX(1, slice_start);
+        void *sum0 = temp;
+        void *sum1 = (uint8_t *)temp + SUM_LEN(w) * (s->depth > 8 ? sizeof(int64_t[4]) : sizeof(int[4]));
+        uint64_t sse = 0;
+        double ssim = 0.0;
+
+        /* The band before the slice is only needed for the overlapping
+         * SSIM blocks, its lines belong to the previous slice for PSNR. */
+        for (int z = ystart - 1; z < slice_end; z++) {
+            const uint8_t *main_band = main_data + 4 * z * main_stride;
+            const uint8_t *ref_band = ref_data + 4 * z * ref_stride;
+
+            if (do_ssim) {
+                FFSWAP(void *, sum0, sum1);
+                if (s->depth > 8) {
+                    ff_ssim_4x4xn_16bit(main_band, main_stride, ref_band, ref_stride, sum0, bw);
+                    if (z >= ystart)
+                        ssim += ff_ssim_endn_16bit(sum0, sum1, bw - 1, s->max[0]);
+                } else {
+                    ssim_dsp->ssim_4x4_line(main_band, main_stride, ref_band, ref_stride, sum0, bw);
+                    if (z >= ystart)
+                        ssim += ssim_dsp->ssim_end_line(sum0, sum1, bw - 1);
+                }
+            }
+
+            if (do_psnr && z >= slice_start) {
+                for (int y = 0; y < 4; y++)
+                    sse += psnr_dsp->sse_line(main_band + y * main_stride,
+                                              ref_band + y * ref_stride, w);
+            }
+        }
+
+        if (do_psnr) {
+            for (int y = 4 * slice_end; y < line_end; y++)
+                sse += psnr_dsp->sse_line(main_data + y * main_stride,
+                                          ref_data + y * ref_stride, w);
+        }
+
+        s->sse[jobnr][c] = sse;
+        s->ssim_score[jobnr][c] = ssim;
+    }
+
+    return 0;
+}
+
+static void update_psnr(AVFilterContext *ctx, AVDictionary **metadata)
+{
+    static const char comps[2][4] = { "yuva", "rgba" };
+    QualityMetricsContext *s = ctx->priv;
+    double comp_mse[4], mse = 0.;
+    uint64_t comp_sum[4] = { 0 };
+
+    for (int j = 0; j < s->nb_threads; j++) {
+        for (int c = 0; c < s->nb_components; c++)
+            comp_sum[c] += s->sse[j][c];
+    }
+
+    for (int c = 0; c < s->nb_components; c++)
+        comp_mse[c] = comp_sum[c] / ((double)s->planewidth[c] * s->planeheight[c]);
+
+    for (int c = 0; c < s->nb_components; c++)
+        mse += comp_mse[c] * s->planeweight[c];
+
+    s->min_mse = FFMIN(s->min_mse, mse);
+    s->max_mse = FFMAX(s->max_mse, mse);
+    s->mse += mse;
+
+    for (int j = 0; j < s->nb_components; j++)
+        s->mse_comp[j] += comp_mse[j];
+
+    for (int j = 0; j < s->nb_components; j++) {
+        int c = s->is_rgb ? s->rgba_map[j] : j;
+        set_meta(metadata, "lavfi.psnr.mse.", comps[s->is_rgb][j], comp_mse[c]);
+        set_meta(metadata, "lavfi.psnr.psnr.", comps[s->is_rgb][j], get_psnr(comp_mse[c], 1, s->max[c]));
+    }
+    set_meta(metadata, "lavfi.psnr.mse_avg", 0, mse);
+    set_meta(metadata, "lavfi.psnr.psnr_avg", 0, get_psnr(mse, 1, s->average_max));
+}
+
+static void update_ssim(AVFilterContext *ctx, AVDictionary **metadata)
+{
+    static const char comps[2][4] = { "YUVA", "RGBA" };
+    QualityMetricsContext *s = ctx->priv;
+    double c[4] = { 0 }, ssimv = 0.0;
+
+    for (int i = 0; i < s->nb_components; i++) {
+        for (int j = 0; j < s->nb_threads; j++)
+            c[i] += s->ssim_score[j][i];
+        c[i] = c[i] / (((s->planewidth[i] >> 2) - 1) * ((s->planeheight[i] >> 2) - 1));
+    }
+
+    for (int i = 0; i < s->nb_components; i++) {
+        ssimv += s->planeweight[i] * c[i];
+        s->ssim[i] += c[i];
+    }
+    s->ssim_total += ssimv;
+
+    for (int i = 0; i < s->nb_components; i++) {
+        int cidx = s->is_rgb ? s->rgba_map[i] : i;
+        set_meta(metadata, "lavfi.ssim.", comps[s->is_rgb][i], c[cidx]);
+    }
+    set_meta(metadata, "lavfi.ssim.All", 0, ssimv);
+    set_meta(metadata, "lavfi.ssim.dB", 0, ssim_db(ssimv, 1.0));
+}
+
+static int do_qualitymetrics(FFFrameSync *fs)
+{
+    AVFilterContext *ctx = fs->parent;
+    QualityMetricsContext *s = ctx->priv;
+    AVFrame *master, *ref;
+    ThreadData td;
+    int ret;
+
+    ret = ff_framesync_dualinput_get(fs, &master, &ref);
+    if (ret < 0)
+        return ret;
+    if (ctx->is_disabled || !ref)
+        return ff_filter_frame(ctx->outputs[0], master);
+
+    td.main = master;
+    td.ref  = ref;
+    ff_filter_execute(ctx, compute_metrics, &td, NULL,
+                      FFMIN((s->planeheight[1] + 3) >> 2, s->nb_threads));
+
+    if (s->metrics & METRIC_PSNR)
+        update_psnr(ctx, &master->metadata);
+    if (s->metrics & METRIC_SSIM)
+        update_ssim(ctx, &master->metadata);
+    s->nb_frames++;
+
+    return ff_filter_frame(ctx->outputs[0], master);
+}
+
+static av_cold int init(AVFilterContext *ctx)
+{
+    QualityMetricsContext *s = ctx->priv;
+
+    if (!s->metrics) {
+        av_log(ctx, AV_LOG_ERROR, "No metric selected.\n");
+        return AVERROR(EINVAL);
+    }
+
+    s->min_mse = +INFINITY;
+    s->max_mse = -INFINITY;
+
+    s->fs.on_event = do_qualitymetrics;
+    return 0;
+}
+
+static const enum AVPixelFormat pix_fmts[] = {
+    AV_PIX_FMT_GRAY8, AV_PIX_FMT_GRAY9, AV_PIX_FMT_GRAY10,
+    AV_PIX_FMT_GRAY12, AV_PIX_FMT_GRAY14, AV_PIX_FMT_GRAY16,
+    AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV444P,
+    AV_PIX_FMT_YUV440P, AV_PIX_FMT_YUV411P, AV_PIX_FMT_YUV410P,
+    AV_PIX_FMT_YUVJ411P, AV_PIX_FMT_YUVJ420P, AV_PIX_FMT_YUVJ422P,
+    AV_PIX_FMT_YUVJ440P, AV_PIX_FMT_YUVJ444P,
+    AV_PIX_FMT_GBRP,
+#define PF(suf) AV_PIX_FMT_YUV420##suf,  AV_PIX_FMT_YUV422##suf,  AV_PIX_FMT_YUV444##suf, AV_PIX_FMT_GBR##suf
+    PF(P9), PF(P10), PF(P12), PF(P14), PF(P16),
+    AV_PIX_FMT_NONE
+};
+
+static int config_input_ref(AVFilterLink *inlink)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(inlink->format);
+    AVFilterContext *ctx  = inlink->dst;
+    QualityMetricsContext *s = ctx->priv;
+    double average_max = 0;
+    unsigned sum = 0;
+
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->nb_components = desc->nb_components;
+    s->depth = desc->comp[0].depth;
+
+    if (ctx->inputs[0]->w != ctx->inputs[1]->w ||
+        ctx->inputs[0]->h != ctx->inputs[1]->h) {
+        av_log(ctx, AV_LOG_ERROR, "Width and height of input videos must be same.\n");
+        return AVERROR(EINVAL);
+    }
+
+    for (int i = 0; i < 4; i++)
+        s->max[i] = (1 << desc->comp[i].depth) - 1;
+
+    s->is_rgb = ff_fill_rgba_map(s->rgba_map, inlink->format) >= 0;
+
+    s->planeheight[1] = s->planeheight[2] = AV_CEIL_RSHIFT(inlink->h, desc->log2_chroma_h);
+    s->planeheight[0] = s->planeheight[3] = inlink->h;
+    s->planewidth[1]  = s->planewidth[2]  = AV_CEIL_RSHIFT(inlink->w, desc->log2_chroma_w);
+    s->planewidth[0]  = s->planewidth[3]  = inlink->w;
+    for (int i = 0; i < s->nb_components; i++)
+        sum += s->planeheight[i] * s->planewidth[i];
+    for (int i = 0; i < s->nb_components; i++) {
+        s->planeweight[i] = (double) s->planeheight[i] * s->planewidth[i] / sum;
+        average_max += s->max[i] * s->planeweight[i];
+    }
+    s->average_max = lrint(average_max);
+
+    ff_psnr_init(&s->psnr_dsp, s->depth);
+    ff_ssim_init(&s->ssim_dsp);
+
+    s->sse        = av_calloc(s->nb_threads, sizeof(*s->sse));
+    s->ssim_score = av_calloc(s->nb_threads, sizeof(*s->ssim_score));
+    s->temp       = av_calloc(s->nb_threads, sizeof(*s->temp));
+    if (!s->sse || !s->ssim_score || !s->temp)
+        return AVERROR(ENOMEM);
+
+    for (int t = 0; t < s->nb_threads; t++) {
+        s->sse[t]        = av_calloc(s->nb_components, sizeof(*s->sse[0]));
+        s->ssim_score[t] = av_calloc(s->nb_components, sizeof(*s->ssim_score[0]));
+        s->temp[t]       = av_calloc(2 * SUM_LEN(inlink->w),
+                                     s->depth > 8 ? sizeof(int64_t[4]) : sizeof(int[4]));
+        if (!s->sse[t] || !s->ssim_score[t] || !s->temp[t])
+            return AVERROR(ENOMEM);
+    }
+
+    return 0;
+}
+
+static int config_output(AVFilterLink *outlink)
+{
+    AVFilterContext *ctx = outlink->src;
+    QualityMetricsContext *s = ctx->priv;
+    AVFilterLink *mainlink = ctx->inputs[0];
+    int ret;
+
+    ret = ff_framesync_init_dualinput(&s->fs, ctx);
+    if (ret < 0)
+        return ret;
+    outlink->w = mainlink->w;
+    outlink->h = mainlink->h;
+    outlink->time_base = mainlink->time_base;
+    outlink->sample_aspect_ratio = mainlink->sample_aspect_ratio;
+    outlink->frame_rate = mainlink->frame_rate;
+
+    if ((ret = ff_framesync_configure(&s->fs)) < 0)
+        return ret;
+
+    outlink->time_base = s->fs.time_base;
+
+    if (av_cmp_q(mainlink->time_base, outlink->time_base) ||
+        av_cmp_q(ctx->inputs[1]->time_base, outlink->time_base))
+        av_log(ctx, AV_LOG_WARNING, "not matching timebases found between first input: %d/%d and second input %d/%d, results may be incorrect!\n",
+               mainlink->time_base.num, mainlink->time_base.den,
+               ctx->inputs[1]->time_base.num, ctx->inputs[1]->time_base.den);
+
+    return 0;
+}
+
+static int activate(AVFilterContext *ctx)
+{
+    QualityMetricsContext *s = ctx->priv;
+    return ff_framesync_activate(&s->fs);
+}
+
+static av_cold void uninit(AVFilterContext *ctx)
+{
+    QualityMetricsContext *s = ctx->priv;
+
+    if (s->nb_frames > 0 && s->metrics & METRIC_PSNR) {
+        static const char comps[2][4] = { "yuva", "rgba" };
+        char buf[256];
+
+        buf[0] = 0;
+        for (int j = 0; j < s->nb_components; j++) {
+            int c = s->is_rgb ? s->rgba_map[j] : j;
+            av_strlcatf(buf, sizeof(buf), " %c:%f", comps[s->is_rgb][j],
+                        get_psnr(s->mse_comp[c], s->nb_frames, s->max[c]));
+        }
+        av_log(ctx, AV_LOG_INFO, "PSNR%s average:%f min:%f max:%f\n",
+               buf,
+               get_psnr(s->mse, s->nb_frames, s->average_max),
+               get_psnr(s->max_mse, 1, s->average_max),
+               get_psnr(s->min_mse, 1, s->average_max));
+    }
+
+    if (s->nb_frames > 0 && s->metrics & METRIC_SSIM) {
+        static const char comps[2][4] = { "YUVA", "RGBA" };
+        char buf[256];
+
+        buf[0] = 0;
+        for (int i = 0; i < s->nb_components; i++) {
+            int c = s->is_rgb ? s->rgba_map[i] : i;
+            av_strlcatf(buf, sizeof(buf), " %c:%f (%f)", comps[s->is_rgb][i],
+                        s->ssim[c] / s->nb_frames, ssim_db(s->ssim[c], s->nb_frames));
+        }
+        av_log(ctx, AV_LOG_INFO, "SSIM%s All:%f (%f)\n", buf,
+               s->ssim_total / s->nb_frames, ssim_db(s->ssim_total, s->nb_frames));
+    }
+
+    ff_framesync_uninit(&s->fs);
+
+    for (int t = 0; t < s->nb_threads; t++) {
+        if (s->sse)
+            av_freep(&s->sse[t]);
+        if (s->ssim_score)
+            av_freep(&s->ssim_score[t]);
+        if (s->temp)
+            av_freep(&s->temp[t]);
+    }
+    av_freep(&s->sse);
+    av_freep(&s->ssim_score);
+    av_freep(&s->temp);
+}
+
+static const AVFilterPad qualitymetrics_inputs[] = {
+    {
+        .name         = "main",
+        .type         = AVMEDIA_TYPE_VIDEO,
+    },{
+        .name         = "reference",
+        .type         = AVMEDIA_TYPE_VIDEO,
+        .config_props = config_input_ref,
+    },
+};
+
+static const AVFilterPad qualitymetrics_outputs[] = {
+    {
+        .name          = "default",
+        .type          = AVMEDIA_TYPE_VIDEO,
+        .config_props  = config_output,
+    },
+};
+
+const AVFilter ff_vf_qualitymetrics = {
+    .name          = "qualitymetrics",
+    .description   = NULL_IF_CONFIG_SMALL("Calculate PSNR and SSIM between two video streams in a single pass."),
+    .preinit       = qualitymetrics_framesync_preinit,
+    .init          = init,
+    .uninit        = uninit,
+    .activate      = activate,
+    .priv_size     = sizeof(QualityMetricsContext),
+    .priv_class    = &qualitymetrics_class,
+    FILTER_INPUTS(qualitymetrics_inputs),
+    FILTER_OUTPUTS(qualitymetrics_outputs),
+    FILTER_PIXFMTS_ARRAY(pix_fmts),
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_INTERNAL |
+                     AVFILTER_FLAG_SLICE_THREADS             |
+                     AVFILTER_FLAG_METADATA_ONLY,
+};
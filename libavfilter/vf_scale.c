@@ -141,6 +141,9 @@ typedef struct ScaleContext {
     int in_frame_range;
     int out_range;
 
+    int in_frame_primaries;
+    int in_frame_trc;
+
     int out_h_chr_pos;
     int out_v_chr_pos;
     int in_h_chr_pos;
@@ -151,6 +154,8 @@ typedef struct ScaleContext {
 
     int eval_mode;              ///< expression evaluation mode
 
+    int apply_cropping;         ///< scale only the area left by the frame cropping fields
+
 } ScaleContext;
 
 const AVFilter ff_vf_scale2ref;
@@ -323,7 +328,9 @@ static av_cold int init_dict(AVFilterContext *ctx, AVDictionary **opts)
     scale->opts = *opts;
     *opts = NULL;
 
-    scale->in_frame_range = AVCOL_RANGE_UNSPECIFIED;
+    scale->in_frame_range     = AVCOL_RANGE_UNSPECIFIED;
+    scale->in_frame_primaries = AVCOL_PRI_UNSPECIFIED;
+    scale->in_frame_trc       = AVCOL_TRC_UNSPECIFIED;
 
     return 0;
 }
@@ -521,7 +528,9 @@ static int config_props(AVFilterLink *outlink)
         inlink0->h == outlink->h &&
         !scale->out_color_matrix &&
         scale->in_range == scale->out_range &&
-        inlink0->format == outlink->format)
+        inlink0->format == outlink->format &&
+        !av_dict_get(scale->opts, "dst_primaries", NULL, 0) &&
+        !av_dict_get(scale->opts, "dst_trc", NULL, 0))
         ;
     else {
         struct SwsContext **swscs[3] = {&scale->sws, &scale->isws[0], &scale->isws[1]};
@@ -553,6 +562,12 @@ static int config_props(AVFilterLink *outlink)
             if (scale->out_range != AVCOL_RANGE_UNSPECIFIED)
                 av_opt_set_int(s, "dst_range",
                                scale->out_range == AVCOL_RANGE_JPEG, 0);
+            // the source side of a primaries or transfer conversion comes
+            // from the frames unless set explicitly in the options below
+            if (scale->in_frame_primaries != AVCOL_PRI_UNSPECIFIED)
+                av_opt_set_int(s, "src_primaries", scale->in_frame_primaries, 0);
+            if (scale->in_frame_trc != AVCOL_TRC_UNSPECIFIED)
+                av_opt_set_int(s, "src_trc", scale->in_frame_trc, 0);
 
             if (scale->opts) {
                 AVDictionaryEntry *e = NULL;
@@ -685,11 +700,23 @@ static int scale_frame(AVFilterLink *link, AVFrame *in, AVFrame **frame_out)
     int ret;
     int in_range;
     int frame_changed;
+    int64_t color;
 
     *frame_out = NULL;
     if (in->colorspace == AVCOL_SPC_YCGCO)
         av_log(link->dst, AV_LOG_WARNING, "Detected unsupported YCgCo colorspace.\n");
 
+    /* only move the data pointers, so that the scaler never reads the
+     * cropped out pixels; the input size below is the cropped size */
+    if (scale->apply_cropping &&
+        (in->crop_top || in->crop_bottom || in->crop_left || in->crop_right)) {
+        ret = av_frame_apply_cropping(in, AV_FRAME_CROP_UNALIGNED);
+        if (ret < 0) {
+            av_log(ctx, AV_LOG_WARNING, "Invalid cropping information set on the frame, ignoring it\n");
+            in->crop_top = in->crop_bottom = in->crop_left = in->crop_right = 0;
+        }
+    }
+
     frame_changed = in->width  != link->w ||
                     in->height != link->h ||
                     in->format != link->format ||
@@ -703,6 +730,13 @@ static int scale_frame(AVFilterLink *link, AVFrame *in, AVFrame **frame_out)
         frame_changed = 1;
     }
 
+    if (in->color_primaries != scale->in_frame_primaries ||
+        in->color_trc       != scale->in_frame_trc) {
+        scale->in_frame_primaries = in->color_primaries;
+        scale->in_frame_trc       = in->color_trc;
+        frame_changed = 1;
+    }
+
     if (scale->eval_mode == EVAL_MODE_FRAME || frame_changed) {
         unsigned vars_w[VARS_NB] = { 0 }, vars_h[VARS_NB] = { 0 };
 
@@ -785,6 +819,17 @@ scale:
     else if (out->colorspace == AVCOL_SPC_RGB)
         out->colorspace = AVCOL_SPC_UNSPECIFIED;
 
+    // Primaries and transfer conversion is configured through the generic
+    // swscale options, only retag the frame if swscale did convert it.
+    if (!av_opt_get_int(scale->sws, "color_convert", 0, &color) && color) {
+        if (!av_opt_get_int(scale->sws, "dst_primaries", 0, &color) &&
+            color != AVCOL_PRI_UNSPECIFIED)
+            out->color_primaries = color;
+        if (!av_opt_get_int(scale->sws, "dst_trc", 0, &color) &&
+            color != AVCOL_TRC_UNSPECIFIED)
+            out->color_trc = color;
+    }
+
     if (scale->output_is_pal)
         avpriv_set_systematic_pal2((uint32_t*)out->data[1], outlink->format == AV_PIX_FMT_PAL8 ? AV_PIX_FMT_BGR8 : outlink->format);
 
@@ -974,6 +1019,7 @@ static const AVOption scale_options[] = {
     { "eval", "specify when to evaluate expressions", OFFSET(eval_mode), AV_OPT_TYPE_INT, {.i64 = EVAL_MODE_INIT}, 0, EVAL_MODE_NB-1, FLAGS, "eval" },
          { "init",  "eval expressions once during initialization", 0, AV_OPT_TYPE_CONST, {.i64=EVAL_MODE_INIT},  .flags = FLAGS, .unit = "eval" },
          { "frame", "eval expressions during initialization and per-frame", 0, AV_OPT_TYPE_CONST, {.i64=EVAL_MODE_FRAME}, .flags = FLAGS, .unit = "eval" },
+    { "apply_cropping", "scale only the part of the frame left by its cropping fields", OFFSET(apply_cropping), AV_OPT_TYPE_BOOL, { .i64 = 1 }, 0, 1, FLAGS },
     { NULL }
 };
 
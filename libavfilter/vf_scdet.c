@@ -28,6 +28,7 @@
 
 #include "avfilter.h"
 #include "filters.h"
+#include "internal.h"
 #include "scene_sad.h"
 
 typedef struct SCDetContext {
@@ -43,8 +44,15 @@ typedef struct SCDetContext {
     AVFrame *prev_picref;
     double threshold;
     int sc_pass;
+
+    int nb_threads;
+    uint64_t *sads;              ///< SAD of each slice
 } SCDetContext;
 
+typedef struct ThreadData {
+    AVFrame *prev, *frame;
+} ThreadData;
+
 #define OFFSET(x) offsetof(SCDetContext, x)
 #define V AV_OPT_FLAG_VIDEO_PARAM
 #define F AV_OPT_FLAG_FILTERING_PARAM
@@ -94,6 +102,11 @@ static int config_input(AVFilterLink *inlink)
     if (!s->sad)
         return AVERROR(EINVAL);
 
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->sads = av_calloc(s->nb_threads, sizeof(*s->sads));
+    if (!s->sads)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -102,6 +115,34 @@ static av_cold void uninit(AVFilterContext *ctx)
     SCDetContext *s = ctx->priv;
 
     av_frame_free(&s->prev_picref);
+    av_freep(&s->sads);
+}
+
+static int sad_slice(AVFilterContext *ctx, void *arg, int jobnr, int nb_jobs)
+{
+    SCDetContext *s = ctx->priv;
+    ThreadData *td = arg;
+    AVFrame *prev = td->prev;
+    AVFrame *frame = td->frame;
+    uint64_t sad = 0;
+
+    for (int plane = 0; plane < s->nb_planes; plane++) {
+        const ptrdiff_t slice_start = (s->height[plane] *  jobnr   ) / nb_jobs;
+        const ptrdiff_t slice_end   = (s->height[plane] * (jobnr+1)) / nb_jobs;
+        uint64_t plane_sad;
+
+        if (slice_end <= slice_start)
+            continue;
+        s->sad(prev->data[plane] + slice_start * prev->linesize[plane],
+               prev->linesize[plane],
+               frame->data[plane] + slice_start * frame->linesize[plane],
+               frame->linesize[plane],
+               s->width[plane], slice_end - slice_start, &plane_sad);
+        sad += plane_sad;
+    }
+    s->sads[jobnr] = sad;
+
+    return 0;
 }
 
 static double get_scene_score(AVFilterContext *ctx, AVFrame *frame)
@@ -112,18 +153,18 @@ static double get_scene_score(AVFilterContext *ctx, AVFrame *frame)
 
     if (prev_picref && frame->height == prev_picref->height
                     && frame->width  == prev_picref->width) {
+        ThreadData td = { .prev = prev_picref, .frame = frame };
+        const int nb_jobs = FFMIN(s->height[0], s->nb_threads);
         uint64_t sad = 0;
         double mafd, diff;
         uint64_t count = 0;
 
-        for (int plane = 0; plane < s->nb_planes; plane++) {
-            uint64_t plane_sad;
-            s->sad(prev_picref->data[plane], prev_picref->linesize[plane],
-                    frame->data[plane], frame->linesize[plane],
-                    s->width[plane], s->height[plane], &plane_sad);
-            sad += plane_sad;
+        ff_filter_execute(ctx, sad_slice, &td, NULL, nb_jobs);
+
+        for (int i = 0; i < nb_jobs; i++)
+            sad += s->sads[i];
+        for (int plane = 0; plane < s->nb_planes; plane++)
             count += s->width[plane] * s->height[plane];
-        }
 
         emms_c();
         mafd = (double)sad * 100. / count / (1ULL << s->bitdepth);
@@ -206,7 +247,7 @@ const AVFilter ff_vf_scdet = {
     .priv_size     = sizeof(SCDetContext),
     .priv_class    = &scdet_class,
     .uninit        = uninit,
-    .flags         = AVFILTER_FLAG_METADATA_ONLY,
+    .flags         = AVFILTER_FLAG_METADATA_ONLY | AVFILTER_FLAG_SLICE_THREADS,
     FILTER_INPUTS(scdet_inputs),
     FILTER_OUTPUTS(scdet_outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
@@ -45,6 +45,12 @@ typedef struct ThumbContext {
     int n_frames;               ///< number of frames for analysis
     struct thumb_frame *frames; ///< the n_frames frames
     AVRational tb;              ///< copy of the input timebase to ease access
+    int lowmem;                 ///< only keep the best frame so far
+    int best_frame_idx;         ///< index in the batch of the frame kept in lowmem mode
+    double sum_hist[HIST_SIZE]; ///< sum of the histograms of the batch in lowmem mode
+
+    int nb_threads;
+    int *thread_histogram;      ///< histograms of the slices of the current frame
 
     int planewidth[4];
     int planeheight[4];
@@ -55,6 +61,7 @@ typedef struct ThumbContext {
 
 static const AVOption thumbnail_options[] = {
     { "n", "set the frames batch size", OFFSET(n_frames), AV_OPT_TYPE_INT, {.i64=100}, 2, INT_MAX, FLAGS },
+    { "lowmem", "compare against the running average and only keep the best frame", OFFSET(lowmem), AV_OPT_TYPE_BOOL, {.i64=0}, 0, 1, FLAGS },
     { NULL }
 };
 
@@ -64,7 +71,7 @@ static av_cold int init(AVFilterContext *ctx)
 {
     ThumbContext *s = ctx->priv;
 
-    s->frames = av_calloc(s->n_frames, sizeof(*s->frames));
+    s->frames = av_calloc(s->lowmem ? 2 : s->n_frames, sizeof(*s->frames));
     if (!s->frames) {
         av_log(ctx, AV_LOG_ERROR,
                "Allocation failure, try to lower the number of frames\n");
@@ -92,6 +99,22 @@ static double frame_sum_square_err(const int *hist, const double *median)
     return sum_sq_err;
 }
 
+static AVFrame *get_lowmem_best_frame(AVFilterContext *ctx)
+{
+    ThumbContext *s = ctx->priv;
+    AVFrame *picref = s->frames[0].buf;
+
+    av_log(ctx, AV_LOG_INFO, "frame id #%d (pts_time=%f) selected "
+           "from a set of %d images\n", s->best_frame_idx,
+           picref->pts * av_q2d(s->tb), s->n);
+
+    s->frames[0].buf = NULL;
+    memset(s->sum_hist, 0, sizeof(s->sum_hist));
+    s->n = 0;
+
+    return picref;
+}
+
 static AVFrame *get_best_frame(AVFilterContext *ctx)
 {
     AVFrame *picref;
@@ -100,6 +123,9 @@ static AVFrame *get_best_frame(AVFilterContext *ctx)
     int nb_frames = s->n;
     double avg_hist[HIST_SIZE] = {0}, sq_err, min_sq_err = -1;
 
+    if (s->lowmem)
+        return get_lowmem_best_frame(ctx);
+
     // average histogram of the N frames
     for (j = 0; j < FF_ARRAY_ELEMS(avg_hist); j++) {
         for (i = 0; i < nb_frames; i++)
@@ -132,24 +158,25 @@ static AVFrame *get_best_frame(AVFilterContext *ctx)
     return picref;
 }
 
-static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+static int compute_histogram(AVFilterContext *ctx, void *arg,
+                             int jobnr, int nb_jobs)
 {
-    int i, j;
-    AVFilterContext *ctx  = inlink->dst;
-    ThumbContext *s   = ctx->priv;
-    AVFilterLink *outlink = ctx->outputs[0];
-    int *hist = s->frames[s->n].histogram;
-    const uint8_t *p = frame->data[0];
+    ThumbContext *s = ctx->priv;
+    AVFrame *frame = arg;
+    int *hist = s->thread_histogram + jobnr * HIST_SIZE;
+    const int h = frame->height;
+    const int w = frame->width;
+    const int slice_start = (h * jobnr) / nb_jobs;
+    const int slice_end = (h * (jobnr+1)) / nb_jobs;
+    const uint8_t *p = frame->data[0] + slice_start * frame->linesize[0];
 
-    // keep a reference of each frame
-    s->frames[s->n].buf = frame;
+    memset(hist, 0, HIST_SIZE * sizeof(*hist));
 
-    // update current frame histogram
-    switch (inlink->format) {
+    switch (frame->format) {
     case AV_PIX_FMT_RGB24:
     case AV_PIX_FMT_BGR24:
-        for (j = 0; j < inlink->h; j++) {
-            for (i = 0; i < inlink->w; i++) {
+        for (int j = slice_start; j < slice_end; j++) {
+            for (int i = 0; i < w; i++) {
                 hist[0*256 + p[i*3    ]]++;
                 hist[1*256 + p[i*3 + 1]]++;
                 hist[2*256 + p[i*3 + 2]]++;
@@ -161,8 +188,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
     case AV_PIX_FMT_BGR0:
     case AV_PIX_FMT_RGBA:
     case AV_PIX_FMT_BGRA:
-        for (j = 0; j < inlink->h; j++) {
-            for (i = 0; i < inlink->w; i++) {
+        for (int j = slice_start; j < slice_end; j++) {
+            for (int i = 0; i < w; i++) {
                 hist[0*256 + p[i*4    ]]++;
                 hist[1*256 + p[i*4 + 1]]++;
                 hist[2*256 + p[i*4 + 2]]++;
@@ -174,8 +201,8 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
     case AV_PIX_FMT_0BGR:
     case AV_PIX_FMT_ARGB:
     case AV_PIX_FMT_ABGR:
-        for (j = 0; j < inlink->h; j++) {
-            for (i = 0; i < inlink->w; i++) {
+        for (int j = slice_start; j < slice_end; j++) {
+            for (int i = 0; i < w; i++) {
                 hist[0*256 + p[i*4 + 1]]++;
                 hist[1*256 + p[i*4 + 2]]++;
                 hist[2*256 + p[i*4 + 3]]++;
@@ -185,9 +212,11 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
         break;
     default:
         for (int plane = 0; plane < 3; plane++) {
-            const uint8_t *p = frame->data[plane];
-            for (j = 0; j < s->planeheight[plane]; j++) {
-                for (i = 0; i < s->planewidth[plane]; i++)
+            const int plane_start = (s->planeheight[plane] * jobnr) / nb_jobs;
+            const int plane_end = (s->planeheight[plane] * (jobnr+1)) / nb_jobs;
+            const uint8_t *p = frame->data[plane] + plane_start * frame->linesize[plane];
+            for (int j = plane_start; j < plane_end; j++) {
+                for (int i = 0; i < s->planewidth[plane]; i++)
                     hist[256*plane + p[i]]++;
                 p += frame->linesize[plane];
             }
@@ -195,8 +224,64 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
         break;
     }
 
+    return 0;
+}
+
+/**
+ * In lowmem mode, keep either the current best frame or the new one,
+ * whichever is closer to the average histogram of the frames seen so far.
+ */
+static void update_lowmem_best_frame(ThumbContext *s)
+{
+    struct thumb_frame *best = &s->frames[0];
+    struct thumb_frame *cur  = &s->frames[1];
+    double best_err = 0, cur_err = 0;
+
+    for (int j = 0; j < HIST_SIZE; j++) {
+        const double avg = s->sum_hist[j] / s->n;
+        best_err += (avg - best->histogram[j]) * (avg - best->histogram[j]);
+        cur_err  += (avg - cur->histogram[j])  * (avg - cur->histogram[j]);
+    }
+
+    if (!best->buf || cur_err < best_err) {
+        av_frame_free(&best->buf);
+        best->buf = cur->buf;
+        memcpy(best->histogram, cur->histogram, sizeof(best->histogram));
+        s->best_frame_idx = s->n - 1;
+    } else {
+        av_frame_free(&cur->buf);
+    }
+    cur->buf = NULL;
+}
+
+static int filter_frame(AVFilterLink *inlink, AVFrame *frame)
+{
+    AVFilterContext *ctx  = inlink->dst;
+    ThumbContext *s   = ctx->priv;
+    AVFilterLink *outlink = ctx->outputs[0];
+    struct thumb_frame *cur = &s->frames[s->lowmem ? 1 : s->n];
+    const int nb_jobs = FFMIN(inlink->h, s->nb_threads);
+    int *hist = cur->histogram;
+
+    // keep a reference of each frame
+    cur->buf = frame;
+
+    // update current frame histogram
+    ff_filter_execute(ctx, compute_histogram, frame, NULL, nb_jobs);
+    for (int i = 0; i < HIST_SIZE; i++) {
+        int sum = 0;
+        for (int j = 0; j < nb_jobs; j++)
+            sum += s->thread_histogram[j * HIST_SIZE + i];
+        hist[i] = sum;
+    }
+
     // no selection until the buffer of N frames is filled up
     s->n++;
+    if (s->lowmem) {
+        for (int i = 0; i < HIST_SIZE; i++)
+            s->sum_hist[i] += hist[i];
+        update_lowmem_best_frame(s);
+    }
     if (s->n < s->n_frames)
         return 0;
 
@@ -207,9 +292,10 @@ static av_cold void uninit(AVFilterContext *ctx)
 {
     int i;
     ThumbContext *s = ctx->priv;
-    for (i = 0; i < s->n_frames && s->frames && s->frames[i].buf; i++)
+    for (i = 0; i < (s->lowmem ? 2 : s->n_frames) && s->frames && s->frames[i].buf; i++)
         av_frame_free(&s->frames[i].buf);
     av_freep(&s->frames);
+    av_freep(&s->thread_histogram);
 }
 
 static int request_frame(AVFilterLink *link)
@@ -241,6 +327,11 @@ static int config_props(AVFilterLink *inlink)
     s->planeheight[1] = s->planeheight[2] = AV_CEIL_RSHIFT(inlink->h, desc->log2_chroma_h);
     s->planeheight[0] = s->planeheight[3] = inlink->h;
 
+    s->nb_threads = ff_filter_get_nb_threads(ctx);
+    s->thread_histogram = av_calloc(HIST_SIZE, s->nb_threads * sizeof(*s->thread_histogram));
+    if (!s->thread_histogram)
+        return AVERROR(ENOMEM);
+
     return 0;
 }
 
@@ -288,5 +379,6 @@ const AVFilter ff_vf_thumbnail = {
     FILTER_OUTPUTS(thumbnail_outputs),
     FILTER_PIXFMTS_ARRAY(pix_fmts),
     .priv_class    = &thumbnail_class,
-    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC,
+    .flags         = AVFILTER_FLAG_SUPPORT_TIMELINE_GENERIC |
+                     AVFILTER_FLAG_SLICE_THREADS,
 };
@@ -46,6 +46,7 @@ typedef struct TileContext {
     AVFrame *out_ref;
     AVFrame *prev_out_ref;
     uint8_t rgba_color[4];
+    int nb_threads;
 } TileContext;
 
 #define OFFSET(x) offsetof(TileContext, x)
@@ -141,10 +142,86 @@ static int config_props(AVFilterLink *outlink)
                                    av_make_q(1, tile->nb_frames - tile->overlap));
     ff_draw_init(&tile->draw, inlink->format, 0);
     ff_draw_color(&tile->draw, &tile->blank, tile->rgba_color);
+    tile->nb_threads = ff_filter_get_nb_threads(ctx);
 
     return 0;
 }
 
+typedef struct ThreadData {
+    AVFrame *dst, *src;
+    unsigned dst_x, dst_y, src_x, src_y;
+    unsigned w, h;
+} ThreadData;
+
+/* Slices are cut on chroma line boundaries so that they cover exactly the
+ * same lines of every plane as a single call would. */
+static void get_slice(const TileContext *tile, unsigned h, int jobnr, int nb_jobs,
+                      unsigned *start, unsigned *end)
+{
+    const int vsub = tile->draw.vsub_max;
+    const unsigned nb_lines = AV_CEIL_RSHIFT(h, vsub);
+
+    *start = (nb_lines *  jobnr   ) / nb_jobs << vsub;
+    *end   = (nb_lines * (jobnr+1)) / nb_jobs << vsub;
+    *end   = FFMIN(*end, h);
+}
+
+static int copy_rectangle_slice(AVFilterContext *ctx, void *arg,
+                                int jobnr, int nb_jobs)
+{
+    TileContext *tile = ctx->priv;
+    const ThreadData *td = arg;
+    unsigned start, end;
+
+    get_slice(tile, td->h, jobnr, nb_jobs, &start, &end);
+    if (start < end)
+        ff_copy_rectangle2(&tile->draw,
+                           td->dst->data, td->dst->linesize,
+                           td->src->data, td->src->linesize,
+                           td->dst_x, td->dst_y + start,
+                           td->src_x, td->src_y + start,
+                           td->w, end - start);
+    return 0;
+}
+
+static int fill_rectangle_slice(AVFilterContext *ctx, void *arg,
+                                int jobnr, int nb_jobs)
+{
+    TileContext *tile = ctx->priv;
+    const ThreadData *td = arg;
+    unsigned start, end;
+
+    get_slice(tile, td->h, jobnr, nb_jobs, &start, &end);
+    if (start < end)
+        ff_fill_rectangle(&tile->draw, &tile->blank,
+                          td->dst->data, td->dst->linesize,
+                          td->dst_x, td->dst_y + start,
+                          td->w, end - start);
+    return 0;
+}
+
+static void copy_rectangle(AVFilterContext *ctx, AVFrame *dst, AVFrame *src,
+                           unsigned dst_x, unsigned dst_y,
+                           unsigned src_x, unsigned src_y,
+                           unsigned w, unsigned h)
+{
+    TileContext *tile = ctx->priv;
+    ThreadData td = { dst, src, dst_x, dst_y, src_x, src_y, w, h };
+
+    ff_filter_execute(ctx, copy_rectangle_slice, &td, NULL,
+                      FFMIN(AV_CEIL_RSHIFT(h, tile->draw.vsub_max), tile->nb_threads));
+}
+
+static void fill_rectangle(AVFilterContext *ctx, AVFrame *dst,
+                           unsigned x, unsigned y, unsigned w, unsigned h)
+{
+    TileContext *tile = ctx->priv;
+    ThreadData td = { .dst = dst, .dst_x = x, .dst_y = y, .w = w, .h = h };
+
+    ff_filter_execute(ctx, fill_rectangle_slice, &td, NULL,
+                      FFMIN(AV_CEIL_RSHIFT(h, tile->draw.vsub_max), tile->nb_threads));
+}
+
 static void get_tile_pos(AVFilterContext *ctx, unsigned *x, unsigned *y, unsigned current)
 {
     TileContext *tile    = ctx->priv;
@@ -163,9 +240,7 @@ static void draw_blank_frame(AVFilterContext *ctx, AVFrame *out_buf)
     unsigned x0, y0;
 
     get_tile_pos(ctx, &x0, &y0, tile->current);
-    ff_fill_rectangle(&tile->draw, &tile->blank,
-                      out_buf->data, out_buf->linesize,
-                      x0, y0, inlink->w, inlink->h);
+    fill_rectangle(ctx, out_buf, x0, y0, inlink->w, inlink->h);
     tile->current++;
 }
 
@@ -211,10 +286,7 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
 
         /* fill surface once for margin/padding */
         if (tile->margin || tile->padding || tile->init_padding)
-            ff_fill_rectangle(&tile->draw, &tile->blank,
-                              tile->out_ref->data,
-                              tile->out_ref->linesize,
-                              0, 0, outlink->w, outlink->h);
+            fill_rectangle(ctx, tile->out_ref, 0, 0, outlink->w, outlink->h);
         tile->init_padding = 0;
     }
 
@@ -224,19 +296,14 @@ static int filter_frame(AVFilterLink *inlink, AVFrame *picref)
         for (i = tile->nb_frames - tile->overlap; i < tile->nb_frames; i++) {
             get_tile_pos(ctx, &x1, &y1, i);
             get_tile_pos(ctx, &x0, &y0, i - (tile->nb_frames - tile->overlap));
-            ff_copy_rectangle2(&tile->draw,
-                               tile->out_ref->data, tile->out_ref->linesize,
-                               tile->prev_out_ref->data, tile->prev_out_ref->linesize,
-                               x0, y0, x1, y1, inlink->w, inlink->h);
+            copy_rectangle(ctx, tile->out_ref, tile->prev_out_ref,
+                           x0, y0, x1, y1, inlink->w, inlink->h);
 
         }
     }
 
     get_tile_pos(ctx, &x0, &y0, tile->current);
-    ff_copy_rectangle2(&tile->draw,
-                       tile->out_ref->data, tile->out_ref->linesize,
-                       picref->data, picref->linesize,
-                       x0, y0, 0, 0, inlink->w, inlink->h);
+    copy_rectangle(ctx, tile->out_ref, picref, x0, y0, 0, 0, inlink->w, inlink->h);
 
     av_frame_free(&picref);
     if (++tile->current == tile->nb_frames)
@@ -293,4 +360,5 @@ const AVFilter ff_vf_tile = {
     FILTER_OUTPUTS(tile_outputs),
     FILTER_QUERY_FUNC(query_formats),
     .priv_class    = &tile_class,
+    .flags         = AVFILTER_FLAG_SLICE_THREADS,
 };
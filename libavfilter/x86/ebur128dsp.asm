@@ -0,0 +1,348 @@
+;*****************************************************************************
+;* x86-optimized functions for EBU R128 loudness metering
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+%if ARCH_X86_64
+
+SECTION_RODATA 32
+
+pd_abs: times 4 dq 0x7fffffffffffffff
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; void ff_ebur128_filter_channels(const EBUR128Biquad *filters, double *state,
+;                                 const double *samples,
+;                                 double *cache_400, double *cache_3000,
+;                                 double *sum_400, double *sum_3000,
+;                                 int nb_channels)
+;------------------------------------------------------------------------------
+
+; same operation order as the C version, so that the results are identical
+%macro FILTER_CHANNELS 2 ; load/store suffix, arithmetic suffix
+    mov%1      R0, [samplesq + iq]                  ; x[i]
+    mul%2      R1, R0, C0
+    mul%2      R2, C1, [stateq + iq]                ; x[i-1]
+    add%2      R1, R1, R2
+    mul%2      R2, C2, [stateq + strideq + iq]      ; x[i-2]
+    add%2      R1, R1, R2
+    mov%1      R3, [y1q + iq]                       ; y[i-1]
+    mul%2      R2, R3, C3
+    sub%2      R1, R1, R2
+    mov%1      R4, [y1q + strideq + iq]             ; y[i-2]
+    mul%2      R2, R4, C4
+    sub%2      R1, R1, R2                           ; y[i]
+    mov%1      R2, [stateq + iq]
+    mov%1      [stateq + strideq + iq], R2
+    mov%1      [stateq + iq], R0
+    mov%1      [y1q + strideq + iq], R3
+    mov%1      [y1q + iq], R1
+    mul%2      R0, R1, C5
+    mul%2      R2, R3, C6
+    add%2      R0, R0, R2
+    mul%2      R2, R4, C7
+    add%2      R0, R0, R2
+    mov%1      R3, [z1q + iq]                       ; z[i-1]
+    mul%2      R2, R3, C8
+    sub%2      R0, R0, R2
+    mul%2      R2, C9, [z1q + strideq + iq]         ; z[i-2]
+    sub%2      R0, R0, R2                           ; z[i]
+    mov%1      [z1q + strideq + iq], R3
+    mov%1      [z1q + iq], R0
+    mul%2      R0, R0, R0                           ; bin
+    mov%1      R1, [s400q + iq]
+    add%2      R1, R1, R0
+    sub%2      R1, R1, [c400q + iq]
+    mov%1      [s400q + iq], R1
+    mov%1      R1, [s3000q + iq]
+    add%2      R1, R1, R0
+    sub%2      R1, R1, [c3000q + iq]
+    mov%1      [s3000q + iq], R1
+    mov%1      [c400q + iq], R0
+    mov%1      [c3000q + iq], R0
+%endmacro
+
+INIT_YMM avx
+cglobal ebur128_filter_channels, 8, 11, 16, filters, state, samples, c400, c3000, s400, s3000, stride, i, y1, z1
+    movsxdifnidn strideq, strided
+    shl        strideq, 3
+    VBROADCASTSD m6,  [filtersq + 0*8]
+    VBROADCASTSD m7,  [filtersq + 1*8]
+    VBROADCASTSD m8,  [filtersq + 2*8]
+    VBROADCASTSD m9,  [filtersq + 3*8]
+    VBROADCASTSD m10, [filtersq + 4*8]
+    VBROADCASTSD m11, [filtersq + 5*8]
+    VBROADCASTSD m12, [filtersq + 6*8]
+    VBROADCASTSD m13, [filtersq + 7*8]
+    VBROADCASTSD m14, [filtersq + 8*8]
+    VBROADCASTSD m15, [filtersq + 9*8]
+    lea        y1q, [stateq + strideq*2]
+    lea        z1q, [stateq + strideq*4]
+    xor        iq, iq
+
+%define R0 m0
+%define R1 m1
+%define R2 m2
+%define R3 m3
+%define R4 m4
+%define C0 m6
+%define C1 m7
+%define C2 m8
+%define C3 m9
+%define C4 m10
+%define C5 m11
+%define C6 m12
+%define C7 m13
+%define C8 m14
+%define C9 m15
+.loop:
+    lea        filtersq, [iq + mmsize]
+    cmp        filtersq, strideq
+    jg .tail
+    FILTER_CHANNELS u, pd
+    add        iq, mmsize
+    jmp .loop
+
+%define R0 xm0
+%define R1 xm1
+%define R2 xm2
+%define R3 xm3
+%define R4 xm4
+%define C0 xm6
+%define C1 xm7
+%define C2 xm8
+%define C3 xm9
+%define C4 xm10
+%define C5 xm11
+%define C6 xm12
+%define C7 xm13
+%define C8 xm14
+%define C9 xm15
+.tail:
+    cmp        iq, strideq
+    jge .end
+    FILTER_CHANNELS sd, sd
+    add        iq, 8
+    jmp .tail
+.end:
+    RET
+
+;------------------------------------------------------------------------------
+; void ff_ebur128_filter(const double *b, const double *a, double *state,
+;                        double *dst, const double *src,
+;                        int nb_samples, int nb_channels)
+;------------------------------------------------------------------------------
+
+; filter the channels starting at byte offset i for all samples, with the same
+; operation order as the C version
+%macro FILTER 2 ; load/store suffix, arithmetic suffix
+    lea        aq, [stateq + iq]
+    mov%1      V1, [aq]
+    mov%1      V2, [aq + strideq]
+    mov%1      V3, [aq + strideq*2]
+    mov%1      V4, [aq + bq]
+    lea        sptrq, [srcq + iq]
+    lea        dptrq, [dstq + iq]
+    mov        nd, lend
+%%samples:
+    mov%1      R0, [sptrq]
+    mul%2      R1, A1, V1
+    sub%2      R0, R0, R1
+    mul%2      R1, A2, V2
+    sub%2      R0, R0, R1
+    mul%2      R1, A3, V3
+    sub%2      R0, R0, R1
+    mul%2      R1, A4, V4
+    sub%2      R0, R0, R1                           ; v[i]
+    mul%2      R1, B0, R0
+    mul%2      R2, B1, V1
+    add%2      R1, R1, R2
+    mul%2      R2, B2, V2
+    add%2      R1, R1, R2
+    mul%2      R2, B3, V3
+    add%2      R1, R1, R2
+    mul%2      R2, B4, V4
+    add%2      R1, R1, R2
+    mov%1      [dptrq], R1
+    mova       V4, V3
+    mova       V3, V2
+    mova       V2, V1
+    mova       V1, R0
+    add        sptrq, strideq
+    add        dptrq, strideq
+    dec        nd
+    jg %%samples
+    mov%1      [aq], V1
+    mov%1      [aq + strideq], V2
+    mov%1      [aq + strideq*2], V3
+    mov%1      [aq + bq], V4
+%endmacro
+
+INIT_YMM avx
+cglobal ebur128_filter, 7, 11, 16, b, a, state, dst, src, len, stride, i, n, sptr, dptr
+    test       lend, lend
+    jle .end
+    movsxdifnidn strideq, strided
+    shl        strideq, 3
+    VBROADCASTSD m7,  [bq + 0*8]
+    VBROADCASTSD m8,  [bq + 1*8]
+    VBROADCASTSD m9,  [bq + 2*8]
+    VBROADCASTSD m10, [bq + 3*8]
+    VBROADCASTSD m11, [bq + 4*8]
+    VBROADCASTSD m12, [aq + 1*8]
+    VBROADCASTSD m13, [aq + 2*8]
+    VBROADCASTSD m14, [aq + 3*8]
+    VBROADCASTSD m15, [aq + 4*8]
+    lea        bq, [strideq*3]
+    xor        iq, iq
+
+%define V1 m0
+%define V2 m1
+%define V3 m2
+%define V4 m3
+%define R0 m4
+%define R1 m5
+%define R2 m6
+%define B0 m7
+%define B1 m8
+%define B2 m9
+%define B3 m10
+%define B4 m11
+%define A1 m12
+%define A2 m13
+%define A3 m14
+%define A4 m15
+.loop:
+    lea        aq, [iq + mmsize]
+    cmp        aq, strideq
+    jg .tail
+    FILTER u, pd
+    add        iq, mmsize
+    jmp .loop
+
+%define V1 xm0
+%define V2 xm1
+%define V3 xm2
+%define V4 xm3
+%define R0 xm4
+%define R1 xm5
+%define R2 xm6
+%define B0 xm7
+%define B1 xm8
+%define B2 xm9
+%define B3 xm10
+%define B4 xm11
+%define A1 xm12
+%define A2 xm13
+%define A3 xm14
+%define A4 xm15
+.tail:
+    cmp        iq, strideq
+    jge .end
+    FILTER sd, sd
+    add        iq, 8
+    jmp .tail
+.end:
+    RET
+
+;------------------------------------------------------------------------------
+; void ff_ebur128_true_peak_<factor>x(double *peaks, const double *coeffs,
+;                                     const double *src, int nb_samples,
+;                                     int nb_channels)
+;------------------------------------------------------------------------------
+
+; one register holds all phases of a tap, m4-m15 hold the 12 taps
+%macro TAP 2 ; coefficients, sample
+    VBROADCASTSD m0, %2
+    mulpd      m0, m0, %1
+    addpd      m1, m1, m0
+%endmacro
+
+%macro TRUE_PEAK 1 ; factor
+cglobal ebur128_true_peak_%1x, 5, 10, 16, peaks, coeffs, src, len, nch, stride, stride3, ptr, ptr4, n
+    test       lend, lend
+    jle .end
+    movsxdifnidn nchq, nchd
+    lea        strideq, [nchq*8]
+    lea        stride3q, [strideq*3]
+    movu       m4,  [coeffsq +  0*mmsize]
+    movu       m5,  [coeffsq +  1*mmsize]
+    movu       m6,  [coeffsq +  2*mmsize]
+    movu       m7,  [coeffsq +  3*mmsize]
+    movu       m8,  [coeffsq +  4*mmsize]
+    movu       m9,  [coeffsq +  5*mmsize]
+    movu       m10, [coeffsq +  6*mmsize]
+    movu       m11, [coeffsq +  7*mmsize]
+    movu       m12, [coeffsq +  8*mmsize]
+    movu       m13, [coeffsq +  9*mmsize]
+    movu       m14, [coeffsq + 10*mmsize]
+    movu       m15, [coeffsq + 11*mmsize]
+.chloop:
+    VBROADCASTSD m2, [peaksq]
+    mov        ptrq, srcq
+    mov        nd, lend
+.loop:
+    lea        ptr4q, [ptrq + strideq*4]
+    VBROADCASTSD m0, [ptrq]
+    mulpd      m1, m0, m4
+    TAP        m5,  [ptrq + strideq]
+    TAP        m6,  [ptrq + strideq*2]
+    TAP        m7,  [ptrq + stride3q]
+    TAP        m8,  [ptr4q]
+    TAP        m9,  [ptr4q + strideq]
+    TAP        m10, [ptr4q + strideq*2]
+    TAP        m11, [ptr4q + stride3q]
+    lea        ptr4q, [ptr4q + strideq*4]
+    TAP        m12, [ptr4q]
+    TAP        m13, [ptr4q + strideq]
+    TAP        m14, [ptr4q + strideq*2]
+    VBROADCASTSD m0, [ptr4q + stride3q]             ; newest input sample
+    mulpd      m3, m0, m15
+    addpd      m1, m1, m3
+    andpd      m0, m0, [pd_abs]
+    andpd      m1, m1, [pd_abs]
+    maxpd      m2, m2, m0
+    maxpd      m2, m2, m1
+    add        ptrq, strideq
+    dec        nd
+    jg .loop
+
+%if mmsize == 32
+    vextractf128 xm0, m2, 1
+    maxpd      xm2, xm2, xm0
+%endif
+    unpckhpd   xm0, xm2, xm2
+    maxsd      xm2, xm2, xm0
+    movsd      [peaksq], xm2
+    add        peaksq, 8
+    add        srcq, 8
+    dec        nchq
+    jg .chloop
+.end:
+    RET
+%endmacro
+
+INIT_XMM avx
+TRUE_PEAK 2
+INIT_YMM avx
+TRUE_PEAK 4
+
+%endif ; ARCH_X86_64
@@ -0,0 +1,48 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "config.h"
+#include "libavutil/attributes.h"
+#include "libavutil/cpu.h"
+#include "libavutil/x86/cpu.h"
+#include "libavfilter/ebur128dsp.h"
+
+void ff_ebur128_filter_channels_avx(const EBUR128Biquad *filters, double *state,
+                                    const double *samples,
+                                    double *cache_400, double *cache_3000,
+                                    double *sum_400, double *sum_3000,
+                                    int nb_channels);
+void ff_ebur128_filter_avx(const double *b, const double *a, double *state,
+                           double *dst, const double *src,
+                           int nb_samples, int nb_channels);
+void ff_ebur128_true_peak_4x_avx(double *peaks, const double *coeffs,
+                                 const double *src, int nb_samples, int nb_channels);
+void ff_ebur128_true_peak_2x_avx(double *peaks, const double *coeffs,
+                                 const double *src, int nb_samples, int nb_channels);
+
+av_cold void ff_ebur128_dsp_init_x86(EBUR128DSPContext *dsp)
+{
+    int cpu_flags = av_get_cpu_flags();
+
+    if (ARCH_X86_64 && EXTERNAL_AVX_FAST(cpu_flags)) {
+        dsp->filter_channels = ff_ebur128_filter_channels_avx;
+        dsp->filter          = ff_ebur128_filter_avx;
+        dsp->true_peak_4x    = ff_ebur128_true_peak_4x_avx;
+        dsp->true_peak_2x    = ff_ebur128_true_peak_2x_avx;
+    }
+}
@@ -0,0 +1,92 @@
+;*****************************************************************************
+;* x86-optimized functions for paletteuse filter
+;*
+;* This file is part of FFmpeg.
+;*
+;* FFmpeg is free software; you can redistribute it and/or
+;* modify it under the terms of the GNU Lesser General Public
+;* License as published by the Free Software Foundation; either
+;* version 2.1 of the License, or (at your option) any later version.
+;*
+;* FFmpeg is distributed in the hope that it will be useful,
+;* but WITHOUT ANY WARRANTY; without even the implied warranty of
+;* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+;* Lesser General Public License for more details.
+;*
+;* You should have received a copy of the GNU Lesser General Public
+;* License along with FFmpeg; if not, write to the Free Software
+;* Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+;******************************************************************************
+
+%include "libavutil/x86/x86util.asm"
+
+SECTION_RODATA 32
+
+pd_0to7: dd 0, 1, 2, 3, 4, 5, 6, 7
+pd_4:    times 8 dd 4
+pd_8:    times 8 dd 8
+
+SECTION .text
+
+;------------------------------------------------------------------------------
+; int ff_palette_nearest(const int16_t *pal_rg, const int16_t *pal_ba,
+;                        const int32_t *skip, int rg, int ba)
+;
+; Each entry gets the key distance << 8 | index, or INT_MAX if skipped, so
+; that the minimum key gives both the nearest entry and the lowest index.
+;------------------------------------------------------------------------------
+
+%macro PALETTE_NEAREST 0
+cglobal palette_nearest, 5, 6, 7, pal_rg, pal_ba, skip, rg, ba, i
+    movd         xm0, rgd
+    movd         xm1, bad
+%if cpuflag(avx2)
+    vpbroadcastd  m0, xm0
+    vpbroadcastd  m1, xm1
+    mova          m3, [pd_8]
+%else
+    pshufd        m0, m0, 0
+    pshufd        m1, m1, 0
+    mova          m3, [pd_4]
+%endif
+    mova          m2, [pd_0to7]
+    pcmpeqd       m4, m4
+    psrld         m4, 1
+    xor           id, id
+
+.loop:
+    mova          m5, [pal_rgq + 4*iq]
+    mova          m6, [pal_baq + 4*iq]
+    psubw         m5, m0
+    psubw         m6, m1
+    pmaddwd       m5, m5
+    pmaddwd       m6, m6
+    paddd         m5, m6
+    pslld         m5, 8
+    por           m5, m2
+    por           m5, [skipq + 4*iq]
+    pminsd        m4, m5
+    paddd         m2, m3
+    add           id, mmsize / 4
+    cmp           id, 256
+    jl .loop
+
+%if cpuflag(avx2)
+    vextracti128 xm5, m4, 1
+    pminsd       xm4, xm5
+%endif
+    pshufd       xm5, xm4, q1032
+    pminsd       xm4, xm5
+    pshufd       xm5, xm4, q2301
+    pminsd       xm4, xm5
+    movd         eax, xm4
+    RET
+%endmacro
+
+INIT_XMM sse4
+PALETTE_NEAREST
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+PALETTE_NEAREST
+%endif
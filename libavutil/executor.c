@@ -0,0 +1,280 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "cpu.h"
+#include "error.h"
+#include "executor.h"
+#include "internal.h"
+#include "mem.h"
+#include "thread.h"
+
+#if HAVE_THREADS
+
+typedef struct Batch {
+    av_executor_func *func;
+    void             *arg;
+    int              *rets;
+    int               nb_jobs;
+    int               max_threads;
+
+    int               next_job;
+    int               nb_done;
+    /* threads currently running jobs of this batch, including the caller */
+    int               nb_threads;
+
+    struct Batch     *next;
+} Batch;
+
+typedef struct Worker {
+    AVExecutor       *e;
+    pthread_t         thread;
+
+    /* batch the worker is running jobs of, and its threadnr in it */
+    Batch            *batch;
+    int               threadnr;
+} Worker;
+
+struct AVExecutor {
+    Worker           *workers;
+    int               nb_threads;
+
+    /* everything below is protected by mutex */
+    pthread_mutex_t   mutex;
+    pthread_cond_t    work_cond;
+    pthread_cond_t    done_cond;
+    Batch            *batches;
+    int               finished;
+};
+
+static void remove_batch(AVExecutor *e, Batch *b)
+{
+    Batch **p = &e->batches;
+
+    while (*p && *p != b)
+        p = &(*p)->next;
+    if (*p)
+        *p = b->next;
+}
+
+/**
+ * Run jobs of b until there is none left. Must be called with e->mutex
+ * held, which is released while the jobs themselves run.
+ */
+static void run_jobs(AVExecutor *e, Batch *b, int threadnr)
+{
+    while (b->next_job < b->nb_jobs) {
+        int jobnr = b->next_job++, ret;
+
+        /* stop handing out this batch once its last job is taken */
+        if (b->next_job == b->nb_jobs)
+            remove_batch(e, b);
+
+        pthread_mutex_unlock(&e->mutex);
+        ret = b->func(b->arg, jobnr, threadnr);
+        if (b->rets)
+            b->rets[jobnr] = ret;
+        pthread_mutex_lock(&e->mutex);
+
+        if (++b->nb_done == b->nb_jobs)
+            pthread_cond_broadcast(&e->done_cond);
+    }
+}
+
+/**
+ * Lowest threadnr not used by a thread currently working on b. The caller
+ * of av_executor_execute() always holds 0.
+ */
+static int get_threadnr(const AVExecutor *e, const Batch *b)
+{
+    int threadnr = 1;
+
+    for (int i = 0; i < e->nb_threads; i++) {
+        if (e->workers[i].batch == b && e->workers[i].threadnr == threadnr) {
+            threadnr++;
+            i = -1;
+        }
+    }
+    return threadnr;
+}
+
+static void *attribute_align_arg executor_worker(void *arg)
+{
+    Worker     *w = arg;
+    AVExecutor *e = w->e;
+
+    pthread_mutex_lock(&e->mutex);
+    while (!e->finished) {
+        Batch *b = e->batches;
+
+        while (b && b->max_threads && b->nb_threads >= b->max_threads)
+            b = b->next;
+        if (!b) {
+            pthread_cond_wait(&e->work_cond, &e->mutex);
+            continue;
+        }
+
+        w->threadnr = get_threadnr(e, b);
+        w->batch    = b;
+        b->nb_threads++;
+        run_jobs(e, b, w->threadnr);
+        b->nb_threads--;
+        w->batch    = NULL;
+    }
+    pthread_mutex_unlock(&e->mutex);
+
+    return NULL;
+}
+
+int av_executor_alloc(AVExecutor **pe, int nb_threads)
+{
+    AVExecutor *e;
+    int ret;
+
+    if (nb_threads < 0)
+        return AVERROR(EINVAL);
+    if (!nb_threads)
+        nb_threads = av_cpu_count();
+
+    e = av_mallocz(sizeof(*e));
+    if (!e)
+        return AVERROR(ENOMEM);
+    e->workers = av_calloc(nb_threads, sizeof(*e->workers));
+    if (!e->workers) {
+        av_free(e);
+        return AVERROR(ENOMEM);
+    }
+
+    if ((ret = pthread_mutex_init(&e->mutex, NULL))) {
+        av_free(e->workers);
+        av_free(e);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&e->work_cond, NULL))) {
+        pthread_mutex_destroy(&e->mutex);
+        av_free(e->workers);
+        av_free(e);
+        return AVERROR(ret);
+    }
+    if ((ret = pthread_cond_init(&e->done_cond, NULL))) {
+        pthread_cond_destroy(&e->work_cond);
+        pthread_mutex_destroy(&e->mutex);
+        av_free(e->workers);
+        av_free(e);
+        return AVERROR(ret);
+    }
+
+    *pe = e;
+    for (; e->nb_threads < nb_threads; e->nb_threads++) {
+        Worker *w = &e->workers[e->nb_threads];
+
+        w->e = e;
+        ret = pthread_create(&w->thread, NULL, executor_worker, w);
+        if (ret) {
+            av_executor_free(pe);
+            return AVERROR(ret);
+        }
+    }
+
+    return 0;
+}
+
+void av_executor_free(AVExecutor **pe)
+{
+    AVExecutor *e = *pe;
+
+    if (!e)
+        return;
+
+    pthread_mutex_lock(&e->mutex);
+    e->finished = 1;
+    pthread_cond_broadcast(&e->work_cond);
+    pthread_mutex_unlock(&e->mutex);
+
+    for (int i = 0; i < e->nb_threads; i++)
+        pthread_join(e->workers[i].thread, NULL);
+
+    pthread_cond_destroy(&e->done_cond);
+    pthread_cond_destroy(&e->work_cond);
+    pthread_mutex_destroy(&e->mutex);
+    av_freep(&e->workers);
+    av_freep(pe);
+}
+
+int av_executor_get_nb_threads(const AVExecutor *e)
+{
+    return e->nb_threads;
+}
+
+void av_executor_execute(AVExecutor *e, av_executor_func *func, void *arg,
+                         int *rets, int nb_jobs, int max_threads)
+{
+    Batch b = {
+        .func        = func,
+        .arg         = arg,
+        .rets        = rets,
+        .nb_jobs     = nb_jobs,
+        .max_threads = max_threads,
+        .nb_threads  = 1,
+    };
+    Batch **p;
+
+    if (nb_jobs <= 0)
+        return;
+
+    pthread_mutex_lock(&e->mutex);
+    if (nb_jobs > 1 && max_threads != 1) {
+        for (p = &e->batches; *p; p = &(*p)->next);
+        *p = &b;
+        pthread_cond_broadcast(&e->work_cond);
+    }
+
+    run_jobs(e, &b, 0);
+
+    while (b.nb_done < b.nb_jobs)
+        pthread_cond_wait(&e->done_cond, &e->mutex);
+    pthread_mutex_unlock(&e->mutex);
+}
+
+#else /* HAVE_THREADS */
+
+int av_executor_alloc(AVExecutor **pe, int nb_threads)
+{
+    *pe = NULL;
+    return AVERROR(ENOSYS);
+}
+
+void av_executor_free(AVExecutor **pe)
+{
+}
+
+int av_executor_get_nb_threads(const AVExecutor *e)
+{
+    return 0;
+}
+
+void av_executor_execute(AVExecutor *e, av_executor_func *func, void *arg,
+                         int *rets, int nb_jobs, int max_threads)
+{
+    for (int i = 0; i < nb_jobs; i++) {
+        int ret = func(arg, i, 0);
+        if (rets)
+            rets[i] = ret;
+    }
+}
+
+#endif /* HAVE_THREADS */
@@ -0,0 +1,91 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef AVUTIL_EXECUTOR_H
+#define AVUTIL_EXECUTOR_H
+
+/**
+ * @file
+ * Shared thread pool
+ *
+ * An AVExecutor owns a fixed set of worker threads which can be shared by
+ * any number of codec contexts and filter graphs, so that the total number
+ * of threads in a process does not grow with the number of jobs. Batches of
+ * jobs submitted concurrently from different threads are kept in a single
+ * queue; an idle worker joins the oldest batch that still has jobs left and
+ * is below its thread limit. Workers have no queues of their own and do not
+ * take jobs from each other.
+ */
+
+typedef struct AVExecutor AVExecutor;
+
+/**
+ * Function executed by the pool.
+ *
+ * @param arg      opaque pointer passed to av_executor_execute()
+ * @param jobnr    index of the job, in the range [0, nb_jobs)
+ * @param threadnr index of the thread running the job, in the range
+ *                 [0, max_threads), unique among the threads working on
+ *                 the same batch
+ * @return value stored in the rets array passed to av_executor_execute()
+ */
+typedef int (av_executor_func)(void *arg, int jobnr, int threadnr);
+
+/**
+ * Allocate a thread pool.
+ *
+ * @param e          pointer to the pool
+ * @param nb_threads number of worker threads, 0 to use one per CPU
+ * @return >=0 for success; <0 for error, in particular AVERROR(ENOSYS) if
+ *         lavu was built without thread support
+ */
+int av_executor_alloc(AVExecutor **e, int nb_threads);
+
+/**
+ * Free a thread pool and join its threads.
+ *
+ * No batch may be in progress on the pool.
+ */
+void av_executor_free(AVExecutor **e);
+
+/**
+ * @return the number of worker threads of the pool
+ */
+int av_executor_get_nb_threads(const AVExecutor *e);
+
+/**
+ * Run a batch of jobs on the pool and wait for all of them to complete.
+ *
+ * The calling thread takes part in the processing of its own batch as
+ * thread 0, so a batch always makes progress even when all the workers are
+ * busy with other batches. This function may be called from several threads
+ * at the same time.
+ *
+ * @param e           the pool
+ * @param func        function to execute for each job
+ * @param arg         opaque pointer passed to func
+ * @param rets        if not NULL, array of nb_jobs elements receiving the
+ *                    return values of func
+ * @param nb_jobs     number of jobs
+ * @param max_threads maximum number of threads, including the calling one,
+ *                    working on this batch at the same time; 0 for no limit
+ */
+void av_executor_execute(AVExecutor *e, av_executor_func *func, void *arg,
+                         int *rets, int nb_jobs, int max_threads);
+
+#endif /* AVUTIL_EXECUTOR_H */
@@ -25,6 +25,7 @@
  */
 
 #define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE // for madvise()
 
 #include "config.h"
 
@@ -36,6 +37,9 @@
 #if HAVE_MALLOC_H
 #include <malloc.h>
 #endif
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 #include "attributes.h"
 #include "avassert.h"
@@ -75,6 +79,38 @@ void av_max_alloc(size_t max){
     atomic_store_explicit(&max_alloc_size, max, memory_order_relaxed);
 }
 
+#if HAVE_POSIX_MEMALIGN && HAVE_MMAP && defined(MADV_HUGEPAGE)
+#define HUGEPAGE_SUPPORTED 1
+/* size of a transparent huge page on x86 and most aarch64 kernels */
+#define HUGEPAGE_SIZE (2 << 20)
+#else
+#define HUGEPAGE_SUPPORTED 0
+#endif
+
+static atomic_size_t hugepage_threshold = ATOMIC_VAR_INIT(0);
+
+int av_hugepage_threshold(size_t min_size)
+{
+    if (!HUGEPAGE_SUPPORTED)
+        return min_size ? AVERROR(ENOSYS) : 0;
+    atomic_store_explicit(&hugepage_threshold, min_size, memory_order_relaxed);
+    return 0;
+}
+
+#if HUGEPAGE_SUPPORTED
+static void *hugepage_malloc(size_t size)
+{
+    size_t aligned_size = FFALIGN(size, HUGEPAGE_SIZE);
+    void *ptr;
+
+    if (aligned_size < size || posix_memalign(&ptr, HUGEPAGE_SIZE, aligned_size))
+        return NULL;
+    /* only a hint, the allocation is usable either way */
+    madvise(ptr, aligned_size, MADV_HUGEPAGE);
+    return ptr;
+}
+#endif
+
 static int size_mult(size_t a, size_t b, size_t *r)
 {
     size_t t;
@@ -101,6 +137,14 @@ void *av_malloc(size_t size)
         return NULL;
 
 #if HAVE_POSIX_MEMALIGN
+#if HUGEPAGE_SUPPORTED
+    {
+        size_t threshold = atomic_load_explicit(&hugepage_threshold, memory_order_relaxed);
+        if (threshold && size >= threshold)
+            ptr = hugepage_malloc(size);
+    }
+    if (!ptr)
+#endif
     if (size) //OS X on SDK 10.6 has a broken posix_memalign implementation
     if (posix_memalign(&ptr, ALIGN, size))
         ptr = NULL;
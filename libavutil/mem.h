@@ -689,6 +689,22 @@ int av_size_mult(size_t a, size_t b, size_t *r);
  */
 void av_max_alloc(size_t max);
 
+/**
+ * Back large blocks with huge pages.
+ *
+ * Blocks of at least min_size bytes allocated by av_malloc() and the
+ * functions built on it (including AVBufferPool, which frame data pools use)
+ * are then aligned and padded to the huge page size and marked as eligible
+ * for transparent huge pages, which reduces TLB misses when processing large
+ * frames. This trades some memory for speed, so min_size should be at least
+ * a few megabytes.
+ *
+ * @param min_size minimum size of a block to use huge pages for, 0 (the
+ *                 default) to disable
+ * @return 0 on success, AVERROR(ENOSYS) if not supported on this platform
+ */
+int av_hugepage_threshold(size_t min_size);
+
 /**
  * @}
  * @}
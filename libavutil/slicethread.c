@@ -16,6 +16,19 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include "config.h"
+
+#if HAVE_SCHED_SETAFFINITY
+# ifndef _GNU_SOURCE
+#  define _GNU_SOURCE // for CPU_SET and sched_setaffinity()
+# endif
+# include <sched.h>
+#endif
+#if HAVE_SETPRIORITY
+# include <sys/resource.h>
+#endif
+
+#include <errno.h>
 #include <stdatomic.h>
 #include "cpu.h"
 #include "internal.h"
@@ -24,14 +37,143 @@
 #include "thread.h"
 #include "avassert.h"
 
+#if HAVE_SCHED_SETAFFINITY && defined(CPU_SET)
+#define AFFINITY_SUPPORTED 1
+#define MAX_CPUS CPU_SETSIZE
+#else
+#define AFFINITY_SUPPORTED 0
+#define MAX_CPUS 1024
+#endif
+
+static int parse_cpu_list(const char *str, int **pcpus, int *pnb_cpus)
+{
+    int *cpus = NULL, nb_cpus = 0;
+
+    while (*str) {
+        char *end;
+        long first, last;
+
+        first = last = strtol(str, &end, 10);
+        if (end == str)
+            goto fail;
+        if (*end == '-') {
+            str  = end + 1;
+            last = strtol(str, &end, 10);
+            if (end == str)
+                goto fail;
+        }
+        if (first < 0 || last < first || last >= MAX_CPUS)
+            goto fail;
+        for (; first <= last; first++) {
+            int ret = av_reallocp_array(&cpus, nb_cpus + 1, sizeof(*cpus));
+            if (ret < 0)
+                return ret;
+            cpus[nb_cpus++] = first;
+        }
+        if (*end && *end != ',')
+            goto fail;
+        str = end + !!*end;
+    }
+    if (!nb_cpus)
+        goto fail;
+
+    *pcpus    = cpus;
+    *pnb_cpus = nb_cpus;
+    return 0;
+
+fail:
+    av_free(cpus);
+    return AVERROR(EINVAL);
+}
+
+#if AFFINITY_SUPPORTED
+static int set_affinity(const int *cpus, int nb_cpus, int index)
+{
+    cpu_set_t cpuset;
+
+    CPU_ZERO(&cpuset);
+    if (index >= 0) {
+        CPU_SET(cpus[index % nb_cpus], &cpuset);
+    } else {
+        for (int i = 0; i < nb_cpus; i++)
+            CPU_SET(cpus[i], &cpuset);
+    }
+    if (sched_setaffinity(0, sizeof(cpuset), &cpuset) < 0)
+        return AVERROR(errno);
+    return 0;
+}
+#endif
+
+/* setpriority() only applies to the calling thread on Linux,
+ * elsewhere it would renice the whole process. */
+#if HAVE_SETPRIORITY && defined(__linux__)
+#define PRIORITY_SUPPORTED 1
+#else
+#define PRIORITY_SUPPORTED 0
+#endif
+
+int avpriv_thread_check_affinity(const char *cpus)
+{
+    int *list, nb, ret;
+
+    ret = parse_cpu_list(cpus, &list, &nb);
+    if (ret < 0)
+        return ret;
+    av_free(list);
+    return 0;
+}
+
+int avpriv_thread_set_affinity(const char *cpus, int index)
+{
+    int *list, nb, ret;
+
+    ret = parse_cpu_list(cpus, &list, &nb);
+    if (ret < 0)
+        return ret;
+#if AFFINITY_SUPPORTED
+    ret = set_affinity(list, nb, index);
+#else
+    ret = AVERROR(ENOSYS);
+#endif
+    av_free(list);
+    return ret;
+}
+
+int avpriv_thread_set_priority(int nice_inc)
+{
+#if PRIORITY_SUPPORTED
+    int prio;
+
+    if (!nice_inc)
+        return 0;
+
+    errno = 0;
+    prio  = getpriority(PRIO_PROCESS, 0);
+    if (prio == -1 && errno)
+        return AVERROR(errno);
+    if (setpriority(PRIO_PROCESS, 0, prio + nice_inc) < 0)
+        return AVERROR(errno);
+    return 0;
+#else
+    return nice_inc ? AVERROR(ENOSYS) : 0;
+#endif
+}
+
 #if HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS2THREADS
 
+/* number of workers bound to single CPUs so far, process wide, so that
+ * contexts pinned with the same list do not all start on its first CPU */
+static atomic_uint affinity_next_cpu = 0;
+
 typedef struct WorkerContext {
     AVSliceThread   *ctx;
     pthread_mutex_t mutex;
     pthread_cond_t  cond;
     pthread_t       thread;
     int             done;
+    int             index;
+    int             nice_inc;
+    unsigned        config_gen;
 } WorkerContext;
 
 struct AVSliceThread {
@@ -47,6 +189,13 @@ struct AVSliceThread {
     int             done;
     int             finished;
 
+    int             *cpus;
+    int             nb_cpus;
+    int             per_thread;
+    int             cpu_offset;
+    int             nice_inc;
+    unsigned        config_gen;
+
     void            *priv;
     void            (*worker_func)(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads);
     void            (*main_func)(void *priv);
@@ -66,6 +215,20 @@ static int run_jobs(AVSliceThread *ctx)
     return current_job == nb_jobs + nb_active_threads - 1;
 }
 
+static void apply_config(WorkerContext *w)
+{
+    AVSliceThread *ctx = w->ctx;
+
+#if AFFINITY_SUPPORTED
+    if (ctx->nb_cpus)
+        set_affinity(ctx->cpus, ctx->nb_cpus, ctx->per_thread ? ctx->cpu_offset + w->index : -1);
+#endif
+    /* the increment is relative to the priority the worker was created with */
+    avpriv_thread_set_priority(ctx->nice_inc - w->nice_inc);
+    w->nice_inc   = ctx->nice_inc;
+    w->config_gen = ctx->config_gen;
+}
+
 static void *attribute_align_arg thread_worker(void *v)
 {
     WorkerContext *w = v;
@@ -84,6 +247,9 @@ static void *attribute_align_arg thread_worker(void *v)
             return NULL;
         }
 
+        if (w->config_gen != ctx->config_gen)
+            apply_config(w);
+
         if (run_jobs(ctx)) {
             pthread_mutex_lock(&ctx->done_mutex);
             ctx->done = 1;
@@ -141,6 +307,7 @@ int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
         WorkerContext *w = &ctx->workers[i];
         int ret;
         w->ctx = ctx;
+        w->index = i;
         pthread_mutex_init(&w->mutex, NULL);
         pthread_cond_init(&w->cond, NULL);
         pthread_mutex_lock(&w->mutex);
@@ -230,9 +397,45 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
     pthread_cond_destroy(&ctx->done_cond);
     pthread_mutex_destroy(&ctx->done_mutex);
     av_freep(&ctx->workers);
+    av_freep(&ctx->cpus);
     av_freep(pctx);
 }
 
+int avpriv_slicethread_set_affinity(AVSliceThread *ctx, const char *cpus, int per_thread)
+{
+    int *list, nb, ret;
+
+    ret = parse_cpu_list(cpus, &list, &nb);
+    if (ret < 0)
+        return ret;
+    if (!AFFINITY_SUPPORTED) {
+        av_free(list);
+        return AVERROR(ENOSYS);
+    }
+
+    av_free(ctx->cpus);
+    ctx->cpus       = list;
+    ctx->nb_cpus    = nb;
+    ctx->per_thread = per_thread;
+    if (per_thread) {
+        unsigned nb_workers = ctx->nb_threads - !ctx->main_func;
+        ctx->cpu_offset = atomic_fetch_add_explicit(&affinity_next_cpu, nb_workers,
+                                                    memory_order_relaxed) % nb;
+    }
+    ctx->config_gen++;
+    return 0;
+}
+
+int avpriv_slicethread_set_priority(AVSliceThread *ctx, int nice_inc)
+{
+    if (!PRIORITY_SUPPORTED)
+        return nice_inc ? AVERROR(ENOSYS) : 0;
+
+    ctx->nice_inc = nice_inc;
+    ctx->config_gen++;
+    return 0;
+}
+
 #else /* HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS32THREADS */
 
 int avpriv_slicethread_create(AVSliceThread **pctx, void *priv,
@@ -254,4 +457,14 @@ void avpriv_slicethread_free(AVSliceThread **pctx)
     av_assert0(!pctx || !*pctx);
 }
 
+int avpriv_slicethread_set_affinity(AVSliceThread *ctx, const char *cpus, int per_thread)
+{
+    return AVERROR(ENOSYS);
+}
+
+int avpriv_slicethread_set_priority(AVSliceThread *ctx, int nice_inc)
+{
+    return AVERROR(ENOSYS);
+}
+
 #endif /* HAVE_PTHREADS || HAVE_W32THREADS || HAVE_OS32THREADS */
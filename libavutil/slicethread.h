@@ -49,4 +49,56 @@ void avpriv_slicethread_execute(AVSliceThread *ctx, int nb_jobs, int execute_mai
  */
 void avpriv_slicethread_free(AVSliceThread **pctx);
 
+/**
+ * Restrict the worker threads to a set of CPUs.
+ * Each worker applies the new affinity the next time it is woken up.
+ * The thread calling avpriv_slicethread_execute(), which runs jobs too, is
+ * left untouched; callers can pin it with avpriv_thread_set_affinity().
+ * @param ctx slice threading context
+ * @param cpus list of CPU numbers and ranges, e.g. "0-7,16-23"
+ * @param per_thread if nonzero, bind each worker to a single CPU of the list,
+ *                   assigned round-robin, instead of the whole set. The
+ *                   assignment continues after the CPUs given to the workers
+ *                   of previously configured contexts, so that contexts
+ *                   sharing a list spread over it.
+ * @return 0 on success, AVERROR(EINVAL) if the list is malformed,
+ *         AVERROR(ENOSYS) if unsupported, negative AVERROR on failure
+ */
+int avpriv_slicethread_set_affinity(AVSliceThread *ctx, const char *cpus, int per_thread);
+
+/**
+ * Check the syntax of a CPU list, so that callers can reject a malformed
+ * one before creating any thread.
+ * @param cpus list of CPU numbers and ranges, e.g. "0-7,16-23"
+ * @return 0 if the list is valid, AVERROR(EINVAL) if it is malformed,
+ *         negative AVERROR on failure
+ */
+int avpriv_thread_check_affinity(const char *cpus);
+
+/**
+ * Change the scheduling priority of the worker threads.
+ * Like avpriv_slicethread_set_affinity(), the change is applied by each
+ * worker the next time it is woken up.
+ * @param ctx slice threading context
+ * @param nice_inc increment added to the nice value the workers were created with
+ * @return 0 on success, AVERROR(ENOSYS) if unsupported
+ */
+int avpriv_slicethread_set_priority(AVSliceThread *ctx, int nice_inc);
+
+/**
+ * Restrict the calling thread to a set of CPUs.
+ * @param cpus list of CPU numbers and ranges, e.g. "0-7,16-23"
+ * @param index if >= 0, bind to the index-th CPU of the list (modulo its
+ *              length), otherwise to the whole set
+ * @return 0 on success, AVERROR(EINVAL) if the list is malformed,
+ *         AVERROR(ENOSYS) if unsupported, negative AVERROR on failure
+ */
+int avpriv_thread_set_affinity(const char *cpus, int index);
+
+/**
+ * Add an increment to the nice value of the calling thread.
+ * @return 0 on success, AVERROR(ENOSYS) if unsupported, negative AVERROR on failure
+ */
+int avpriv_thread_set_priority(int nice_inc);
+
 #endif
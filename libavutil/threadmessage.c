@@ -20,6 +20,7 @@
 
 #include <limits.h>
 #include "fifo.h"
+#include "macros.h"
 #include "mem.h"
 #include "threadmessage.h"
 #include "thread.h"
@@ -120,9 +121,12 @@ int av_thread_message_queue_nb_elems(AVThreadMessageQueue *mq)
 #if HAVE_THREADS
 
 static int av_thread_message_queue_send_locked(AVThreadMessageQueue *mq,
-                                               void *msg,
+                                               void *msgs,
+                                               unsigned nb_msgs,
                                                unsigned flags)
 {
+    size_t nb;
+
     while (!mq->err_send && !av_fifo_can_write(mq->fifo)) {
         if ((flags & AV_THREAD_MESSAGE_NONBLOCK))
             return AVERROR(EAGAIN);
@@ -130,16 +134,23 @@ static int av_thread_message_queue_send_locked(AVThreadMessageQueue *mq,
     }
     if (mq->err_send)
         return mq->err_send;
-    av_fifo_write(mq->fifo, msg, 1);
-    /* one message is sent, signal one receiver */
-    pthread_cond_signal(&mq->cond_recv);
-    return 0;
+    nb = FFMIN(nb_msgs, av_fifo_can_write(mq->fifo));
+    av_fifo_write(mq->fifo, msgs, nb);
+    /* signal one receiver per message sent */
+    if (nb > 1)
+        pthread_cond_broadcast(&mq->cond_recv);
+    else
+        pthread_cond_signal(&mq->cond_recv);
+    return nb;
 }
 
 static int av_thread_message_queue_recv_locked(AVThreadMessageQueue *mq,
-                                               void *msg,
+                                               void *msgs,
+                                               unsigned nb_msgs,
                                                unsigned flags)
 {
+    size_t nb;
+
     while (!mq->err_recv && !av_fifo_can_read(mq->fifo)) {
         if ((flags & AV_THREAD_MESSAGE_NONBLOCK))
             return AVERROR(EAGAIN);
@@ -147,10 +158,14 @@ static int av_thread_message_queue_recv_locked(AVThreadMessageQueue *mq,
     }
     if (!av_fifo_can_read(mq->fifo))
         return mq->err_recv;
-    av_fifo_read(mq->fifo, msg, 1);
-    /* one message space appeared, signal one sender */
-    pthread_cond_signal(&mq->cond_send);
-    return 0;
+    nb = FFMIN(nb_msgs, av_fifo_can_read(mq->fifo));
+    av_fifo_read(mq->fifo, msgs, nb);
+    /* signal one sender per message space that appeared */
+    if (nb > 1)
+        pthread_cond_broadcast(&mq->cond_send);
+    else
+        pthread_cond_signal(&mq->cond_send);
+    return nb;
 }
 
 #endif /* HAVE_THREADS */
@@ -163,9 +178,9 @@ int av_thread_message_queue_send(AVThreadMessageQueue *mq,
     int ret;
 
     pthread_mutex_lock(&mq->lock);
-    ret = av_thread_message_queue_send_locked(mq, msg, flags);
+    ret = av_thread_message_queue_send_locked(mq, msg, 1, flags);
     pthread_mutex_unlock(&mq->lock);
-    return ret;
+    return FFMIN(ret, 0);
 #else
     return AVERROR(ENOSYS);
 #endif /* HAVE_THREADS */
@@ -179,7 +194,47 @@ int av_thread_message_queue_recv(AVThreadMessageQueue *mq,
     int ret;
 
     pthread_mutex_lock(&mq->lock);
-    ret = av_thread_message_queue_recv_locked(mq, msg, flags);
+    ret = av_thread_message_queue_recv_locked(mq, msg, 1, flags);
+    pthread_mutex_unlock(&mq->lock);
+    return FFMIN(ret, 0);
+#else
+    return AVERROR(ENOSYS);
+#endif /* HAVE_THREADS */
+}
+
+int av_thread_message_queue_send_multi(AVThreadMessageQueue *mq,
+                                       void *msgs,
+                                       unsigned nb_msgs,
+                                       unsigned flags)
+{
+#if HAVE_THREADS
+    int ret;
+
+    if (!nb_msgs || nb_msgs > INT_MAX)
+        return AVERROR(EINVAL);
+
+    pthread_mutex_lock(&mq->lock);
+    ret = av_thread_message_queue_send_locked(mq, msgs, nb_msgs, flags);
+    pthread_mutex_unlock(&mq->lock);
+    return ret;
+#else
+    return AVERROR(ENOSYS);
+#endif /* HAVE_THREADS */
+}
+
+int av_thread_message_queue_recv_multi(AVThreadMessageQueue *mq,
+                                       void *msgs,
+                                       unsigned nb_msgs,
+                                       unsigned flags)
+{
+#if HAVE_THREADS
+    int ret;
+
+    if (!nb_msgs || nb_msgs > INT_MAX)
+        return AVERROR(EINVAL);
+
+    pthread_mutex_lock(&mq->lock);
+    ret = av_thread_message_queue_recv_locked(mq, msgs, nb_msgs, flags);
     pthread_mutex_unlock(&mq->lock);
     return ret;
 #else
@@ -66,6 +66,38 @@ int av_thread_message_queue_recv(AVThreadMessageQueue *mq,
                                  void *msg,
                                  unsigned flags);
 
+/**
+ * Send several messages on the queue at once.
+ *
+ * Wait until the queue has room for at least one message, then send as many
+ * of the messages as fit, in order, taking the queue lock only once.
+ *
+ * @param msgs    array of nb_msgs messages
+ * @param nb_msgs number of messages in msgs, must be > 0
+ * @return the number of messages sent, which may be lower than nb_msgs,
+ *         or a negative error code if no message was sent
+ */
+int av_thread_message_queue_send_multi(AVThreadMessageQueue *mq,
+                                       void *msgs,
+                                       unsigned nb_msgs,
+                                       unsigned flags);
+
+/**
+ * Receive several messages from the queue at once.
+ *
+ * Wait until at least one message is available, then receive up to nb_msgs
+ * of the queued messages, taking the queue lock only once.
+ *
+ * @param msgs    array with room for nb_msgs messages
+ * @param nb_msgs maximum number of messages to receive, must be > 0
+ * @return the number of messages received, or a negative error code if no
+ *         message was received
+ */
+int av_thread_message_queue_recv_multi(AVThreadMessageQueue *mq,
+                                       void *msgs,
+                                       unsigned nb_msgs,
+                                       unsigned flags);
+
 /**
  * Set the sending error code.
  *
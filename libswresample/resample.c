@@ -28,6 +28,7 @@
 
 #include "libavutil/avassert.h"
 #include "libavutil/cpu.h"
+#include "libavutil/thread.h"
 #include "resample.h"
 
 static inline double eval_poly(const double *coeff, int size, double x) {
@@ -277,17 +278,207 @@ fail:
     return ret;
 }
 
+/* Filter banks only depend on a few parameters and are expensive to build
+ * for high precision settings, so they are shared between all contexts using
+ * the same ones. Banks no longer in use are kept around as long as they fit
+ * into BANK_CACHE_IDLE_MAX, for contexts which are created and destroyed
+ * repeatedly. */
+#define BANK_CACHE_SIZE     16
+#define BANK_CACHE_IDLE_MAX (32 << 20)
+
+typedef struct FilterBankKey {
+    double factor;
+    double kaiser_beta;
+    int filter_length;
+    int filter_alloc;
+    int phase_count;
+    int filter_type;
+    enum AVSampleFormat format;
+} FilterBankKey;
+
+typedef struct FilterBankEntry {
+    FilterBankKey key;
+    uint8_t *bank;
+    size_t size;
+    int refcount;
+    unsigned last_use;
+} FilterBankEntry;
+
+static AVMutex bank_cache_mutex = AV_MUTEX_INITIALIZER;
+static FilterBankEntry bank_cache[BANK_CACHE_SIZE];
+static unsigned bank_cache_clock;
+
+/* must be called with bank_cache_mutex held */
+static void bank_cache_trim(void)
+{
+    for (;;) {
+        FilterBankEntry *oldest = NULL;
+        size_t idle = 0;
+        int i;
+
+        for (i = 0; i < BANK_CACHE_SIZE; i++) {
+            FilterBankEntry *e = &bank_cache[i];
+            if (!e->bank || e->refcount)
+                continue;
+            idle += e->size;
+            if (!oldest || e->last_use < oldest->last_use)
+                oldest = e;
+        }
+        if (idle <= BANK_CACHE_IDLE_MAX)
+            return;
+
+        av_freep(&oldest->bank);
+        oldest->refcount = 0;
+    }
+}
+
+/* must be called with bank_cache_mutex held */
+static FilterBankEntry *bank_cache_find(const FilterBankKey *key)
+{
+    int i;
+
+    for (i = 0; i < BANK_CACHE_SIZE; i++) {
+        FilterBankEntry *e = &bank_cache[i];
+        if (e->bank && !memcmp(&e->key, key, sizeof(*key))) {
+            e->refcount++;
+            e->last_use = ++bank_cache_clock;
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Get the filter bank for the parameters of c and the given phase count,
+ * either from the cache or newly built.
+ */
+static int get_filter_bank(ResampleContext *c, int phase_count, uint8_t **pbank)
+{
+    FilterBankKey key;
+    FilterBankEntry *e;
+    size_t size = (size_t)c->filter_alloc * (phase_count + 1) * c->felem_size;
+    uint8_t *bank;
+    int i, ret;
+
+    /* zero the padding, the key is compared with memcmp() */
+    memset(&key, 0, sizeof(key));
+    key.factor        = c->factor;
+    key.kaiser_beta   = c->kaiser_beta;
+    key.filter_length = c->filter_length;
+    key.filter_alloc  = c->filter_alloc;
+    key.phase_count   = phase_count;
+    key.filter_type   = c->filter_type;
+    key.format        = c->format;
+
+    ff_mutex_lock(&bank_cache_mutex);
+    e = bank_cache_find(&key);
+    ff_mutex_unlock(&bank_cache_mutex);
+    if (e) {
+        *pbank = e->bank;
+        return 0;
+    }
+
+    bank = av_calloc(c->filter_alloc, (phase_count + 1) * c->felem_size);
+    if (!bank)
+        return AVERROR(ENOMEM);
+    ret = build_filter(c, bank, c->factor, c->filter_length, c->filter_alloc,
+                       phase_count, 1 << c->filter_shift, c->filter_type, c->kaiser_beta);
+    if (ret < 0) {
+        av_free(bank);
+        return ret;
+    }
+    memcpy(bank + (c->filter_alloc*phase_count+1)*c->felem_size, bank, (c->filter_alloc-1)*c->felem_size);
+    memcpy(bank + (c->filter_alloc*phase_count  )*c->felem_size, bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
+
+    ff_mutex_lock(&bank_cache_mutex);
+    /* another context may have built the same bank in the meantime */
+    e = bank_cache_find(&key);
+    if (e) {
+        av_free(bank);
+        bank = e->bank;
+    } else {
+        for (i = 0; i < BANK_CACHE_SIZE; i++) {
+            FilterBankEntry *cur = &bank_cache[i];
+            if (!cur->bank) {
+                e = cur;
+                break;
+            }
+            if (!cur->refcount && (!e || cur->last_use < e->last_use))
+                e = cur;
+        }
+        /* if all entries are in use, the bank stays private to c */
+        if (e) {
+            av_free(e->bank);
+            e->key      = key;
+            e->bank     = bank;
+            e->size     = size;
+            e->refcount = 1;
+            e->last_use = ++bank_cache_clock;
+            bank_cache_trim();
+        }
+    }
+    ff_mutex_unlock(&bank_cache_mutex);
+
+    *pbank = bank;
+    return 0;
+}
+
+static void release_filter_bank(uint8_t **pbank)
+{
+    uint8_t *bank = *pbank;
+    int i;
+
+    if (!bank)
+        return;
+
+    ff_mutex_lock(&bank_cache_mutex);
+    for (i = 0; i < BANK_CACHE_SIZE; i++) {
+        if (bank_cache[i].bank == bank) {
+            bank_cache[i].refcount--;
+            bank_cache_trim();
+            bank = NULL;
+            break;
+        }
+    }
+    ff_mutex_unlock(&bank_cache_mutex);
+
+    av_free(bank);
+    *pbank = NULL;
+}
+
+/* resample every nb_jobs-th channel, the context is only updated by the
+ * caller, from the state reached by channel 0 */
+static void resample_worker(void *priv, int jobnr, int threadnr, int nb_jobs, int nb_threads)
+{
+    ResampleContext *c = priv;
+    int i;
+
+    for (i = jobnr; i < c->job.dst->ch_count; i += nb_jobs) {
+        if (!i) {
+            ResampleContext tmp = *c;
+            c->job.consumed = c->job.func(&tmp, c->job.dst->ch[i], c->job.src->ch[i], c->job.n, 1);
+            c->job.index    = tmp.index;
+            c->job.frac     = tmp.frac;
+        } else
+            c->job.func(c, c->job.dst->ch[i], c->job.src->ch[i], c->job.n, 0);
+    }
+
+    if (c->job.need_emms)
+        emms_c();
+}
+
 static void resample_free(ResampleContext **cc){
     ResampleContext *c = *cc;
     if(!c)
         return;
-    av_freep(&c->filter_bank);
+    avpriv_slicethread_free(&c->slicethread);
+    release_filter_bank(&c->filter_bank);
     av_freep(cc);
 }
 
 static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_rate, int filter_size, int phase_shift, int linear,
                                     double cutoff0, enum AVSampleFormat format, enum SwrFilterType filter_type, double kaiser_beta,
-                                    double precision, int cheby, int exact_rational)
+                                    double precision, int cheby, int exact_rational, int nb_threads)
 {
     double cutoff = cutoff0? cutoff0 : 0.97;
     double factor= FFMIN(out_rate * cutoff / in_rate, 1.0);
@@ -317,6 +508,7 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
             return NULL;
 
         c->format= format;
+        c->nb_threads = c->nb_jobs = 1;
 
         c->felem_size= av_get_bytes_per_sample(c->format);
 
@@ -345,17 +537,30 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
         c->linear        = linear;
         c->factor        = factor;
         c->filter_length = filter_length;
-        c->filter_alloc  = FFALIGN(c->filter_length, 8);
-        c->filter_bank   = av_calloc(c->filter_alloc, (phase_count+1)*c->felem_size);
+        /* padded so that SIMD can read whole 64-byte vectors of coefficients */
+        c->filter_alloc  = FFALIGN(c->filter_length, 16);
         c->filter_type   = filter_type;
         c->kaiser_beta   = kaiser_beta;
         c->phase_count_compensation = phase_count_compensation;
-        if (!c->filter_bank)
-            goto error;
-        if (build_filter(c, (void*)c->filter_bank, factor, c->filter_length, c->filter_alloc, phase_count, 1<<c->filter_shift, filter_type, kaiser_beta))
+        if (get_filter_bank(c, phase_count, &c->filter_bank) < 0)
             goto error;
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, c->filter_bank, (c->filter_alloc-1)*c->felem_size);
-        memcpy(c->filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, c->filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
+    }
+
+    if (c->nb_threads != nb_threads) {
+        int ret;
+
+        avpriv_slicethread_free(&c->slicethread);
+        c->nb_threads = nb_threads;
+        c->nb_jobs    = 1;
+        if (nb_threads != 1) {
+            ret = avpriv_slicethread_create(&c->slicethread, c, resample_worker, NULL, nb_threads);
+            if (ret == AVERROR(ENOSYS))
+                av_log(NULL, AV_LOG_WARNING, "Threads not supported, resampling channels serially\n");
+            else if (ret < 0)
+                goto error;
+            else
+                c->nb_jobs = ret;
+        }
     }
 
     c->compensation_distance= 0;
@@ -376,7 +581,8 @@ static ResampleContext *resample_init(ResampleContext *c, int out_rate, int in_r
 
     return c;
 error:
-    av_freep(&c->filter_bank);
+    avpriv_slicethread_free(&c->slicethread);
+    release_filter_bank(&c->filter_bank);
     av_free(c);
     return NULL;
 }
@@ -393,23 +599,14 @@ static int rebuild_filter_bank_with_compensation(ResampleContext *c)
 
     av_assert0(!c->frac && !c->dst_incr_mod);
 
-    new_filter_bank = av_calloc(c->filter_alloc, (phase_count + 1) * c->felem_size);
-    if (!new_filter_bank)
-        return AVERROR(ENOMEM);
-
-    ret = build_filter(c, new_filter_bank, c->factor, c->filter_length, c->filter_alloc,
-                       phase_count, 1 << c->filter_shift, c->filter_type, c->kaiser_beta);
-    if (ret < 0) {
-        av_freep(&new_filter_bank);
+    ret = get_filter_bank(c, phase_count, &new_filter_bank);
+    if (ret < 0)
         return ret;
-    }
-    memcpy(new_filter_bank + (c->filter_alloc*phase_count+1)*c->felem_size, new_filter_bank, (c->filter_alloc-1)*c->felem_size);
-    memcpy(new_filter_bank + (c->filter_alloc*phase_count  )*c->felem_size, new_filter_bank + (c->filter_alloc - 1)*c->felem_size, c->felem_size);
 
     if (!av_reduce(&new_src_incr, &new_dst_incr, c->src_incr,
                    c->dst_incr * (int64_t)(phase_count/c->phase_count), INT32_MAX/2))
     {
-        av_freep(&new_filter_bank);
+        release_filter_bank(&new_filter_bank);
         return AVERROR(EINVAL);
     }
 
@@ -424,7 +621,7 @@ static int rebuild_filter_bank_with_compensation(ResampleContext *c)
     c->dst_incr_mod   = c->dst_incr % c->src_incr;
     c->index         *= phase_count / c->phase_count;
     c->phase_count    = phase_count;
-    av_freep(&c->filter_bank);
+    release_filter_bank(&c->filter_bank);
     c->filter_bank = new_filter_bank;
     return 0;
 }
@@ -495,8 +692,20 @@ static int multiple_resample(ResampleContext *c, AudioData *dst, int dst_size, A
              * when frac and dst_incr_mod are zero */
             resample_func = (c->linear && (c->frac || c->dst_incr_mod)) ?
                             c->dsp.resample_linear : c->dsp.resample_common;
-            for (i = 0; i < dst->ch_count; i++)
-                *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            if (c->slicethread && dst->ch_count > 1) {
+                c->job.dst       = dst;
+                c->job.src       = src;
+                c->job.n         = dst_size;
+                c->job.func      = resample_func;
+                c->job.need_emms = need_emms;
+                avpriv_slicethread_execute(c->slicethread, FFMIN(c->nb_jobs, dst->ch_count), 0);
+                *consumed = c->job.consumed;
+                c->index  = c->job.index;
+                c->frac   = c->job.frac;
+            } else {
+                for (i = 0; i < dst->ch_count; i++)
+                    *consumed = resample_func(c, dst->ch[i], src->ch[i], dst_size, i+1 == dst->ch_count);
+            }
         }
     }
 
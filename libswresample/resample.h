@@ -24,6 +24,7 @@
 
 #include "libavutil/log.h"
 #include "libavutil/samplefmt.h"
+#include "libavutil/slicethread.h"
 
 #include "swresample_internal.h"
 
@@ -58,6 +59,20 @@ typedef struct ResampleContext {
         int (*resample_linear)(struct ResampleContext *c, void *dst,
                                const void *src, int n, int update_ctx);
     } dsp;
+
+    int nb_threads;                    ///< requested number of threads
+    int nb_jobs;                       ///< number of threads actually running
+    AVSliceThread *slicethread;
+
+    /* current call of multiple_resample(), for the channel jobs */
+    struct {
+        AudioData *dst, *src;
+        int n;
+        int (*func)(struct ResampleContext *c, void *dst,
+                    const void *src, int n, int update_ctx);
+        int consumed, index, frac;
+        int need_emms;
+    } job;
 } ResampleContext;
 
 void swri_resample_dsp_init(ResampleContext *c);
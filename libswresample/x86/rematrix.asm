@@ -47,6 +47,23 @@ mix_2_1_float_u_int %+ SUFFIX:
     add outq    , lenq
     neg lenq
 .next:
+%if mmsize == 64
+    ; the callers process multiples of 16 samples, a single zmm per iteration
+    ; the output may be the caller's buffer, which is only 32 byte aligned,
+    ; so always store unaligned
+%ifidn %1, a
+    mulps        m0, m4, [in1q + lenq]
+    mulps        m1, m5, [in2q + lenq]
+%else
+    movu         m0, [in1q + lenq]
+    movu         m1, [in2q + lenq]
+    mulps        m0, m0, m4
+    mulps        m1, m1, m5
+%endif
+    addps        m0, m0, m1
+    movu   [outq + lenq], m0
+    add        lenq, mmsize
+%else
 %ifidn %1, a
     mulps        m0, m4, [in1q + lenq         ]
     mulps        m1, m5, [in2q + lenq         ]
@@ -67,6 +84,7 @@ mix_2_1_float_u_int %+ SUFFIX:
     mov%1  [outq + lenq         ], m0
     mov%1  [outq + lenq + mmsize], m2
     add        lenq, mmsize*2
+%endif
         jl .next
     REP_RET
 %endmacro
@@ -87,6 +105,16 @@ mix_1_1_float_u_int %+ SUFFIX:
     add outq    , lenq
     neg lenq
 .next:
+%if mmsize == 64
+%ifidn %1, a
+    mulps        m0, m2, [inq + lenq]
+%else
+    movu         m0, [inq + lenq]
+    mulps        m0, m0, m2
+%endif
+    movu   [outq + lenq], m0
+    add        lenq, mmsize
+%else
 %ifidn %1, a
     mulps        m0, m2, [inq + lenq         ]
     mulps        m1, m2, [inq + lenq + mmsize]
@@ -99,6 +127,7 @@ mix_1_1_float_u_int %+ SUFFIX:
     mov%1  [outq + lenq         ], m0
     mov%1  [outq + lenq + mmsize], m1
     add        lenq, mmsize*2
+%endif
         jl .next
     REP_RET
 %endmacro
@@ -248,3 +277,11 @@ MIX2_FLT a
 MIX1_FLT u
 MIX1_FLT a
 %endif
+
+%if HAVE_AVX512_EXTERNAL
+INIT_ZMM avx512
+MIX2_FLT u
+MIX2_FLT a
+MIX1_FLT u
+MIX1_FLT a
+%endif
@@ -28,6 +28,7 @@ mix_2_1_func_type ff_mix_2_1_a_## type ## _ ## simd;
 
 D(float, sse)
 D(float, avx)
+D(float, avx512)
 D(int16, mmx)
 D(int16, sse2)
 
@@ -78,6 +79,10 @@ av_cold int swri_rematrix_init_x86(struct SwrContext *s){
             s->mix_1_1_simd = ff_mix_1_1_a_float_avx;
             s->mix_2_1_simd = ff_mix_2_1_a_float_avx;
         }
+        if(EXTERNAL_AVX512(mm_flags)) {
+            s->mix_1_1_simd = ff_mix_1_1_a_float_avx512;
+            s->mix_2_1_simd = ff_mix_2_1_a_float_avx512;
+        }
         s->native_simd_matrix = av_calloc(num, sizeof(float));
         s->native_simd_one = av_mallocz(sizeof(float));
         if (!s->native_simd_matrix || !s->native_simd_one)
@@ -0,0 +1,391 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/**
+ * @file
+ * Primaries and transfer characteristics conversion.
+ *
+ * The conversion runs inside the linear light RGBA64 context of the gamma
+ * cascade: the source lines are linearized, gamut mapped and tone mapped
+ * before horizontal scaling, and the destination transfer function is
+ * applied to the vertically scaled lines, so the scaling itself happens in
+ * linear light.
+ *
+ * Linear light values are expressed relative to the SDR reference white,
+ * normalized to the lower of the source and destination peaks when stored in
+ * the 16-bit intermediate. Nothing brighter can reach the output, and an SDR
+ * source converted to PQ keeps the full 16 bits instead of 1/100th of them.
+ */
+
+#include <math.h>
+
+#include "libavutil/color_utils.h"
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
+
+#include "swscale_internal.h"
+
+#define REFERENCE_WHITE 100.0 ///< nits of the SDR reference white
+#define HLG_PEAK         10.0 ///< nominal HLG display peak, relative to REFERENCE_WHITE
+
+typedef struct ColorPrimaries {
+    double xr, yr, xg, yg, xb, yb, xw, yw;
+} ColorPrimaries;
+
+#define WP_D65 0.3127, 0.3290
+#define WP_C   0.3100, 0.3160
+#define WP_DCI 0.3140, 0.3510
+#define WP_E   1/3.0,  1/3.0
+
+static const ColorPrimaries color_primaries[AVCOL_PRI_NB] = {
+    [AVCOL_PRI_BT709]     = { 0.640, 0.330, 0.300, 0.600, 0.150, 0.060, WP_D65 },
+    [AVCOL_PRI_BT470M]    = { 0.670, 0.330, 0.210, 0.710, 0.140, 0.080, WP_C   },
+    [AVCOL_PRI_BT470BG]   = { 0.640, 0.330, 0.290, 0.600, 0.150, 0.060, WP_D65 },
+    [AVCOL_PRI_SMPTE170M] = { 0.630, 0.340, 0.310, 0.595, 0.155, 0.070, WP_D65 },
+    [AVCOL_PRI_SMPTE240M] = { 0.630, 0.340, 0.310, 0.595, 0.155, 0.070, WP_D65 },
+    [AVCOL_PRI_FILM]      = { 0.681, 0.319, 0.243, 0.692, 0.145, 0.049, WP_C   },
+    [AVCOL_PRI_BT2020]    = { 0.708, 0.292, 0.170, 0.797, 0.131, 0.046, WP_D65 },
+    [AVCOL_PRI_SMPTE428]  = { 0.735, 0.265, 0.274, 0.718, 0.167, 0.009, WP_E   },
+    [AVCOL_PRI_SMPTE431]  = { 0.680, 0.320, 0.265, 0.690, 0.150, 0.060, WP_DCI },
+    [AVCOL_PRI_SMPTE432]  = { 0.680, 0.320, 0.265, 0.690, 0.150, 0.060, WP_D65 },
+    [AVCOL_PRI_EBU3213]   = { 0.630, 0.340, 0.295, 0.605, 0.155, 0.077, WP_D65 },
+};
+
+static int trc_supported(enum AVColorTransferCharacteristic trc)
+{
+    switch (trc) {
+    case AVCOL_TRC_BT709:
+    case AVCOL_TRC_SMPTE170M:
+    case AVCOL_TRC_BT2020_10:
+    case AVCOL_TRC_BT2020_12:
+    case AVCOL_TRC_SMPTE240M:
+    case AVCOL_TRC_GAMMA22:
+    case AVCOL_TRC_GAMMA28:
+    case AVCOL_TRC_LINEAR:
+    case AVCOL_TRC_IEC61966_2_1:
+    case AVCOL_TRC_SMPTE2084:
+    case AVCOL_TRC_ARIB_STD_B67:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+static double trc_peak(enum AVColorTransferCharacteristic trc)
+{
+    switch (trc) {
+    case AVCOL_TRC_SMPTE2084:    return 10000.0 / REFERENCE_WHITE;
+    case AVCOL_TRC_ARIB_STD_B67: return HLG_PEAK;
+    default:                     return 1.0;
+    }
+}
+
+/**
+ * Convert a non-linear value in [0,1] to linear light relative to the
+ * reference white.
+ */
+static double trc_to_linear(enum AVColorTransferCharacteristic trc, double v)
+{
+    switch (trc) {
+    case AVCOL_TRC_BT709:
+    case AVCOL_TRC_SMPTE170M:
+    case AVCOL_TRC_BT2020_10:
+    case AVCOL_TRC_BT2020_12: {
+        const double a = 1.099296826809442, b = 0.018053968510807;
+        return v < 4.5 * b ? v / 4.5 : pow((v + a - 1.0) / a, 1.0 / 0.45);
+    }
+    case AVCOL_TRC_SMPTE240M: {
+        const double a = 1.1115, b = 0.0228;
+        return v < 4.0 * b ? v / 4.0 : pow((v + a - 1.0) / a, 1.0 / 0.45);
+    }
+    case AVCOL_TRC_GAMMA22:
+        return pow(v, 2.2);
+    case AVCOL_TRC_GAMMA28:
+        return pow(v, 2.8);
+    case AVCOL_TRC_IEC61966_2_1:
+        return v <= 0.04045 ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4);
+    case AVCOL_TRC_SMPTE2084: {
+        const double c1 =         3424.0 / 4096.0;
+        const double c2 =  32.0 * 2413.0 / 4096.0;
+        const double c3 =  32.0 * 2392.0 / 4096.0;
+        const double m  = 128.0 * 2523.0 / 4096.0;
+        const double n  =  0.25 * 2610.0 / 4096.0;
+        const double p  = pow(v, 1.0 / m);
+        return 10000.0 / REFERENCE_WHITE * pow(FFMAX(p - c1, 0.0) / (c2 - c3 * p), 1.0 / n);
+    }
+    case AVCOL_TRC_ARIB_STD_B67: {
+        /* inverse OETF, followed by a per-component approximation of the
+         * BT.2100 OOTF for a 1000 nits display */
+        const double a = 0.17883277, b = 0.28466892, c = 0.55991073;
+        double e = v <= 0.5 ? v * v / 3.0 : (exp((v - c) / a) + b) / 12.0;
+        return HLG_PEAK * pow(e, 1.2);
+    }
+    default:
+        return v;
+    }
+}
+
+/**
+ * Inverse of trc_to_linear().
+ */
+static double trc_from_linear(enum AVColorTransferCharacteristic trc, double l)
+{
+    avpriv_trc_function func = avpriv_get_trc_function_from_trc(trc);
+
+    switch (trc) {
+    case AVCOL_TRC_SMPTE2084:
+        return func(l * REFERENCE_WHITE);
+    case AVCOL_TRC_ARIB_STD_B67:
+        return func(pow(l / HLG_PEAK, 1.0 / 1.2));
+    default:
+        return func(l);
+    }
+}
+
+static void matrix_invert_3x3(const double in[3][3], double out[3][3])
+{
+    double det;
+
+    out[0][0] =  (in[1][1] * in[2][2] - in[2][1] * in[1][2]);
+    out[0][1] = -(in[0][1] * in[2][2] - in[2][1] * in[0][2]);
+    out[0][2] =  (in[0][1] * in[1][2] - in[1][1] * in[0][2]);
+    out[1][0] = -(in[1][0] * in[2][2] - in[2][0] * in[1][2]);
+    out[1][1] =  (in[0][0] * in[2][2] - in[2][0] * in[0][2]);
+    out[1][2] = -(in[0][0] * in[1][2] - in[1][0] * in[0][2]);
+    out[2][0] =  (in[1][0] * in[2][1] - in[2][0] * in[1][1]);
+    out[2][1] = -(in[0][0] * in[2][1] - in[2][0] * in[0][1]);
+    out[2][2] =  (in[0][0] * in[1][1] - in[1][0] * in[0][1]);
+
+    det = in[0][0] * out[0][0] + in[1][0] * out[0][1] + in[2][0] * out[0][2];
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            out[i][j] /= det;
+}
+
+static void fill_rgb2xyz_table(const ColorPrimaries *p, double rgb2xyz[3][3])
+{
+    double i[3][3], sr, sg, sb, zw;
+
+    rgb2xyz[0][0] = p->xr / p->yr;
+    rgb2xyz[0][1] = p->xg / p->yg;
+    rgb2xyz[0][2] = p->xb / p->yb;
+    rgb2xyz[1][0] = rgb2xyz[1][1] = rgb2xyz[1][2] = 1.0;
+    rgb2xyz[2][0] = (1.0 - p->xr - p->yr) / p->yr;
+    rgb2xyz[2][1] = (1.0 - p->xg - p->yg) / p->yg;
+    rgb2xyz[2][2] = (1.0 - p->xb - p->yb) / p->yb;
+    matrix_invert_3x3(rgb2xyz, i);
+    zw = 1.0 - p->xw - p->yw;
+    sr = i[0][0] * p->xw + i[0][1] * p->yw + i[0][2] * zw;
+    sg = i[1][0] * p->xw + i[1][1] * p->yw + i[1][2] * zw;
+    sb = i[2][0] * p->xw + i[2][1] * p->yw + i[2][2] * zw;
+    for (int k = 0; k < 3; k++) {
+        rgb2xyz[k][0] *= sr;
+        rgb2xyz[k][1] *= sg;
+        rgb2xyz[k][2] *= sb;
+    }
+}
+
+static int primaries_valid(enum AVColorPrimaries prim)
+{
+    return prim >= 0 && prim < AVCOL_PRI_NB && color_primaries[prim].yr != 0.0;
+}
+
+static enum AVColorTransferCharacteristic get_trc(int trc, int other)
+{
+    if (trc != AVCOL_TRC_UNSPECIFIED)
+        return trc;
+    return other != AVCOL_TRC_UNSPECIFIED ? other : AVCOL_TRC_BT709;
+}
+
+int ff_sws_color_needed(SwsContext *c)
+{
+    int prim = c->src_primaries != AVCOL_PRI_UNSPECIFIED &&
+               c->dst_primaries != AVCOL_PRI_UNSPECIFIED &&
+               c->src_primaries != c->dst_primaries;
+    int trc  = c->src_trc != AVCOL_TRC_UNSPECIFIED &&
+               c->dst_trc != AVCOL_TRC_UNSPECIFIED &&
+               c->src_trc != c->dst_trc;
+    return prim || trc;
+}
+
+int ff_sws_init_color(SwsContext *c, SwsContext *c2)
+{
+    enum AVColorTransferCharacteristic src_trc = get_trc(c->src_trc, c->dst_trc);
+    enum AVColorTransferCharacteristic dst_trc = get_trc(c->dst_trc, c->src_trc);
+    double src_peak = c->tonemap_peak > 0 ? c->tonemap_peak : trc_peak(src_trc);
+    double dst_peak = trc_peak(dst_trc);
+    /* with tone mapping, this is the destination peak the curve maps to */
+    double lin_peak = FFMIN(src_peak, dst_peak);
+    int gamut = 0;
+
+    if (!trc_supported(src_trc) || !trc_supported(dst_trc)) {
+        av_log(c, AV_LOG_ERROR, "Unsupported transfer characteristics %s -> %s\n",
+               av_color_transfer_name(src_trc), av_color_transfer_name(dst_trc));
+        return AVERROR(EINVAL);
+    }
+
+    if (c->src_primaries != AVCOL_PRI_UNSPECIFIED &&
+        c->dst_primaries != AVCOL_PRI_UNSPECIFIED &&
+        c->src_primaries != c->dst_primaries) {
+        double src2xyz[3][3], dst2xyz[3][3], xyz2dst[3][3];
+
+        if (!primaries_valid(c->src_primaries) || !primaries_valid(c->dst_primaries)) {
+            av_log(c, AV_LOG_ERROR, "Unsupported primaries %s -> %s\n",
+                   av_color_primaries_name(c->src_primaries),
+                   av_color_primaries_name(c->dst_primaries));
+            return AVERROR(EINVAL);
+        }
+
+        fill_rgb2xyz_table(&color_primaries[c->src_primaries], src2xyz);
+        fill_rgb2xyz_table(&color_primaries[c->dst_primaries], dst2xyz);
+        matrix_invert_3x3(dst2xyz, xyz2dst);
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                c2->gamut_matrix[i][j] = xyz2dst[i][0] * src2xyz[0][j] +
+                                         xyz2dst[i][1] * src2xyz[1][j] +
+                                         xyz2dst[i][2] * src2xyz[2][j];
+        gamut = 1;
+    }
+
+    c2->tonemap      = src_peak > dst_peak ? c->tonemap : SWS_TONEMAP_NONE;
+    c2->tonemap_peak = src_peak / dst_peak;
+
+    c2->gamma = av_malloc(sizeof(*c2->gamma) << 16);
+    if (!c2->gamma)
+        return AVERROR(ENOMEM);
+    for (int i = 0; i < 1 << 16; i++)
+        c2->gamma[i] = av_clip_uint16(lrint(trc_from_linear(dst_trc, i / 65535.0 * lin_peak) * 65535.0));
+
+    if (!gamut && c2->tonemap == SWS_TONEMAP_NONE) {
+        /* linearization and clipping only, a 16-bit table is enough */
+        c2->inv_gamma = av_malloc(sizeof(*c2->inv_gamma) << 16);
+        if (!c2->inv_gamma)
+            return AVERROR(ENOMEM);
+        for (int i = 0; i < 1 << 16; i++)
+            c2->inv_gamma[i] = av_clip_uint16(lrint(trc_to_linear(src_trc, i / 65535.0) / lin_peak * 65535.0));
+        return 0;
+    }
+
+    if (!gamut) {
+        for (int i = 0; i < 3; i++)
+            for (int j = 0; j < 3; j++)
+                c2->gamut_matrix[i][j] = i == j;
+    }
+
+    c2->lin_table = av_malloc(sizeof(*c2->lin_table) << 16);
+    if (!c2->lin_table)
+        return AVERROR(ENOMEM);
+    for (int i = 0; i < 1 << 16; i++)
+        c2->lin_table[i] = trc_to_linear(src_trc, i / 65535.0) / lin_peak;
+
+    return 0;
+}
+
+typedef struct ColorContext {
+    const float *table;
+    float matrix[3][3];
+    SwsToneMapping tonemap;
+    float peak;
+} ColorContext;
+
+static float hable(float in)
+{
+    const float a = 0.15f, b = 0.50f, c = 0.10f, d = 0.20f, e = 0.02f, f = 0.30f;
+    return (in * (in * a + b * c) + d * e) / (in * (in * a + b) + d * f) - e / f;
+}
+
+static float tone_curve(const ColorContext *instance, float sig)
+{
+    float peak = instance->peak;
+
+    switch (instance->tonemap) {
+    case SWS_TONEMAP_LINEAR:
+        return sig / peak;
+    case SWS_TONEMAP_REINHARD:
+        return sig / (sig + 1.0f) * (peak + 1.0f) / peak;
+    case SWS_TONEMAP_HABLE:
+        return hable(sig) / hable(peak);
+    default:
+        return sig;
+    }
+}
+
+static av_always_inline uint16_t to_u16(float v)
+{
+    return av_clipf(v, 0.0f, 1.0f) * 65535.0f + 0.5f;
+}
+
+// color_convert expects 16 bit rgb format, it works in place like gamma_convert
+static int color_convert(SwsContext *c, SwsFilterDescriptor *desc, int sliceY, int sliceH)
+{
+    const ColorContext *instance = desc->instance;
+    const float *table = instance->table;
+    const float (*m)[3] = instance->matrix;
+    int srcW = desc->src->width;
+
+    for (int i = 0; i < sliceH; i++) {
+        int src_pos = sliceY + i - desc->src->plane[0].sliceY;
+        uint16_t *src = (uint16_t *)desc->src->plane[0].line[src_pos];
+
+        for (int j = 0; j < srcW; j++) {
+            float r = table[AV_RL16(src + j*4 + 0)];
+            float g = table[AV_RL16(src + j*4 + 1)];
+            float b = table[AV_RL16(src + j*4 + 2)];
+            float r2 = m[0][0] * r + m[0][1] * g + m[0][2] * b;
+            float g2 = m[1][0] * r + m[1][1] * g + m[1][2] * b;
+            float b2 = m[2][0] * r + m[2][1] * g + m[2][2] * b;
+
+            if (instance->tonemap != SWS_TONEMAP_NONE) {
+                /* scale all components by the same factor to preserve hue */
+                float sig = FFMAX3(r2, g2, b2);
+                if (sig > 1e-6f) {
+                    float gain = tone_curve(instance, sig) / sig;
+                    r2 *= gain;
+                    g2 *= gain;
+                    b2 *= gain;
+                }
+            }
+
+            AV_WL16(src + j*4 + 0, to_u16(r2));
+            AV_WL16(src + j*4 + 1, to_u16(g2));
+            AV_WL16(src + j*4 + 2, to_u16(b2));
+        }
+    }
+    return sliceH;
+}
+
+int ff_init_color_convert(SwsContext *c, SwsFilterDescriptor *desc, SwsSlice *src)
+{
+    ColorContext *li = av_malloc(sizeof(*li));
+    if (!li)
+        return AVERROR(ENOMEM);
+    li->table   = c->lin_table;
+    li->tonemap = c->tonemap;
+    li->peak    = c->tonemap_peak;
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            li->matrix[i][j] = c->gamut_matrix[i][j];
+
+    desc->instance = li;
+    desc->src = src;
+    desc->dst = NULL;
+    desc->process = &color_convert;
+
+    return 0;
+}
@@ -18,6 +18,11 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <math.h>
+
+#include "libavutil/common.h"
+#include "libavutil/intreadwrite.h"
+#include "libavutil/mem.h"
 #include "swscale_internal.h"
 
 typedef struct GammaContext
@@ -70,3 +75,281 @@ int ff_init_gamma_convert(SwsFilterDescriptor *desc, SwsSlice * src, uint16_t *t
     return 0;
 }
 
+
+/* fractional bits of the YUV to R'G'B' contribution tables */
+#define LIN_FRAC 8
+
+enum LinearizeLayout {
+    LIN_NONE,
+    LIN_PLANAR_YUV,
+    LIN_PLANAR_RGB,
+    LIN_PACKED_RGB,
+};
+
+static int linearize_layout(const AVPixFmtDescriptor *desc)
+{
+    const int depth = desc->comp[0].depth;
+
+    if (desc->flags & (AV_PIX_FMT_FLAG_BE | AV_PIX_FMT_FLAG_PAL |
+                       AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_HWACCEL |
+                       AV_PIX_FMT_FLAG_BAYER | AV_PIX_FMT_FLAG_FLOAT))
+        return LIN_NONE;
+    if (desc->nb_components < 3 || depth < 8 || depth > 16)
+        return LIN_NONE;
+    for (int i = 0; i < desc->nb_components; i++)
+        if (desc->comp[i].depth != depth || desc->comp[i].shift)
+            return LIN_NONE;
+
+    if (desc->flags & AV_PIX_FMT_FLAG_PLANAR) {
+        /* planar alpha is left to the generic conversion */
+        if (desc->nb_components != 3 ||
+            desc->comp[0].plane == desc->comp[1].plane ||
+            desc->comp[1].plane == desc->comp[2].plane)
+            return LIN_NONE;
+        return desc->flags & AV_PIX_FMT_FLAG_RGB ? LIN_PLANAR_RGB : LIN_PLANAR_YUV;
+    }
+
+    if ((desc->flags & AV_PIX_FMT_FLAG_RGB) && depth == 8 &&
+        (desc->comp[0].step == 3 || desc->comp[0].step == 4))
+        return LIN_PACKED_RGB;
+
+    return LIN_NONE;
+}
+
+int ff_sws_init_linearize(SwsContext *c)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(c->srcFormat);
+    const int layout = linearize_layout(desc);
+    const int depth  = desc->comp[0].depth;
+    int size, max;
+
+    av_freep(&c->lin_lut);
+    av_freep(&c->lin_yuv);
+
+    if (layout == LIN_NONE)
+        return 0;
+
+    /* R'G'B' sources index the table directly, YUV sources get a few extra
+     * bits for the result of the matrix */
+    c->lin_bits = layout == LIN_PLANAR_YUV ? av_clip(depth + 2, 12, 16) : depth;
+    max = (1 << c->lin_bits) - 1;
+
+    c->lin_lut = av_malloc_array(max + 1, sizeof(*c->lin_lut));
+    if (!c->lin_lut)
+        return AVERROR(ENOMEM);
+    for (int i = 0; i <= max; i++)
+        c->lin_lut[i] = lrint(pow(i / (double)max, c->gamma_value) * 65535.0);
+
+    if (layout == LIN_PLANAR_YUV) {
+        const double scale = max / 255.0 * (1 << LIN_FRAC);
+        const double shift = 1 << (depth - 8);
+        const double sat   = c->contrast / 65536.0 * c->saturation / 65536.0;
+        double cy  = c->contrast / 65536.0;
+        double oy  = 16 - c->brightness / 256.0;
+        double crv = c->srcColorspaceTable[0] / 65536.0;
+        double cbu = c->srcColorspaceTable[1] / 65536.0;
+        double cgu = c->srcColorspaceTable[2] / 65536.0;
+        double cgv = c->srcColorspaceTable[3] / 65536.0;
+        int32_t *ytab, *vr, *ug, *vg, *ub;
+
+        /* same matrix as ff_yuv2rgb_c_init_tables() */
+        if (!c->srcRange) {
+            cy *= 255.0 / 219;
+        } else {
+            oy  -= 16;
+            crv *= 224.0 / 255;
+            cbu *= 224.0 / 255;
+            cgu *= 224.0 / 255;
+            cgv *= 224.0 / 255;
+        }
+
+        size = 1 << depth;
+        c->lin_yuv = av_malloc_array(5 * size, sizeof(*c->lin_yuv));
+        if (!c->lin_yuv)
+            return AVERROR(ENOMEM);
+        ytab = c->lin_yuv;
+        vr   = ytab + size;
+        ug   = vr   + size;
+        vg   = ug   + size;
+        ub   = vg   + size;
+
+        for (int i = 0; i < size; i++) {
+            const double v = i / shift;
+            ytab[i] = lrint(cy * (v - oy) * scale) + (1 << (LIN_FRAC - 1));
+            vr[i]   = lrint( crv * sat * (v - 128) * scale);
+            ug[i]   = lrint(-cgu * sat * (v - 128) * scale);
+            vg[i]   = lrint(-cgv * sat * (v - 128) * scale);
+            ub[i]   = lrint( cbu * sat * (v - 128) * scale);
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Find the two chroma samples around luma sample i and the weight of the
+ * second one, in 1/256, for chroma sited at pos/256 luma samples (as in
+ * the *_chr_pos options) and subsampled by 1 << sub. n is the number of
+ * chroma samples available.
+ */
+static av_always_inline void chroma_pos(int i, int pos, int sub, int n,
+                                        int *c0, int *c1, int *w)
+{
+    const int p = (i << 8) - pos;
+
+    *c0 = av_clip(p >> (8 + sub),     0, n - 1);
+    *c1 = av_clip((p >> (8 + sub)) + 1, 0, n - 1);
+    *w  = (p >> sub) & 0xFF;
+}
+
+static av_always_inline int chroma_lerp(int a, int b, int w)
+{
+    return (a * (256 - w) + b * w + 128) >> 8;
+}
+
+static av_always_inline int chr_pos_default(int pos, int sub)
+{
+    /* same default as in utils.c, the chroma is centered */
+    return pos == -1 || pos <= -513 ? (128 << sub) - 128 : pos;
+}
+
+static av_always_inline void
+linearize_planar_yuv(const SwsContext *c, const AVPixFmtDescriptor *desc,
+                     const uint8_t *const src[4], const int srcStride[4],
+                     int sliceH, int y0, int h,
+                     uint8_t *dst, int dstStride, int is16)
+{
+    const int size = 1 << desc->comp[0].depth;
+    const int mask = size - 1;
+    const int bits = c->lin_bits;
+    const uint16_t *lut = c->lin_lut;
+    const int32_t *ytab = c->lin_yuv;
+    const int32_t *vr   = ytab + size;
+    const int32_t *ug   = vr   + size;
+    const int32_t *vg   = ug   + size;
+    const int32_t *ub   = vg   + size;
+    const int hsub = desc->log2_chroma_w;
+    const int vsub = desc->log2_chroma_h;
+    const int hpos = chr_pos_default(c->src_h_chr_pos, hsub);
+    const int vpos = chr_pos_default(c->src_v_chr_pos, vsub);
+    const int chrW = AV_CEIL_RSHIFT(c->srcW, hsub);
+    const int chrH = AV_CEIL_RSHIFT(sliceH,  vsub);
+
+#define CHR(s, x) (is16 ? AV_RL16((s) + 2 * (x)) & mask : (s)[x])
+
+    for (int y = 0; y < h; y++) {
+        const uint8_t *sy = src[0] + (y0 + y) * srcStride[0];
+        const uint8_t *su0, *su1, *sv0, *sv1;
+        uint16_t *d = (uint16_t *)(dst + y * dstStride);
+        int r0, r1, wy;
+
+        /* chroma lines outside of the slice are replaced by its edges */
+        chroma_pos(y0 + y, vpos, vsub, chrH, &r0, &r1, &wy);
+        su0 = src[1] + r0 * srcStride[1];
+        su1 = src[1] + r1 * srcStride[1];
+        sv0 = src[2] + r0 * srcStride[2];
+        sv1 = src[2] + r1 * srcStride[2];
+
+        for (int x = 0; x < c->srcW; x++) {
+            const int Y = is16 ? AV_RL16(sy + 2 * x) & mask : sy[x];
+            int U, V, l;
+
+            if (!hsub && !vsub) {
+                U = CHR(su0, x);
+                V = CHR(sv0, x);
+            } else {
+                int x0, x1, wx;
+
+                chroma_pos(x, hpos, hsub, chrW, &x0, &x1, &wx);
+                U = chroma_lerp(chroma_lerp(CHR(su0, x0), CHR(su1, x0), wy),
+                                chroma_lerp(CHR(su0, x1), CHR(su1, x1), wy), wx);
+                V = chroma_lerp(chroma_lerp(CHR(sv0, x0), CHR(sv1, x0), wy),
+                                chroma_lerp(CHR(sv0, x1), CHR(sv1, x1), wy), wx);
+            }
+            l = ytab[Y];
+
+            AV_WL16(d + 4 * x + 0, lut[av_clip_uintp2((l + vr[V])         >> LIN_FRAC, bits)]);
+            AV_WL16(d + 4 * x + 1, lut[av_clip_uintp2((l + ug[U] + vg[V]) >> LIN_FRAC, bits)]);
+            AV_WL16(d + 4 * x + 2, lut[av_clip_uintp2((l + ub[U])         >> LIN_FRAC, bits)]);
+            AV_WL16(d + 4 * x + 3, 0xFFFF);
+        }
+    }
+#undef CHR
+}
+
+static av_always_inline void
+linearize_planar_rgb(const SwsContext *c, const AVPixFmtDescriptor *desc,
+                     const uint8_t *const src[4], const int srcStride[4],
+                     int y0, int h, uint8_t *dst, int dstStride, int is16)
+{
+    const int mask = (1 << desc->comp[0].depth) - 1;
+    const uint16_t *lut = c->lin_lut;
+    const int pr = desc->comp[0].plane;
+    const int pg = desc->comp[1].plane;
+    const int pb = desc->comp[2].plane;
+
+    for (int y = 0; y < h; y++) {
+        const uint8_t *sr = src[pr] + (y0 + y) * srcStride[pr];
+        const uint8_t *sg = src[pg] + (y0 + y) * srcStride[pg];
+        const uint8_t *sb = src[pb] + (y0 + y) * srcStride[pb];
+        uint16_t *d = (uint16_t *)(dst + y * dstStride);
+
+        for (int x = 0; x < c->srcW; x++) {
+            AV_WL16(d + 4 * x + 0, lut[is16 ? AV_RL16(sr + 2 * x) & mask : sr[x]]);
+            AV_WL16(d + 4 * x + 1, lut[is16 ? AV_RL16(sg + 2 * x) & mask : sg[x]]);
+            AV_WL16(d + 4 * x + 2, lut[is16 ? AV_RL16(sb + 2 * x) & mask : sb[x]]);
+            AV_WL16(d + 4 * x + 3, 0xFFFF);
+        }
+    }
+}
+
+static void linearize_packed_rgb(const SwsContext *c, const AVPixFmtDescriptor *desc,
+                                 const uint8_t *src, int srcStride,
+                                 int h, uint8_t *dst, int dstStride)
+{
+    const uint16_t *lut = c->lin_lut;
+    const int step = desc->comp[0].step;
+    const int r = desc->comp[0].offset;
+    const int g = desc->comp[1].offset;
+    const int b = desc->comp[2].offset;
+    const int a = desc->flags & AV_PIX_FMT_FLAG_ALPHA ? desc->comp[3].offset : -1;
+
+    for (int y = 0; y < h; y++) {
+        const uint8_t *s = src + y * srcStride;
+        uint16_t *d = (uint16_t *)(dst + y * dstStride);
+
+        for (int x = 0; x < c->srcW; x++, s += step) {
+            AV_WL16(d + 4 * x + 0, lut[s[r]]);
+            AV_WL16(d + 4 * x + 1, lut[s[g]]);
+            AV_WL16(d + 4 * x + 2, lut[s[b]]);
+            AV_WL16(d + 4 * x + 3, a >= 0 ? s[a] * 257 : 0xFFFF);
+        }
+    }
+}
+
+void ff_sws_linearize(const SwsContext *c, const uint8_t *const src[4],
+                      const int srcStride[4], int sliceH, int y, int h,
+                      uint8_t *dst, int dstStride)
+{
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(c->srcFormat);
+    const int is16 = desc->comp[0].depth > 8;
+
+    switch (linearize_layout(desc)) {
+    case LIN_PLANAR_YUV:
+        if (is16)
+            linearize_planar_yuv(c, desc, src, srcStride, sliceH, y, h, dst, dstStride, 1);
+        else
+            linearize_planar_yuv(c, desc, src, srcStride, sliceH, y, h, dst, dstStride, 0);
+        break;
+    case LIN_PLANAR_RGB:
+        if (is16)
+            linearize_planar_rgb(c, desc, src, srcStride, y, h, dst, dstStride, 1);
+        else
+            linearize_planar_rgb(c, desc, src, srcStride, y, h, dst, dstStride, 0);
+        break;
+    case LIN_PACKED_RGB:
+        linearize_packed_rgb(c, desc, src[0] + y * srcStride[0], srcStride[0],
+                             h, dst, dstStride);
+        break;
+    }
+}
@@ -18,6 +18,8 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <float.h>
+
 #include "libavutil/opt.h"
 #include "swscale.h"
 #include "swscale_internal.h"
@@ -79,6 +81,47 @@ static const AVOption swscale_options[] = {
     { "uniform_color",   "blend onto a uniform color",    0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_ALPHA_BLEND_UNIFORM},INT_MIN, INT_MAX,     VE, "alphablend" },
     { "checkerboard",    "blend onto a checkerboard",     0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_ALPHA_BLEND_CHECKERBOARD},INT_MIN, INT_MAX,     VE, "alphablend" },
 
+    { "src_primaries",   "source color primaries",        OFFSET(src_primaries), AV_OPT_TYPE_INT, { .i64 = AVCOL_PRI_UNSPECIFIED }, 0, AVCOL_PRI_NB - 1, VE, "primaries" },
+    { "dst_primaries",   "destination color primaries",   OFFSET(dst_primaries), AV_OPT_TYPE_INT, { .i64 = AVCOL_PRI_UNSPECIFIED }, 0, AVCOL_PRI_NB - 1, VE, "primaries" },
+    { "unspecified",     NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_UNSPECIFIED }, INT_MIN, INT_MAX,     VE, "primaries" },
+    { "bt709",           NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_BT709     }, INT_MIN, INT_MAX,        VE, "primaries" },
+    { "bt470m",          NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_BT470M    }, INT_MIN, INT_MAX,        VE, "primaries" },
+    { "bt470bg",         NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_BT470BG   }, INT_MIN, INT_MAX,        VE, "primaries" },
+    { "smpte170m",       NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_SMPTE170M }, INT_MIN, INT_MAX,        VE, "primaries" },
+    { "smpte240m",       NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_SMPTE240M }, INT_MIN, INT_MAX,        VE, "primaries" },
+    { "film",            NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_FILM      }, INT_MIN, INT_MAX,        VE, "primaries" },
+    { "bt2020",          NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_BT2020    }, INT_MIN, INT_MAX,        VE, "primaries" },
+    { "smpte428",        NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_SMPTE428  }, INT_MIN, INT_MAX,        VE, "primaries" },
+    { "smpte431",        NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_SMPTE431  }, INT_MIN, INT_MAX,        VE, "primaries" },
+    { "smpte432",        NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_SMPTE432  }, INT_MIN, INT_MAX,        VE, "primaries" },
+    { "ebu3213",         NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_PRI_EBU3213   }, INT_MIN, INT_MAX,        VE, "primaries" },
+
+    { "src_trc",         "source transfer characteristics",      OFFSET(src_trc), AV_OPT_TYPE_INT, { .i64 = AVCOL_TRC_UNSPECIFIED }, 0, AVCOL_TRC_NB - 1, VE, "trc" },
+    { "dst_trc",         "destination transfer characteristics", OFFSET(dst_trc), AV_OPT_TYPE_INT, { .i64 = AVCOL_TRC_UNSPECIFIED }, 0, AVCOL_TRC_NB - 1, VE, "trc" },
+    { "unspecified",     NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_UNSPECIFIED  }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "bt709",           NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_BT709        }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "gamma22",         NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_GAMMA22      }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "gamma28",         NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_GAMMA28      }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "smpte170m",       NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_SMPTE170M    }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "smpte240m",       NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_SMPTE240M    }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "linear",          NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_LINEAR       }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "iec61966-2-1",    NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_IEC61966_2_1 }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "srgb",            NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_IEC61966_2_1 }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "bt2020-10",       NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_BT2020_10    }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "bt2020-12",       NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_BT2020_12    }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "smpte2084",       NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_SMPTE2084    }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "pq",              NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_SMPTE2084    }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "arib-std-b67",    NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_ARIB_STD_B67 }, INT_MIN, INT_MAX,    VE, "trc" },
+    { "hlg",             NULL,                            0,                 AV_OPT_TYPE_CONST,  { .i64  = AVCOL_TRC_ARIB_STD_B67 }, INT_MIN, INT_MAX,    VE, "trc" },
+
+    { "tonemap",         "tone mapping for high to low dynamic range", OFFSET(tonemap), AV_OPT_TYPE_INT, { .i64 = SWS_TONEMAP_NONE }, 0, SWS_TONEMAP_NB - 1, VE, "tonemap" },
+    { "none",            "clip",                          0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_TONEMAP_NONE     }, INT_MIN, INT_MAX,       VE, "tonemap" },
+    { "linear",          "linear stretch",                0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_TONEMAP_LINEAR   }, INT_MIN, INT_MAX,       VE, "tonemap" },
+    { "reinhard",        "Reinhard",                      0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_TONEMAP_REINHARD }, INT_MIN, INT_MAX,       VE, "tonemap" },
+    { "hable",           "Hable",                         0,                 AV_OPT_TYPE_CONST,  { .i64  = SWS_TONEMAP_HABLE    }, INT_MIN, INT_MAX,       VE, "tonemap" },
+    { "tonemap_peak",    "source signal peak relative to the reference white", OFFSET(tonemap_peak), AV_OPT_TYPE_DOUBLE, { .dbl = 0 }, 0, DBL_MAX, VE },
+    { "color_convert",   "primaries or transfer are converted", OFFSET(color_convert), AV_OPT_TYPE_BOOL, { .i64 = 0 }, 0, 1, VE | AV_OPT_FLAG_EXPORT | AV_OPT_FLAG_READONLY },
+
     { "threads",         "number of threads",             OFFSET(nb_threads),   AV_OPT_TYPE_INT, {.i64 = 1 }, 0, INT_MAX, VE, "threads" },
         { "auto",        NULL,                            0,                  AV_OPT_TYPE_CONST, {.i64 = 0 },    .flags = VE, "threads" },
 
@@ -139,6 +139,24 @@ extern void (*deinterleaveBytes)(const uint8_t *src, uint8_t *dst1, uint8_t *dst
                                  int width, int height, int srcStride,
                                  int dst1Stride, int dst2Stride);
 
+/**
+ * Native endian 16-bit counterparts of the functions above, also shifting
+ * every sample left by shift bits, or right by -shift bits if shift is
+ * negative. width is in samples per plane, strides are in bytes.
+ * Source and destination must not overlap.
+ */
+extern void (*shiftWords)(const uint8_t *src, uint8_t *dst,
+                          int width, int height, int srcStride,
+                          int dstStride, int shift);
+
+extern void (*interleaveWords)(const uint8_t *src1, const uint8_t *src2, uint8_t *dst,
+                               int width, int height, int src1Stride,
+                               int src2Stride, int dstStride, int shift);
+
+extern void (*deinterleaveWords)(const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+                                 int width, int height, int srcStride,
+                                 int dst1Stride, int dst2Stride, int shift);
+
 extern void (*vu9_to_vu12)(const uint8_t *src1, const uint8_t *src2,
                            uint8_t *dst1, uint8_t *dst2,
                            int width, int height,
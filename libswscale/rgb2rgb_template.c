@@ -743,6 +743,71 @@ static void deinterleaveBytes_c(const uint8_t *src, uint8_t *dst1, uint8_t *dst2
     }
 }
 
+static av_always_inline uint16_t shift_word(unsigned v, int shift)
+{
+    return shift >= 0 ? v << shift : v >> -shift;
+}
+
+static void shiftWords_c(const uint8_t *src, uint8_t *dst,
+                         int width, int height, int srcStride,
+                         int dstStride, int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        const uint16_t *s = (const uint16_t *)src;
+        uint16_t *d = (uint16_t *)dst;
+        int w;
+        for (w = 0; w < width; w++)
+            d[w] = shift_word(s[w], shift);
+        src += srcStride;
+        dst += dstStride;
+    }
+}
+
+static void interleaveWords_c(const uint8_t *src1, const uint8_t *src2,
+                              uint8_t *dest, int width, int height,
+                              int src1Stride, int src2Stride, int dstStride,
+                              int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        const uint16_t *s1 = (const uint16_t *)src1;
+        const uint16_t *s2 = (const uint16_t *)src2;
+        uint16_t *d = (uint16_t *)dest;
+        int w;
+        for (w = 0; w < width; w++) {
+            d[2 * w + 0] = shift_word(s1[w], shift);
+            d[2 * w + 1] = shift_word(s2[w], shift);
+        }
+        dest += dstStride;
+        src1 += src1Stride;
+        src2 += src2Stride;
+    }
+}
+
+static void deinterleaveWords_c(const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+                                int width, int height, int srcStride,
+                                int dst1Stride, int dst2Stride, int shift)
+{
+    int h;
+
+    for (h = 0; h < height; h++) {
+        const uint16_t *s = (const uint16_t *)src;
+        uint16_t *d1 = (uint16_t *)dst1;
+        uint16_t *d2 = (uint16_t *)dst2;
+        int w;
+        for (w = 0; w < width; w++) {
+            d1[w] = shift_word(s[2 * w + 0], shift);
+            d2[w] = shift_word(s[2 * w + 1], shift);
+        }
+        src  += srcStride;
+        dst1 += dst1Stride;
+        dst2 += dst2Stride;
+    }
+}
+
 static inline void vu9_to_vu12_c(const uint8_t *src1, const uint8_t *src2,
                                  uint8_t *dst1, uint8_t *dst2,
                                  int width, int height,
@@ -982,6 +1047,9 @@ static av_cold void rgb2rgb_init_c(void)
     ff_rgb24toyv12     = ff_rgb24toyv12_c;
     interleaveBytes    = interleaveBytes_c;
     deinterleaveBytes  = deinterleaveBytes_c;
+    shiftWords         = shiftWords_c;
+    interleaveWords    = interleaveWords_c;
+    deinterleaveWords  = deinterleaveWords_c;
     vu9_to_vu12        = vu9_to_vu12_c;
     yvu9_to_yuy2       = yvu9_to_yuy2_c;
 
@@ -822,38 +822,157 @@ static int scale_internal(SwsContext *c,
                           uint8_t *const dstSlice[], const int dstStride[],
                           int dstSliceY, int dstSliceH);
 
+/* number of source lines fed through the gamma cascade at once, so that the
+ * intermediate lines are still in cache when the next step reads them */
+#define GAMMA_STRIP_LINES 16
+
+/* source lines c reads to output the destination lines [dstY, dstY + dstH) */
+static void gamma_src_lines(const SwsContext *c, int dstY, int dstH,
+                            int *srcY, int *srcH)
+{
+    int first = dstY, end = dstY + dstH;
+
+    if (!c->convert_unscaled) {
+        const int chrY   = dstY >> c->chrDstVSubSample;
+        const int chrEnd = (dstY + dstH - 1) >> c->chrDstVSubSample;
+
+        first = FFMIN(c->vLumFilterPos[dstY],
+                      c->vChrFilterPos[chrY] << c->chrSrcVSubSample);
+        end   = FFMAX(c->vLumFilterPos[dstY + dstH - 1] + c->vLumFilterSize,
+                      (c->vChrFilterPos[chrEnd] + c->vChrFilterSize) << c->chrSrcVSubSample);
+    }
+    *srcY = av_clip(first, 0, c->srcH);
+    *srcH = av_clip(end, 0, c->srcH) - *srcY;
+}
+
+/* With slice threading every slice context gets the whole source, only
+ * convert the lines that the destination slice is computed from. */
+static int scale_gamma_dst(SwsContext *c,
+                           const uint8_t * const srcSlice[], const int srcStride[],
+                           int srcSliceY, int srcSliceH,
+                           uint8_t * const dstSlice[], const int dstStride[],
+                           int dstSliceY, int dstSliceH)
+{
+    SwsContext *c1 = c->cascaded_context[1], *c2 = c->cascaded_context[2];
+    const int macro_height = isBayer(c->srcFormat) ? 2 : 1 << c->chrSrcVSubSample;
+    const uint8_t *tmp[4] = { NULL };
+    uint8_t *tmp_dst[4] = { NULL };
+    int tmpY, tmpH, tmp1Y = dstSliceY, tmp1H = dstSliceH, end, ret;
+
+    if (c2)
+        gamma_src_lines(c2, dstSliceY, dstSliceH, &tmp1Y, &tmp1H);
+    gamma_src_lines(c1, tmp1Y, tmp1H, &tmpY, &tmpH);
+
+    end  = FFMIN(FFALIGN(tmpY + tmpH, macro_height), c->srcH);
+    tmpY = tmpY & ~(macro_height - 1);
+    tmpH = end - tmpY;
+
+    if (c->cascaded_context[0]) {
+        tmp_dst[0] = c->cascaded_tmp[0] + tmpY * c->cascaded_tmpStride[0];
+        ret = scale_internal(c->cascaded_context[0], srcSlice, srcStride,
+                             srcSliceY, srcSliceH,
+                             tmp_dst, c->cascaded_tmpStride, tmpY, tmpH);
+        if (ret < 0)
+            return ret;
+    } else {
+        ff_sws_linearize(c, srcSlice, srcStride, srcSliceH, tmpY, tmpH,
+                         c->cascaded_tmp[0] + tmpY * c->cascaded_tmpStride[0],
+                         c->cascaded_tmpStride[0]);
+    }
+
+    tmp[0] = c->cascaded_tmp[0];
+    if (!c2)
+        return scale_internal(c1, tmp, c->cascaded_tmpStride, 0, c->srcH,
+                              dstSlice, dstStride, dstSliceY, dstSliceH);
+
+    tmp_dst[0] = c->cascaded1_tmp[0] + tmp1Y * c->cascaded1_tmpStride[0];
+    ret = scale_internal(c1, tmp, c->cascaded_tmpStride, 0, c->srcH,
+                         tmp_dst, c->cascaded1_tmpStride, tmp1Y, tmp1H);
+    if (ret < 0)
+        return ret;
+
+    tmp[0] = c->cascaded1_tmp[0];
+    return scale_internal(c2, tmp, c->cascaded1_tmpStride, 0, c->dstH,
+                          dstSlice, dstStride, dstSliceY, dstSliceH);
+}
+
 static int scale_gamma(SwsContext *c,
                        const uint8_t * const srcSlice[], const int srcStride[],
                        int srcSliceY, int srcSliceH,
                        uint8_t * const dstSlice[], const int dstStride[],
                        int dstSliceY, int dstSliceH)
 {
-    int ret = scale_internal(c->cascaded_context[0],
-                             srcSlice, srcStride, srcSliceY, srcSliceH,
-                             c->cascaded_tmp, c->cascaded_tmpStride, 0, c->srcH);
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(c->srcFormat);
+    const int scale_dst = dstSliceY > 0 || dstSliceH < c->dstH;
+    int strip_h = srcSliceH;
+    int lines = 0;
+
+    if (scale_dst)
+        return scale_gamma_dst(c, srcSlice, srcStride, srcSliceY, srcSliceH,
+                               dstSlice, dstStride, dstSliceY, dstSliceH);
+
+    /* strips can only be cut from slices that are passed top to bottom */
+    if (srcSliceY == 0 || c->cascaded_context[1]->sliceDir == 1)
+        strip_h = FFALIGN(GAMMA_STRIP_LINES, isBayer(c->srcFormat) ? 2 : 1 << c->chrSrcVSubSample);
+
+    for (int y = 0; y < srcSliceH; y += strip_h) {
+        const uint8_t *src[4], *tmp[4] = { NULL };
+        int h = FFMIN(strip_h, srcSliceH - y);
+        int tmpY = srcSliceY + y;
+        int ret;
+
+        for (int i = 0; i < 4; i++) {
+            src[i] = srcSlice[i];
+            if (src[i] && !(i == 1 && usePal(c->srcFormat)))
+                src[i] += (y >> ((i == 1 || i == 2) ? desc->log2_chroma_h : 0)) * srcStride[i];
+        }
 
-    if (ret < 0)
-        return ret;
+        if (c->cascaded_context[0]) {
+            SwsContext *c0 = c->cascaded_context[0];
+
+            ret = scale_internal(c0, src, srcStride, srcSliceY + y, h,
+                                 c->cascaded_tmp, c->cascaded_tmpStride, 0, c->srcH);
+            if (ret < 0)
+                return ret;
+            /* the vertical chroma filter may hold lines back until the
+             * next strip, only pass on the lines that were written */
+            if (!ret)
+                continue;
+            h    = ret;
+            tmpY = c0->convert_unscaled ? srcSliceY + y : c0->dstY - ret;
+        } else {
+            ff_sws_linearize(c, srcSlice, srcStride, srcSliceH, y, h,
+                             c->cascaded_tmp[0] + tmpY * c->cascaded_tmpStride[0],
+                             c->cascaded_tmpStride[0]);
+        }
 
-    if (c->cascaded_context[2])
-        ret = scale_internal(c->cascaded_context[1], (const uint8_t * const *)c->cascaded_tmp,
-                             c->cascaded_tmpStride, srcSliceY, srcSliceH,
-                             c->cascaded1_tmp, c->cascaded1_tmpStride, 0, c->dstH);
-    else
-        ret = scale_internal(c->cascaded_context[1], (const uint8_t * const *)c->cascaded_tmp,
-                             c->cascaded_tmpStride, srcSliceY, srcSliceH,
-                             dstSlice, dstStride, dstSliceY, dstSliceH);
+        /* the intermediate images are packed, only the first plane needs
+         * to point to the start of the slice */
+        tmp[0] = c->cascaded_tmp[0] + tmpY * c->cascaded_tmpStride[0];
+        if (c->cascaded_context[2])
+            ret = scale_internal(c->cascaded_context[1], tmp,
+                                 c->cascaded_tmpStride, tmpY, h,
+                                 c->cascaded1_tmp, c->cascaded1_tmpStride, 0, c->dstH);
+        else
+            ret = scale_internal(c->cascaded_context[1], tmp,
+                                 c->cascaded_tmpStride, tmpY, h,
+                                 dstSlice, dstStride, dstSliceY, dstSliceH);
+        if (ret < 0)
+            return ret;
 
-    if (ret < 0)
-        return ret;
+        if (c->cascaded_context[2]) {
+            int tmp1Y = c->cascaded_context[1]->dstY - ret;
 
-    if (c->cascaded_context[2]) {
-        ret = scale_internal(c->cascaded_context[2], (const uint8_t * const *)c->cascaded1_tmp,
-                             c->cascaded1_tmpStride, c->cascaded_context[1]->dstY - ret,
-                             c->cascaded_context[1]->dstY,
-                             dstSlice, dstStride, dstSliceY, dstSliceH);
+            tmp[0] = c->cascaded1_tmp[0] + tmp1Y * c->cascaded1_tmpStride[0];
+            ret = scale_internal(c->cascaded_context[2], tmp,
+                                 c->cascaded1_tmpStride, tmp1Y, ret,
+                                 dstSlice, dstStride, dstSliceY, dstSliceH);
+            if (ret < 0)
+                return ret;
+        }
+        lines += ret;
     }
-    return ret;
+    return lines;
 }
 
 static int scale_cascaded(SwsContext *c,
@@ -925,7 +1044,7 @@ static int scale_internal(SwsContext *c,
     if (srcSliceH == 0)
         return 0;
 
-    if (c->gamma_flag && c->cascaded_context[0])
+    if (c->cascaded_context[1] && c->cascaded_context[1]->is_internal_gamma)
         return scale_gamma(c, srcSlice, srcStride, srcSliceY, srcSliceH,
                            dstSlice, dstStride, dstSliceY, dstSliceH);
 
@@ -75,6 +75,14 @@ typedef enum SwsDither {
     NB_SWS_DITHER,
 } SwsDither;
 
+typedef enum SwsToneMapping {
+    SWS_TONEMAP_NONE = 0,
+    SWS_TONEMAP_LINEAR,
+    SWS_TONEMAP_REINHARD,
+    SWS_TONEMAP_HABLE,
+    SWS_TONEMAP_NB,
+} SwsToneMapping;
+
 typedef enum SwsAlphaBlend {
     SWS_ALPHA_BLEND_NONE  = 0,
     SWS_ALPHA_BLEND_UNIFORM,
@@ -674,6 +682,22 @@ typedef struct SwsContext {
     unsigned int dst_slice_align;
     atomic_int   stride_unaligned_warned;
     atomic_int   data_unaligned_warned;
+
+    // primaries and transfer conversion, see color.c
+    int src_primaries;            ///< AVColorPrimaries of the source
+    int dst_primaries;            ///< AVColorPrimaries of the destination
+    int src_trc;                  ///< AVColorTransferCharacteristic of the source
+    int dst_trc;                  ///< AVColorTransferCharacteristic of the destination
+    int tonemap;                  ///< SwsToneMapping
+    double tonemap_peak;          ///< source signal peak, relative to the reference white
+    int color_convert;            ///< primaries or transfer conversion done through the gamma cascade
+    float *lin_table;             ///< source linearization table, used instead of inv_gamma for gamut or tone mapping
+    double gamut_matrix[3][3];    ///< linear light source to destination RGB
+
+    // direct source to linear light conversion of the gamma cascade, see gamma.c
+    uint16_t *lin_lut;            ///< R'G'B' code value to linear light
+    int lin_bits;                 ///< log2 of the number of lin_lut entries
+    int32_t *lin_yuv;             ///< Y, V->R, U->G, V->G and U->B contributions, in lin_lut units
 } SwsContext;
 //FIXME check init (where 0)
 
@@ -1113,6 +1137,43 @@ int ff_rotate_slice(SwsSlice *s, int lum, int chr);
 /// initializes gamma conversion descriptor
 int ff_init_gamma_convert(SwsFilterDescriptor *desc, SwsSlice * src, uint16_t *table);
 
+/**
+ * Set up the direct conversion of the source format of c to linear light
+ * RGBA64LE used by the gamma cascade instead of its first context.
+ *
+ * @return 1 if the source format is supported, 0 if it is not, a negative
+ *         error code on failure
+ */
+int ff_sws_init_linearize(SwsContext *c);
+
+/**
+ * Convert lines y to y + h - 1 of a source slice to linear light RGBA64LE.
+ * src points to the first line of the slice, which is sliceH lines high,
+ * dst to the output of line y. Subsampled chroma is interpolated from the
+ * lines of the slice.
+ *
+ * There is no SIMD version: the work is table lookups, which x86 could only
+ * vectorize with gathers.
+ */
+void ff_sws_linearize(const SwsContext *c, const uint8_t *const src[4],
+                      const int srcStride[4], int sliceH, int y, int h,
+                      uint8_t *dst, int dstStride);
+
+/// initializes linearization, gamut and tone mapping descriptor
+int ff_init_color_convert(SwsContext *c, SwsFilterDescriptor *desc, SwsSlice *src);
+
+/**
+ * Check whether the primaries or transfer characteristics set in c differ
+ * between source and destination.
+ */
+int ff_sws_color_needed(SwsContext *c);
+
+/**
+ * Set up the tables of the internal linear light context c2 for the
+ * primaries and transfer conversion requested in c.
+ */
+int ff_sws_init_color(SwsContext *c, SwsContext *c2);
+
 /// initializes lum pixel format conversion descriptor
 int ff_init_desc_fmt_convert(SwsFilterDescriptor *desc, SwsSlice * src, SwsSlice *dst, uint32_t *pal);
 
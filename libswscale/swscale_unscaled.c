@@ -221,53 +221,59 @@ static int nv24ToPlanarWrapper(SwsContext *c, const uint8_t *src[],
     return srcSliceH;
 }
 
-static int planarToP01xWrapper(SwsContext *c, const uint8_t *src8[],
+static int planarToP01xWrapper(SwsContext *c, const uint8_t *src[],
                                int srcStride[], int srcSliceY,
                                int srcSliceH, uint8_t *dstParam8[],
                                int dstStride[])
 {
     const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
     const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
-    const uint16_t **src = (const uint16_t**)src8;
-    uint16_t *dstY = (uint16_t*)(dstParam8[0] + dstStride[0] * srcSliceY);
-    uint16_t *dstUV = (uint16_t*)(dstParam8[1] + dstStride[1] * srcSliceY / 2);
-    int x, y;
+    uint8_t *dstY  = dstParam8[0] + dstStride[0] * srcSliceY;
+    uint8_t *dstUV = dstParam8[1] + dstStride[1] * srcSliceY / 2;
 
     /* Calculate net shift required for values. */
-    const int shift[3] = {
+    const int shift[2] = {
         dst_format->comp[0].depth + dst_format->comp[0].shift -
         src_format->comp[0].depth - src_format->comp[0].shift,
         dst_format->comp[1].depth + dst_format->comp[1].shift -
         src_format->comp[1].depth - src_format->comp[1].shift,
-        dst_format->comp[2].depth + dst_format->comp[2].shift -
-        src_format->comp[2].depth - src_format->comp[2].shift,
     };
 
     av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 || srcStride[2] % 2 ||
                  dstStride[0] % 2 || dstStride[1] % 2));
 
-    for (y = 0; y < srcSliceH; y++) {
-        uint16_t *tdstY = dstY;
-        const uint16_t *tsrc0 = src[0];
-        for (x = c->srcW; x > 0; x--) {
-            *tdstY++ = *tsrc0++ << shift[0];
-        }
-        src[0] += srcStride[0] / 2;
-        dstY += dstStride[0] / 2;
+    shiftWords(src[0], dstY, c->srcW, srcSliceH,
+               srcStride[0], dstStride[0], shift[0]);
+    interleaveWords(src[1], src[2], dstUV, c->srcW / 2, (srcSliceH + 1) / 2,
+                    srcStride[1], srcStride[2], dstStride[1], shift[1]);
 
-        if (!(y & 1)) {
-            uint16_t *tdstUV = dstUV;
-            const uint16_t *tsrc1 = src[1];
-            const uint16_t *tsrc2 = src[2];
-            for (x = c->srcW / 2; x > 0; x--) {
-                *tdstUV++ = *tsrc1++ << shift[1];
-                *tdstUV++ = *tsrc2++ << shift[2];
-            }
-            src[1] += srcStride[1] / 2;
-            src[2] += srcStride[2] / 2;
-            dstUV += dstStride[1] / 2;
-        }
-    }
+    return srcSliceH;
+}
+
+static int p01xToPlanarWrapper(SwsContext *c, const uint8_t *src[],
+                               int srcStride[], int srcSliceY,
+                               int srcSliceH, uint8_t *dstParam[],
+                               int dstStride[])
+{
+    const AVPixFmtDescriptor *src_format = av_pix_fmt_desc_get(c->srcFormat);
+    const AVPixFmtDescriptor *dst_format = av_pix_fmt_desc_get(c->dstFormat);
+    const int vsub = src_format->log2_chroma_h;
+    uint8_t *dstY = dstParam[0] + dstStride[0] * srcSliceY;
+    uint8_t *dstU = dstParam[1] + dstStride[1] * (srcSliceY >> vsub);
+    uint8_t *dstV = dstParam[2] + dstStride[2] * (srcSliceY >> vsub);
+
+    /* The samples are stored MSB aligned in P01x, this is negative for
+     * P010 and 0 for P016. */
+    const int shift = dst_format->comp[0].depth + dst_format->comp[0].shift -
+                      src_format->comp[0].depth - src_format->comp[0].shift;
+
+    av_assert0(!(srcStride[0] % 2 || srcStride[1] % 2 ||
+                 dstStride[0] % 2 || dstStride[1] % 2 || dstStride[2] % 2));
+
+    shiftWords(src[0], dstY, c->srcW, srcSliceH,
+               srcStride[0], dstStride[0], shift);
+    deinterleaveWords(src[1], dstU, dstV, c->chrSrcW, AV_CEIL_RSHIFT(srcSliceH, vsub),
+                      srcStride[1], dstStride[1], dstStride[2], shift);
 
     return srcSliceH;
 }
@@ -2019,6 +2025,15 @@ void ff_get_unscaled_swscale(SwsContext *c)
         (dstFormat == AV_PIX_FMT_P010 || dstFormat == AV_PIX_FMT_P016)) {
         c->convert_unscaled = planarToP01xWrapper;
     }
+    /* p01x_to_yuv4xxp1x */
+    if ((srcFormat == AV_PIX_FMT_P010 && dstFormat == AV_PIX_FMT_YUV420P10) ||
+        (srcFormat == AV_PIX_FMT_P016 && dstFormat == AV_PIX_FMT_YUV420P16) ||
+        (srcFormat == AV_PIX_FMT_P210 && dstFormat == AV_PIX_FMT_YUV422P10) ||
+        (srcFormat == AV_PIX_FMT_P216 && dstFormat == AV_PIX_FMT_YUV422P16) ||
+        (srcFormat == AV_PIX_FMT_P410 && dstFormat == AV_PIX_FMT_YUV444P10) ||
+        (srcFormat == AV_PIX_FMT_P416 && dstFormat == AV_PIX_FMT_YUV444P16)) {
+        c->convert_unscaled = p01xToPlanarWrapper;
+    }
     /* yuv420p_to_p01xle */
     if ((srcFormat == AV_PIX_FMT_YUV420P || srcFormat == AV_PIX_FMT_YUVA420P) &&
         (dstFormat == AV_PIX_FMT_P010LE || dstFormat == AV_PIX_FMT_P016LE)) {
@@ -290,34 +290,35 @@ int ff_shuffle_filter_coefficients(SwsContext *c, int *filterPos,
     if (!filter || dstW % 16 != 0)
         return 0;
     if (EXTERNAL_AVX2_FAST(cpu_flags) && !(cpu_flags & AV_CPU_FLAG_SLOW_GATHER)) {
-        if ((c->srcBpc == 8) && (c->dstBpc <= 14)) {
-           int16_t *filterCopy = NULL;
-           if (filterSize > 4) {
-               if (!FF_ALLOC_TYPED_ARRAY(filterCopy, dstW * filterSize))
-                   return AVERROR(ENOMEM);
-               memcpy(filterCopy, filter, dstW * filterSize * sizeof(int16_t));
-           }
-           // Do not swap filterPos for pixels which won't be processed by
-           // the main loop.
-           for (i = 0; i + 8 <= dstW; i += 8) {
-               FFSWAP(int, filterPos[i + 2], filterPos[i + 4]);
-               FFSWAP(int, filterPos[i + 3], filterPos[i + 5]);
-           }
-           if (filterSize > 4) {
-               // 16 pixels are processed at a time.
-               for (i = 0; i + 16 <= dstW; i += 16) {
-                   // 4 filter coeffs are processed at a time.
-                   for (k = 0; k + 4 <= filterSize; k += 4) {
-                       for (j = 0; j < 16; ++j) {
-                           int from = (i + j) * filterSize + k;
-                           int to = i * filterSize + j * 4 + k * 16;
-                           memcpy(&filter[to], &filterCopy[from], 4 * sizeof(int16_t));
-                       }
-                   }
-               }
-           }
-           av_free(filterCopy);
+        int16_t *filterCopy = NULL;
+        if (filterSize > 4) {
+            if (!FF_ALLOC_TYPED_ARRAY(filterCopy, dstW * filterSize))
+                return AVERROR(ENOMEM);
+            memcpy(filterCopy, filter, dstW * filterSize * sizeof(int16_t));
+        }
+        // The 8-bit input variant gathers the source pixels out of order.
+        // Do not swap filterPos for pixels which won't be processed by
+        // the main loop.
+        if (c->srcBpc == 8) {
+            for (i = 0; i + 8 <= dstW; i += 8) {
+                FFSWAP(int, filterPos[i + 2], filterPos[i + 4]);
+                FFSWAP(int, filterPos[i + 3], filterPos[i + 5]);
+            }
         }
+        if (filterSize > 4) {
+            // 16 pixels are processed at a time.
+            for (i = 0; i + 16 <= dstW; i += 16) {
+                // 4 filter coeffs are processed at a time.
+                for (k = 0; k + 4 <= filterSize; k += 4) {
+                    for (j = 0; j < 16; ++j) {
+                        int from = (i + j) * filterSize + k;
+                        int to = i * filterSize + j * 4 + k * 16;
+                        memcpy(&filter[to], &filterCopy[from], 4 * sizeof(int16_t));
+                    }
+                }
+            }
+        }
+        av_free(filterCopy);
     }
 #endif
     return 0;
@@ -383,12 +384,12 @@ static const ScaleAlgorithm scale_algorithms[] = {
     { SWS_X,             "experimental",                    8 },
 };
 
-static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
-                              int *outFilterSize, int xInc, int srcW,
-                              int dstW, int filterAlign, int one,
-                              int flags, int cpu_flags,
-                              SwsVector *srcFilter, SwsVector *dstFilter,
-                              double param[2], int srcPos, int dstPos)
+static av_cold int build_filter(int16_t **outFilter, int32_t **filterPos,
+                                int *outFilterSize, int xInc, int srcW,
+                                int dstW, int filterAlign, int one,
+                                int flags, int cpu_flags,
+                                SwsVector *srcFilter, SwsVector *dstFilter,
+                                double param[2], int srcPos, int dstPos)
 {
     int i;
     int filterSize;
@@ -783,6 +784,143 @@ done:
     return ret;
 }
 
+/**
+ * Process wide cache of the filters computed by build_filter(), so that
+ * creating many contexts with the same geometry does not recompute them.
+ * Filters using custom SwsVectors are not cached.
+ */
+#define FILTER_CACHE_SIZE 32
+
+typedef struct FilterCacheKey {
+    int xInc, srcW, dstW, filterAlign, one, flags, cpu_flags;
+    int srcPos, dstPos;
+    double param[2];
+} FilterCacheKey;
+
+typedef struct FilterCacheEntry {
+    FilterCacheKey key;
+    int ret;            ///< 0 or RETCODE_USE_CASCADE
+    int16_t *filter;
+    int32_t *filterPos;
+    int filterSize;
+    uint64_t last_use;
+} FilterCacheEntry;
+
+static AVMutex filter_cache_mutex = AV_MUTEX_INITIALIZER;
+static FilterCacheEntry filter_cache[FILTER_CACHE_SIZE];
+static uint64_t filter_cache_clock;
+
+static int filter_cache_get(const FilterCacheKey *key, int16_t **outFilter,
+                            int32_t **filterPos, int *outFilterSize)
+{
+    int ret = AVERROR(ENOENT);
+
+    ff_mutex_lock(&filter_cache_mutex);
+    for (int i = 0; i < FILTER_CACHE_SIZE; i++) {
+        FilterCacheEntry *e = &filter_cache[i];
+
+        if (!e->last_use || memcmp(&e->key, key, sizeof(*key)))
+            continue;
+
+        e->last_use = ++filter_cache_clock;
+        ret = e->ret;
+        if (ret < 0)
+            break;
+
+        *filterPos = av_memdup(e->filterPos, sizeof(**filterPos) * (key->dstW + 3));
+        *outFilter = av_memdup(e->filter, sizeof(**outFilter) * e->filterSize * (key->dstW + 3));
+        if (!*filterPos || !*outFilter) {
+            av_freep(filterPos);
+            av_freep(outFilter);
+            ret = AVERROR(ENOMEM);
+            break;
+        }
+        *outFilterSize = e->filterSize;
+        break;
+    }
+    ff_mutex_unlock(&filter_cache_mutex);
+
+    return ret;
+}
+
+static void filter_cache_add(const FilterCacheKey *key, int ret,
+                             const int16_t *filter, const int32_t *filterPos,
+                             int filterSize)
+{
+    FilterCacheEntry *e = &filter_cache[0];
+    int16_t *f = NULL;
+    int32_t *pos = NULL;
+
+    if (!ret) {
+        pos = av_memdup(filterPos, sizeof(*filterPos) * (key->dstW + 3));
+        f   = av_memdup(filter, sizeof(*filter) * filterSize * (key->dstW + 3));
+        if (!pos || !f) {
+            av_free(pos);
+            av_free(f);
+            return;
+        }
+    }
+
+    ff_mutex_lock(&filter_cache_mutex);
+    /* replace the least recently used entry */
+    for (int i = 1; i < FILTER_CACHE_SIZE && e->last_use; i++)
+        if (filter_cache[i].last_use < e->last_use)
+            e = &filter_cache[i];
+
+    av_free(e->filter);
+    av_free(e->filterPos);
+    e->key        = *key;
+    e->ret        = ret;
+    e->filter     = f;
+    e->filterPos  = pos;
+    e->filterSize = filterSize;
+    e->last_use   = ++filter_cache_clock;
+    ff_mutex_unlock(&filter_cache_mutex);
+}
+
+static av_cold int initFilter(int16_t **outFilter, int32_t **filterPos,
+                              int *outFilterSize, int xInc, int srcW,
+                              int dstW, int filterAlign, int one,
+                              int flags, int cpu_flags,
+                              SwsVector *srcFilter, SwsVector *dstFilter,
+                              double param[2], int srcPos, int dstPos)
+{
+    FilterCacheKey key;
+    int ret;
+
+    if (srcFilter || dstFilter)
+        return build_filter(outFilter, filterPos, outFilterSize, xInc, srcW,
+                            dstW, filterAlign, one, flags, cpu_flags,
+                            srcFilter, dstFilter, param, srcPos, dstPos);
+
+    /* clear the padding too, the keys are compared with memcmp() */
+    memset(&key, 0, sizeof(key));
+    key.xInc        = xInc;
+    key.srcW        = srcW;
+    key.dstW        = dstW;
+    key.filterAlign = filterAlign;
+    key.one         = one;
+    key.flags       = flags;
+    key.cpu_flags   = cpu_flags;
+    key.srcPos      = srcPos;
+    key.dstPos      = dstPos;
+    key.param[0]    = param[0];
+    key.param[1]    = param[1];
+
+    ret = filter_cache_get(&key, outFilter, filterPos, outFilterSize);
+    if (ret != AVERROR(ENOENT))
+        return ret;
+
+    ret = build_filter(outFilter, filterPos, outFilterSize, xInc, srcW,
+                       dstW, filterAlign, one, flags, cpu_flags,
+                       NULL, NULL, param, srcPos, dstPos);
+    if (!ret)
+        filter_cache_add(&key, 0, *outFilter, *filterPos, *outFilterSize);
+    else if (ret == RETCODE_USE_CASCADE)
+        filter_cache_add(&key, ret, NULL, NULL, 0);
+    return ret;
+}
+
 static void fill_rgb2yuv_table(SwsContext *c, const int table[4], int dstRange)
 {
     int64_t W, V, Z, Cy, Cu, Cv;
@@ -977,6 +1115,22 @@ int sws_setColorspaceDetails(struct SwsContext *c, const int inv_table[4],
     c->dstFormatBpp = av_get_bits_per_pixel(desc_dst);
     c->srcFormatBpp = av_get_bits_per_pixel(desc_src);
 
+    if (c->cascaded_context[2]) {
+        /* gamma cascade, the last step converts to the destination format */
+        int ret = sws_setColorspaceDetails(c->cascaded_context[2], inv_table, srcRange,
+                                           table, dstRange, 0, 1 << 16, 1 << 16);
+        if (ret < 0)
+            return ret;
+    }
+
+    if (c->cascaded_context[1] && c->cascaded_context[1]->is_internal_gamma &&
+        !c->cascaded_context[0]) {
+        /* gamma cascade with direct linearization of the source, the
+         * tables only depend on the source format and the values above */
+        int ret = need_reinit ? ff_sws_init_linearize(c) : 0;
+        return ret < 0 ? ret : 0;
+    }
+
     if (c->cascaded_context[c->cascaded_mainindex])
         return sws_setColorspaceDetails(c->cascaded_context[c->cascaded_mainindex],inv_table, srcRange,table, dstRange, brightness,  contrast, saturation);
 
@@ -1292,6 +1446,7 @@ static int context_init_threaded(SwsContext *c,
             return ret;
 
         c->nb_slice_ctx++;
+        c->color_convert = c->slice_ctx[i]->color_convert;
 
         if (c->slice_ctx[i]->dither == SWS_DITHER_ED) {
             av_log(c, AV_LOG_VERBOSE,
@@ -1327,6 +1482,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     const AVPixFmtDescriptor *desc_dst;
     int ret = 0;
     enum AVPixelFormat tmpFmt;
+    int lin_direct;
     static const float float_mult = 1.0f / 255.0f;
     static AVOnce rgb2rgb_once = AV_ONCE_INIT;
 
@@ -1630,7 +1786,10 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     tmpFmt = AV_PIX_FMT_RGBA64LE;
 
 
-    if (!unscaled && c->gamma_flag && (srcFormat != tmpFmt || dstFormat != tmpFmt)) {
+    c->color_convert = ff_sws_color_needed(c);
+
+    if (c->color_convert ||
+        !unscaled && c->gamma_flag && (srcFormat != tmpFmt || dstFormat != tmpFmt)) {
         SwsContext *c2;
         c->cascaded_context[0] = NULL;
 
@@ -1639,36 +1798,54 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
         if (ret < 0)
             return ret;
 
-        c->cascaded_context[0] = sws_getContext(srcW, srcH, srcFormat,
-                                                srcW, srcH, tmpFmt,
-                                                flags, NULL, NULL, c->param);
-        if (!c->cascaded_context[0]) {
-            return AVERROR(ENOMEM);
+        /* common formats are linearized directly by the first step,
+         * without going through a generic conversion context */
+        lin_direct = 0;
+        if (!c->color_convert && srcFormat != tmpFmt) {
+            lin_direct = ff_sws_init_linearize(c);
+            if (lin_direct < 0)
+                return lin_direct;
         }
 
-        c->cascaded_context[1] = sws_getContext(srcW, srcH, tmpFmt,
-                                                dstW, dstH, tmpFmt,
-                                                flags, srcFilter, dstFilter, c->param);
+        if (!lin_direct) {
+            c->cascaded_context[0] = sws_alloc_set_opts(srcW, srcH, srcFormat,
+                                                        srcW, srcH, tmpFmt,
+                                                        flags, c->param);
+            if (!c->cascaded_context[0])
+                return AVERROR(ENOMEM);
+            c->cascaded_context[0]->srcRange = c->srcRange;
+            ret = sws_init_context(c->cascaded_context[0], NULL, NULL);
+            if (ret < 0)
+                return ret;
+        }
 
-        if (!c->cascaded_context[1])
+        c->cascaded_context[1] = c2 = sws_alloc_set_opts(srcW, srcH, tmpFmt,
+                                                         dstW, dstH, tmpFmt,
+                                                         flags, c->param);
+        if (!c2)
             return AVERROR(ENOMEM);
 
-        c2 = c->cascaded_context[1];
+        // the tables must be set before initializing the context, so that
+        // ff_init_filters() creates the conversion FilterDescriptors
         c2->is_internal_gamma = 1;
-        c2->gamma     = alloc_gamma_tbl(    c->gamma_value);
-        c2->inv_gamma = alloc_gamma_tbl(1.f/c->gamma_value);
-        if (!c2->gamma || !c2->inv_gamma)
-            return AVERROR(ENOMEM);
-
-        // is_internal_flag is set after creating the context
-        // to properly create the gamma convert FilterDescriptor
-        // we have to re-initialize it
-        ff_free_filters(c2);
-        if ((ret = ff_init_filters(c2)) < 0) {
-            sws_freeContext(c2);
-            c->cascaded_context[1] = NULL;
-            return ret;
+        if (c->color_convert) {
+            ret = ff_sws_init_color(c, c2);
+            if (ret < 0)
+                return ret;
+        } else {
+            /* inv_gamma linearizes the input of c2, gamma encodes its output */
+            c2->gamma = alloc_gamma_tbl(1.f/c->gamma_value);
+            if (!c2->gamma)
+                return AVERROR(ENOMEM);
+            if (!lin_direct) {
+                c2->inv_gamma = alloc_gamma_tbl(c->gamma_value);
+                if (!c2->inv_gamma)
+                    return AVERROR(ENOMEM);
+            }
         }
+        ret = sws_init_context(c2, srcFilter, dstFilter);
+        if (ret < 0)
+            return ret;
 
         c->cascaded_context[2] = NULL;
         if (dstFormat != tmpFmt) {
@@ -1677,11 +1854,15 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
             if (ret < 0)
                 return ret;
 
-            c->cascaded_context[2] = sws_getContext(dstW, dstH, tmpFmt,
-                                                dstW, dstH, dstFormat,
-                                                flags, NULL, NULL, c->param);
+            c->cascaded_context[2] = sws_alloc_set_opts(dstW, dstH, tmpFmt,
+                                                        dstW, dstH, dstFormat,
+                                                        flags, c->param);
             if (!c->cascaded_context[2])
                 return AVERROR(ENOMEM);
+            c->cascaded_context[2]->dstRange = c->dstRange;
+            ret = sws_init_context(c->cascaded_context[2], NULL, NULL);
+            if (ret < 0)
+                return ret;
         }
         return 0;
     }
@@ -1989,7 +2170,7 @@ av_cold int sws_init_context(SwsContext *c, SwsFilter *srcFilter,
     }
 
     /* unscaled special cases */
-    if (unscaled && !usesHFilter && !usesVFilter &&
+    if (unscaled && !usesHFilter && !usesVFilter && !c->is_internal_gamma &&
         (c->srcRange == c->dstRange || isAnyRGB(dstFormat) ||
          isFloat(srcFormat) || isFloat(dstFormat))){
         ff_get_unscaled_swscale(c);
@@ -2463,6 +2644,9 @@ void sws_freeContext(SwsContext *c)
 
     av_freep(&c->gamma);
     av_freep(&c->inv_gamma);
+    av_freep(&c->lin_lut);
+    av_freep(&c->lin_yuv);
+    av_freep(&c->lin_table);
 
     av_freep(&c->rgb0_scratch);
     av_freep(&c->xyz_scratch);
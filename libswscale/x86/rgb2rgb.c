@@ -158,6 +158,21 @@ void ff_uyvytoyuv422_sse2(uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
 void ff_uyvytoyuv422_avx(uint8_t *ydst, uint8_t *udst, uint8_t *vdst,
                          const uint8_t *src, int width, int height,
                          int lumStride, int chromStride, int srcStride);
+
+#define WORDS_FUNCS(opt)                                                              \
+void ff_shift_words_ ## opt(const uint8_t *src, uint8_t *dst,                         \
+                            int width, int height, int srcStride,                     \
+                            int dstStride, int shift);                                \
+void ff_interleave_words_ ## opt(const uint8_t *src1, const uint8_t *src2,            \
+                                 uint8_t *dst, int width, int height,                 \
+                                 int src1Stride, int src2Stride, int dstStride,       \
+                                 int shift);                                          \
+void ff_deinterleave_words_ ## opt(const uint8_t *src, uint8_t *dst1, uint8_t *dst2,  \
+                                   int width, int height, int srcStride,              \
+                                   int dst1Stride, int dst2Stride, int shift)
+
+WORDS_FUNCS(sse2);
+WORDS_FUNCS(avx2);
 #endif
 
 av_cold void rgb2rgb_init_x86(void)
@@ -182,7 +197,10 @@ av_cold void rgb2rgb_init_x86(void)
     }
     if (EXTERNAL_SSE2(cpu_flags)) {
 #if ARCH_X86_64
-        uyvytoyuv422 = ff_uyvytoyuv422_sse2;
+        uyvytoyuv422      = ff_uyvytoyuv422_sse2;
+        shiftWords        = ff_shift_words_sse2;
+        interleaveWords   = ff_interleave_words_sse2;
+        deinterleaveWords = ff_deinterleave_words_sse2;
 #endif
     }
     if (EXTERNAL_SSSE3(cpu_flags)) {
@@ -199,6 +217,9 @@ av_cold void rgb2rgb_init_x86(void)
         shuffle_bytes_1230 = ff_shuffle_bytes_1230_avx2;
         shuffle_bytes_3012 = ff_shuffle_bytes_3012_avx2;
         shuffle_bytes_3210 = ff_shuffle_bytes_3210_avx2;
+        shiftWords         = ff_shift_words_avx2;
+        interleaveWords    = ff_interleave_words_avx2;
+        deinterleaveWords  = ff_deinterleave_words_avx2;
     }
     if (EXTERNAL_AVX(cpu_flags)) {
         uyvytoyuv422 = ff_uyvytoyuv422_avx;
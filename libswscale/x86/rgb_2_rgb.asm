@@ -309,3 +309,225 @@ UYVY_TO_YUV422
 INIT_XMM avx
 UYVY_TO_YUV422
 %endif
+
+; Set up m6/m7 with the left/right shift count from a signed shift amount,
+; positive to shift left, negative to shift right.
+%macro LOAD_SHIFT 1
+    pxor          m6, m6
+    pxor          m7, m7
+    test        %1d, %1d
+    jl .shift_right
+    movd         xm6, %1d
+    jmp .shift_done
+.shift_right:
+    neg         %1d
+    movd         xm7, %1d
+.shift_done:
+%endmacro
+
+%macro PSHIFTW 1-*
+%rep %0
+    psllw         %1, xm6
+    psrlw         %1, xm7
+%rotate 1
+%endrep
+%endmacro
+
+;-----------------------------------------------------------------------------------------------
+; shift_words(const uint8_t *src, uint8_t *dst, int width, int height,
+;             int srcStride, int dstStride, int shift)
+;-----------------------------------------------------------------------------------------------
+%macro SHIFT_WORDS 0
+cglobal shift_words, 7, 9, 8, src, dst, w, h, src_stride, dst_stride, shift, x, tmp
+    LOAD_SHIFT shift
+
+    movsxdifnidn          wq, wd
+    movsxdifnidn src_strideq, src_strided
+    movsxdifnidn dst_strideq, dst_strided
+
+    lea         srcq, [srcq + wq * 2]
+    lea         dstq, [dstq + wq * 2]
+    neg           wq
+
+.loop_line:
+    mov           xq, wq
+
+    ; single samples until the remaining width is a multiple of the vector size
+.loop_scalar:
+    test          xq, mmsize / 2 - 1
+    jz .loop_simd_start
+    pinsrw       xm2, word [srcq + xq * 2], 0
+    PSHIFTW      xm2
+    pextrw      tmpd, xm2, 0
+    mov [dstq + xq * 2], tmpw
+    add           xq, 1
+    jmp .loop_scalar
+
+.loop_simd_start:
+    test          xq, xq
+    jz .end_line
+
+.loop_simd:
+    movu          m2, [srcq + xq * 2]
+    PSHIFTW       m2
+    movu [dstq + xq * 2], m2
+    add           xq, mmsize / 2
+    jl .loop_simd
+
+.end_line:
+    add         srcq, src_strideq
+    add         dstq, dst_strideq
+    sub           hd, 1
+    jg .loop_line
+
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------------------------
+; interleave_words(const uint8_t *src1, const uint8_t *src2, uint8_t *dst,
+;                  int width, int height, int src1Stride,
+;                  int src2Stride, int dstStride, int shift)
+;-----------------------------------------------------------------------------------------------
+%macro INTERLEAVE_WORDS 0
+cglobal interleave_words, 9, 10, 8, src1, src2, dst, w, h, src1_stride, src2_stride, dst_stride, shift, x
+    LOAD_SHIFT shift
+
+    movsxdifnidn           wq, wd
+    movsxdifnidn src1_strideq, src1_strided
+    movsxdifnidn src2_strideq, src2_strided
+    movsxdifnidn  dst_strideq, dst_strided
+
+    lea        src1q, [src1q + wq * 2]
+    lea        src2q, [src2q + wq * 2]
+    lea         dstq, [dstq  + wq * 4]
+    neg           wq
+
+.loop_line:
+    mov           xq, wq
+
+.loop_scalar:
+    test          xq, mmsize / 2 - 1
+    jz .loop_simd_start
+    pinsrw       xm2, word [src1q + xq * 2], 0
+    pinsrw       xm2, word [src2q + xq * 2], 1
+    PSHIFTW      xm2
+    movd [dstq + xq * 4], xm2
+    add           xq, 1
+    jmp .loop_scalar
+
+.loop_simd_start:
+    test          xq, xq
+    jz .end_line
+
+.loop_simd:
+    movu          m2, [src1q + xq * 2]
+    movu          m3, [src2q + xq * 2]
+    PSHIFTW       m2, m3
+    punpcklwd     m4, m2, m3
+    punpckhwd     m2, m3
+%if mmsize == 32
+    ; punpck works within 128-bit lanes
+    vperm2i128    m3, m4, m2, 0x20
+    vperm2i128    m2, m4, m2, 0x31
+    movu [dstq + xq * 4], m3
+%else
+    movu [dstq + xq * 4], m4
+%endif
+    movu [dstq + xq * 4 + mmsize], m2
+    add           xq, mmsize / 2
+    jl .loop_simd
+
+.end_line:
+    add        src1q, src1_strideq
+    add        src2q, src2_strideq
+    add         dstq, dst_strideq
+    sub           hd, 1
+    jg .loop_line
+
+    RET
+%endmacro
+
+;-----------------------------------------------------------------------------------------------
+; deinterleave_words(const uint8_t *src, uint8_t *dst1, uint8_t *dst2,
+;                    int width, int height, int srcStride,
+;                    int dst1Stride, int dst2Stride, int shift)
+;-----------------------------------------------------------------------------------------------
+%macro DEINTERLEAVE_WORDS 0
+cglobal deinterleave_words, 9, 11, 8, src, dst1, dst2, w, h, src_stride, dst1_stride, dst2_stride, shift, x, tmp
+    LOAD_SHIFT shift
+
+    movsxdifnidn           wq, wd
+    movsxdifnidn  src_strideq, src_strided
+    movsxdifnidn dst1_strideq, dst1_strided
+    movsxdifnidn dst2_strideq, dst2_strided
+
+    lea         srcq, [srcq  + wq * 4]
+    lea        dst1q, [dst1q + wq * 2]
+    lea        dst2q, [dst2q + wq * 2]
+    neg           wq
+
+.loop_line:
+    mov           xq, wq
+
+.loop_scalar:
+    test          xq, mmsize / 2 - 1
+    jz .loop_simd_start
+    movd         xm2, [srcq + xq * 4]
+    PSHIFTW      xm2
+    pextrw      tmpd, xm2, 0
+    mov [dst1q + xq * 2], tmpw
+    pextrw      tmpd, xm2, 1
+    mov [dst2q + xq * 2], tmpw
+    add           xq, 1
+    jmp .loop_scalar
+
+.loop_simd_start:
+    test          xq, xq
+    jz .end_line
+
+.loop_simd:
+    movu          m2, [srcq + xq * 4]
+    movu          m3, [srcq + xq * 4 + mmsize]
+    PSHIFTW       m2, m3
+    ; sign extend both halves of each dword, packssdw then keeps all bits
+    pslld         m4, m2, 16
+    pslld         m5, m3, 16
+    psrad         m4, 16
+    psrad         m5, 16
+    psrad         m2, 16
+    psrad         m3, 16
+    packssdw      m4, m5
+    packssdw      m2, m3
+%if mmsize == 32
+    ; packssdw works within 128-bit lanes
+    vpermq        m4, m4, q3120
+    vpermq        m2, m2, q3120
+%endif
+    movu [dst1q + xq * 2], m4
+    movu [dst2q + xq * 2], m2
+    add           xq, mmsize / 2
+    jl .loop_simd
+
+.end_line:
+    add         srcq, src_strideq
+    add        dst1q, dst1_strideq
+    add        dst2q, dst2_strideq
+    sub           hd, 1
+    jg .loop_line
+
+    RET
+%endmacro
+
+%if ARCH_X86_64
+INIT_XMM sse2
+SHIFT_WORDS
+INTERLEAVE_WORDS
+DEINTERLEAVE_WORDS
+
+%if HAVE_AVX2_EXTERNAL
+INIT_YMM avx2
+SHIFT_WORDS
+INTERLEAVE_WORDS
+DEINTERLEAVE_WORDS
+%endif
+%endif
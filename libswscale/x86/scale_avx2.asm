@@ -26,37 +26,58 @@ SECTION_RODATA 32
 
 swizzle: dd 0, 4, 1, 5, 2, 6, 3, 7
 four: times 8 dd 4
+minshort: times 16 dw 0x8000
+unicoeff: times 8 dd 0x20000000
+max_19bit_int: times 8 dd 0x7ffff
 
 SECTION .text
 
 ;-----------------------------------------------------------------------------
 ; horizontal line scaling
 ;
-; void hscale8to15_<filterSize>_<opt>
-;                   (SwsContext *c, int16_t *dst,
-;                    int dstW, const uint8_t *src,
+; void hscale<source_width>to<intermediate_nbits>_<filterSize>_<opt>
+;                   (SwsContext *c, int{16,32}_t *dst,
+;                    int dstW, const uint{8,16}_t *src,
 ;                    const int16_t *filter,
 ;                    const int32_t *filterPos, int filterSize);
 ;
-; Scale one horizontal line. Input is 8-bit width Filter is 14 bits. Output is
-; 15 bits (in int16_t). Each output pixel is generated from $filterSize input
-; pixels, the position of the first pixel is given in filterPos[nOutputPixel].
+; Scale one horizontal line. Input is 8-bit width or 16-bit width (9 to 16
+; significant bits). Filter is 14 bits. Output is either 15 bits (in int16_t)
+; or 19 bits (in int32_t). Each output pixel is generated from $filterSize
+; input pixels, the position of the first pixel is given in
+; filterPos[nOutputPixel]. 16 output pixels are processed per iteration, the
+; filter coefficients (and for 8-bit input the filter positions) have to be
+; reordered by ff_shuffle_filter_coefficients() beforehand.
 ;-----------------------------------------------------------------------------
 
-%macro SCALE_FUNC 1
-cglobal hscale8to15_%1, 7, 9, 16, pos0, dst, w, srcmem, filter, fltpos, fltsize, count, inner
+; SCALE_FUNC source_width, intermediate_nbits, filtersize
+%macro SCALE_FUNC 3
+cglobal hscale%1to%2_%3, 7, 9, 16, pos0, dst, w, srcmem, filter, fltpos, fltsize, count, inner
+%if %1 == 8
     pxor m0, m0
+%elif %1 == 16
+    mova m0, [minshort]
+%endif
+%if %2 == 15
     mova m15, [swizzle]
+%endif
     xor countq, countq
     movsxd wq, wd
-%ifidn %1, X4
+%ifidn %3, X4
     mova m14, [four]
     shr fltsized, 2
 %endif
 .loop:
+%if %1 == 8
     movu m1, [fltposq]
     movu m2, [fltposq+32]
-%ifidn %1, X4
+%else
+    movu xm1, [fltposq]
+    movu xm2, [fltposq+16]
+    movu xm3, [fltposq+32]
+    movu xm4, [fltposq+48]
+%endif
+%ifidn %3, X4
     pxor m9, m9
     pxor m10, m10
     pxor m11, m11
@@ -64,6 +85,7 @@ cglobal hscale8to15_%1, 7, 9, 16, pos0, dst, w, srcmem, filter, fltpos, fltsize,
     xor innerq, innerq
 .innerloop:
 %endif
+%if %1 == 8
     vpcmpeqd  m13, m13
     vpgatherdd m3,[srcmemq + m1], m13
     vpcmpeqd  m13, m13
@@ -72,18 +94,44 @@ cglobal hscale8to15_%1, 7, 9, 16, pos0, dst, w, srcmem, filter, fltpos, fltsize,
     vpunpckhbw m6, m3, m0
     vpunpcklbw m7, m4, m0
     vpunpckhbw m8, m4, m0
+%else
+    ; 4 source pixels of 4 destination pixels per gather
+    vpcmpeqd  m13, m13
+    vpgatherdq m5, [srcmemq + xm1*2], m13
+    vpcmpeqd  m13, m13
+    vpgatherdq m6, [srcmemq + xm2*2], m13
+    vpcmpeqd  m13, m13
+    vpgatherdq m7, [srcmemq + xm3*2], m13
+    vpcmpeqd  m13, m13
+    vpgatherdq m8, [srcmemq + xm4*2], m13
+%if %1 == 16
+    ; pmaddwd needs signed adds, so this moves unsigned -> signed, we'll
+    ; add back 0x8000 * sum(coeffs) after the horizontal add
+    psubw m5, m0
+    psubw m6, m0
+    psubw m7, m0
+    psubw m8, m0
+%endif
+%endif
     vpmaddwd m5, m5, [filterq]
     vpmaddwd m6, m6, [filterq + 32]
     vpmaddwd m7, m7, [filterq + 64]
     vpmaddwd m8, m8, [filterq + 96]
     add filterq, 0x80
-%ifidn %1, X4
+%ifidn %3, X4
     paddd m9, m5
     paddd m10, m6
     paddd m11, m7
     paddd m12, m8
+%if %1 == 8
     paddd m1, m14
     paddd m2, m14
+%else
+    paddd xm1, xm14
+    paddd xm2, xm14
+    paddd xm3, xm14
+    paddd xm4, xm14
+%endif
     add innerq, 1
     cmp innerq, fltsizeq
     jl .innerloop
@@ -93,11 +141,24 @@ cglobal hscale8to15_%1, 7, 9, 16, pos0, dst, w, srcmem, filter, fltpos, fltsize,
     vphaddd m5, m5, m6
     vphaddd m6, m7, m8
 %endif
-    vpsrad  m5, 7
-    vpsrad  m6, 7
+%if %1 == 16
+    paddd m5, [unicoeff]
+    paddd m6, [unicoeff]
+%endif
+    vpsrad  m5, 14 + %1 - %2
+    vpsrad  m6, 14 + %1 - %2
+%if %2 == 15
     vpackssdw m5, m5, m6
     vpermd m5, m15, m5
     vmovdqu [dstq + countq * 2], m5
+%else
+    pminsd m5, [max_19bit_int]
+    pminsd m6, [max_19bit_int]
+    vpermq m5, m5, q3120
+    vpermq m6, m6, q3120
+    vmovdqu [dstq + countq * 4], m5
+    vmovdqu [dstq + countq * 4 + 32], m6
+%endif
     add fltposq, 0x40
     add countq, 0x10
     cmp countq, wq
@@ -105,10 +166,25 @@ cglobal hscale8to15_%1, 7, 9, 16, pos0, dst, w, srcmem, filter, fltpos, fltsize,
 REP_RET
 %endmacro
 
+; SCALE_FUNCS source_width, intermediate_nbits
+%macro SCALE_FUNCS 2
+SCALE_FUNC %1, %2, 4
+SCALE_FUNC %1, %2, X4
+%endmacro
+
+%macro SCALE_FUNCS2 1
+SCALE_FUNCS  8, %1
+SCALE_FUNCS  9, %1
+SCALE_FUNCS 10, %1
+SCALE_FUNCS 12, %1
+SCALE_FUNCS 14, %1
+SCALE_FUNCS 16, %1
+%endmacro
+
 %if ARCH_X86_64
 %if HAVE_AVX2_EXTERNAL
 INIT_YMM avx2
-SCALE_FUNC 4
-SCALE_FUNC X4
+SCALE_FUNCS2 15
+SCALE_FUNCS2 19
 %endif
 %endif
@@ -276,8 +276,8 @@ SCALE_FUNCS_SSE(sse2);
 SCALE_FUNCS_SSE(ssse3);
 SCALE_FUNCS_SSE(sse4);
 
-SCALE_FUNC(4, 8, 15, avx2);
-SCALE_FUNC(X4, 8, 15, avx2);
+SCALE_FUNCS(4, avx2);
+SCALE_FUNCS(X4, avx2);
 
 #define VSCALEX_FUNC(size, opt) \
 void ff_yuv2planeX_ ## size ## _ ## opt(const int16_t *filter, int filterSize, \
@@ -295,6 +295,9 @@ VSCALEX_FUNCS(sse2);
 VSCALEX_FUNCS(sse4);
 VSCALEX_FUNC(16, sse4);
 VSCALEX_FUNCS(avx);
+VSCALEX_FUNC(9,  avx2);
+VSCALEX_FUNC(10, avx2);
+VSCALEX_FUNC(16, avx2);
 
 #define VSCALE_FUNC(size, opt) \
 void ff_yuv2plane1_ ## size ## _ ## opt(const int16_t *src, uint8_t *dst, int dstW, \
@@ -684,21 +687,27 @@ switch(c->dstBpc){ \
 #if ARCH_X86_64
 #define ASSIGN_AVX2_SCALE_FUNC(hscalefn, filtersize) \
     switch (filtersize) { \
-    case 4:  hscalefn = ff_hscale8to15_4_avx2; break; \
-    default:  hscalefn = ff_hscale8to15_X4_avx2; break; \
-             break; \
+    case 4:  ASSIGN_SCALE_FUNC2(hscalefn, 4,  avx2, avx2); break; \
+    default: ASSIGN_SCALE_FUNC2(hscalefn, X4, avx2, avx2); break; \
     }
 
     if (EXTERNAL_AVX2_FAST(cpu_flags) && !(cpu_flags & AV_CPU_FLAG_SLOW_GATHER)) {
-        if ((c->srcBpc == 8) && (c->dstBpc <= 14)) {
-            if (c->chrDstW % 16 == 0)
-                ASSIGN_AVX2_SCALE_FUNC(c->hcScale, c->hChrFilterSize);
-            if (c->dstW % 16 == 0)
-                ASSIGN_AVX2_SCALE_FUNC(c->hyScale, c->hLumFilterSize);
-        }
+        if (c->chrDstW % 16 == 0)
+            ASSIGN_AVX2_SCALE_FUNC(c->hcScale, c->hChrFilterSize);
+        if (c->dstW % 16 == 0)
+            ASSIGN_AVX2_SCALE_FUNC(c->hyScale, c->hLumFilterSize);
     }
 
     if (EXTERNAL_AVX2_FAST(cpu_flags)) {
+        /* these write 16 pixels per iteration */
+        if (c->dstW % 16 == 0 && c->chrDstW % 16 == 0) {
+            switch (c->dstBpc) {
+            case 16: if (!isBE(c->dstFormat)) c->yuv2planeX = ff_yuv2planeX_16_avx2; break;
+            case 10: if (!isBE(c->dstFormat) && !isSemiPlanarYUV(c->dstFormat)) c->yuv2planeX = ff_yuv2planeX_10_avx2; break;
+            case 9:  if (!isBE(c->dstFormat)) c->yuv2planeX = ff_yuv2planeX_9_avx2;  break;
+            }
+        }
+
         switch (c->dstFormat) {
         case AV_PIX_FMT_NV12:
         case AV_PIX_FMT_NV24:
@@ -0,0 +1,142 @@
+/*
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/**
+ * Shared thread pool API test
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/avassert.h"
+#include "libavutil/executor.h"
+#include "libavutil/mem.h"
+#include "libavutil/thread.h" // not public
+
+#define MAX_JOBS    64
+#define MAX_THREADS 64
+
+struct batch_data {
+    int max_threads;
+    atomic_int runs[MAX_JOBS];
+    atomic_int busy[MAX_THREADS];
+};
+
+struct submitter_data {
+    int id;
+    pthread_t tid;
+    int nb_batches;
+    AVExecutor *pool;
+};
+
+static int job(void *arg, int jobnr, int threadnr)
+{
+    struct batch_data *b = arg;
+
+    av_assert0(!b->max_threads || threadnr < b->max_threads);
+    av_assert0(threadnr < MAX_THREADS);
+    /* no two threads may work on the same batch with the same threadnr */
+    av_assert0(!atomic_exchange(&b->busy[threadnr], 1));
+    atomic_fetch_add(&b->runs[jobnr], 1);
+    atomic_store(&b->busy[threadnr], 0);
+    return jobnr * 3 + 1;
+}
+
+static void *submitter_thread(void *arg)
+{
+    struct submitter_data *sd = arg;
+
+    for (int i = 0; i < sd->nb_batches; i++) {
+        struct batch_data b = { .max_threads = (sd->id + i) % 4 };
+        int rets[MAX_JOBS];
+        int nb_jobs = 1 + (sd->id * 7 + i * 13) % MAX_JOBS;
+
+        for (int j = 0; j < MAX_JOBS; j++)
+            atomic_init(&b.runs[j], 0);
+        for (int j = 0; j < MAX_THREADS; j++)
+            atomic_init(&b.busy[j], 0);
+
+        av_executor_execute(sd->pool, job, &b, rets, nb_jobs, b.max_threads);
+
+        for (int j = 0; j < MAX_JOBS; j++) {
+            int expected = j < nb_jobs;
+            if (atomic_load(&b.runs[j]) != expected) {
+                fprintf(stderr, "submitter %d, batch %d: job %d ran %d times\n",
+                        sd->id, i, j, atomic_load(&b.runs[j]));
+                abort();
+            }
+            if (expected && rets[j] != j * 3 + 1) {
+                fprintf(stderr, "submitter %d, batch %d: job %d returned %d\n",
+                        sd->id, i, j, rets[j]);
+                abort();
+            }
+        }
+    }
+    return NULL;
+}
+
+int main(int ac, char **av)
+{
+    AVExecutor *pool;
+    struct submitter_data *submitters;
+    int ret, nb_threads, nb_submitters, nb_batches;
+
+    if (ac != 4) {
+        fprintf(stderr, "%s <nb_threads> <nb_submitters> <nb_batches>\n", av[0]);
+        return 1;
+    }
+
+    nb_threads    = atoi(av[1]);
+    nb_submitters = atoi(av[2]);
+    nb_batches    = atoi(av[3]);
+
+    ret = av_executor_alloc(&pool, nb_threads);
+    if (ret < 0)
+        return 1;
+    av_assert0(av_executor_get_nb_threads(pool) == nb_threads);
+
+    submitters = av_calloc(nb_submitters, sizeof(*submitters));
+    if (!submitters) {
+        av_executor_free(&pool);
+        return 1;
+    }
+
+    for (int i = 0; i < nb_submitters; i++) {
+        struct submitter_data *sd = &submitters[i];
+
+        sd->id         = i;
+        sd->nb_batches = nb_batches;
+        sd->pool       = pool;
+        ret = pthread_create(&sd->tid, NULL, submitter_thread, sd);
+        if (ret) {
+            fprintf(stderr, "Unable to start submitter thread: %s\n", strerror(ret));
+            abort();
+        }
+    }
+
+    for (int i = 0; i < nb_submitters; i++)
+        pthread_join(submitters[i].tid, NULL);
+
+    av_free(submitters);
+    av_executor_free(&pool);
+    return 0;
+}
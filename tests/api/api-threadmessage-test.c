@@ -32,12 +32,14 @@ struct sender_data {
     int id;
     pthread_t tid;
     int workload;
+    int batch;
     AVThreadMessageQueue *queue;
 };
 
 /* same as sender_data but shuffled for testing purpose */
 struct receiver_data {
     pthread_t tid;
+    int batch;
     int workload;
     int id;
     AVThreadMessageQueue *queue;
@@ -52,6 +54,8 @@ struct message {
 
 #define MAGIC 0xdeadc0de
 
+#define MAX_BATCH 8
+
 static void free_frame(void *arg)
 {
     struct message *msg = arg;
@@ -59,10 +63,29 @@ static void free_frame(void *arg)
     av_frame_free(&msg->frame);
 }
 
+/* send a batch of messages, freeing the ones that could not be sent */
+static int send_batch(AVThreadMessageQueue *queue, struct message *msgs, int nb_msgs)
+{
+    int sent = 0, ret = 0;
+
+    while (sent < nb_msgs) {
+        ret = av_thread_message_queue_send_multi(queue, msgs + sent, nb_msgs - sent, 0);
+        if (ret < 0)
+            break;
+        sent += ret;
+    }
+    for (; sent < nb_msgs; sent++)
+        av_frame_free(&msgs[sent].frame);
+
+    return FFMIN(ret, 0);
+}
+
 static void *sender_thread(void *arg)
 {
     int i, ret = 0;
     struct sender_data *wd = arg;
+    struct message pending[MAX_BATCH];
+    int nb_pending = 0;
 
     av_log(NULL, AV_LOG_INFO, "sender #%d: workload=%d\n", wd->id, wd->workload);
     for (i = 0; i < wd->workload; i++) {
@@ -110,6 +133,16 @@ static void *sender_thread(void *arg)
             /* push the frame in the common queue */
             av_log(NULL, AV_LOG_INFO, "sender #%d: sending my work (%d/%d frame:%p)\n",
                    wd->id, i + 1, wd->workload, msg.frame);
+            if (wd->batch > 1) {
+                pending[nb_pending++] = msg;
+                if (nb_pending < wd->batch)
+                    continue;
+                ret = send_batch(wd->queue, pending, nb_pending);
+                nb_pending = 0;
+                if (ret < 0)
+                    break;
+                continue;
+            }
             ret = av_thread_message_queue_send(wd->queue, &msg, 0);
             if (ret < 0) {
                 av_frame_free(&msg.frame);
@@ -117,6 +150,14 @@ static void *sender_thread(void *arg)
             }
         }
     }
+    if (nb_pending) {
+        if (ret < 0) {
+            while (nb_pending)
+                av_frame_free(&pending[--nb_pending].frame);
+        } else {
+            ret = send_batch(wd->queue, pending, nb_pending);
+        }
+    }
     av_log(NULL, AV_LOG_INFO, "sender #%d: my work is done here (%s)\n",
            wd->id, av_err2str(ret));
     av_thread_message_queue_set_err_recv(wd->queue, ret < 0 ? ret : AVERROR_EOF);
@@ -134,6 +175,24 @@ static void *receiver_thread(void *arg)
                    "discarding %d message(s)\n", rd->id,
                    av_thread_message_queue_nb_elems(rd->queue));
             av_thread_message_flush(rd->queue);
+        } else if (rd->batch > 1) {
+            struct message msgs[MAX_BATCH];
+
+            ret = av_thread_message_queue_recv_multi(rd->queue, msgs,
+                                                     FFMIN(rd->batch, rd->workload - i), 0);
+            if (ret < 0)
+                break;
+            for (int j = 0; j < ret; j++) {
+                AVDictionary *meta;
+                AVDictionaryEntry *e;
+
+                av_assert0(msgs[j].magic == MAGIC);
+                meta = msgs[j].frame->metadata;
+                e = av_dict_get(meta, "sig", NULL, 0);
+                av_log(NULL, AV_LOG_INFO, "got \"%s\" (%p)\n", e->value, msgs[j].frame);
+                av_frame_free(&msgs[j].frame);
+            }
+            i += ret - 1;
         } else {
             struct message msg;
             AVDictionary *meta;
@@ -164,17 +223,18 @@ static int get_workload(int minv, int maxv)
 int main(int ac, char **av)
 {
     int i, ret = 0;
-    int max_queue_size;
+    int max_queue_size, batch = 1;
     int nb_senders, sender_min_load, sender_max_load;
     int nb_receivers, receiver_min_load, receiver_max_load;
     struct sender_data *senders;
     struct receiver_data *receivers;
     AVThreadMessageQueue *queue = NULL;
 
-    if (ac != 8) {
+    if (ac != 8 && ac != 9) {
         av_log(NULL, AV_LOG_ERROR, "%s <max_queue_size> "
                "<nb_senders> <sender_min_send> <sender_max_send> "
-               "<nb_receivers> <receiver_min_recv> <receiver_max_recv>\n", av[0]);
+               "<nb_receivers> <receiver_min_recv> <receiver_max_recv> "
+               "[<batch_size>]\n", av[0]);
         return 1;
     }
 
@@ -185,18 +245,27 @@ int main(int ac, char **av)
     nb_receivers      = atoi(av[5]);
     receiver_min_load = atoi(av[6]);
     receiver_max_load = atoi(av[7]);
+    if (ac > 8)
+        batch         = atoi(av[8]);
 
     if (max_queue_size <= 0 ||
         nb_senders <= 0 || sender_min_load <= 0 || sender_max_load <= 0 ||
-        nb_receivers <= 0 || receiver_min_load <= 0 || receiver_max_load <= 0) {
+        nb_receivers <= 0 || receiver_min_load <= 0 || receiver_max_load <= 0 ||
+        batch <= 0) {
         av_log(NULL, AV_LOG_ERROR, "negative values not allowed\n");
         return 1;
     }
+    if (batch > MAX_BATCH) {
+        av_log(NULL, AV_LOG_ERROR, "batch size must be at most %d\n", MAX_BATCH);
+        return 1;
+    }
 
     av_log(NULL, AV_LOG_INFO, "qsize:%d / %d senders sending [%d-%d] / "
            "%d receivers receiving [%d-%d]\n", max_queue_size,
            nb_senders, sender_min_load, sender_max_load,
            nb_receivers, receiver_min_load, receiver_max_load);
+    if (batch > 1)
+        av_log(NULL, AV_LOG_INFO, "sending and receiving up to %d messages at once\n", batch);
 
     senders   = av_calloc(nb_senders,   sizeof(*senders));
     receivers = av_calloc(nb_receivers, sizeof(*receivers));
@@ -218,6 +287,7 @@ int main(int ac, char **av)
         td->id = i;                                                             \
         td->queue = queue;                                                      \
         td->workload = get_workload(type##_min_load, type##_max_load);          \
+        td->batch = batch;                                                      \
                                                                                 \
         ret = pthread_create(&td->tid, NULL, type##_thread, td);                \
         if (ret) {                                                              \
@@ -0,0 +1,182 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <limits.h>
+#include <string.h>
+
+#include "libavfilter/ebur128dsp.h"
+#include "libavutil/mem_internal.h"
+#include "checkasm.h"
+
+#define MAX_CHANNELS 8
+#define NB_SAMPLES   64
+#define EPS          1e-12
+
+#define randomize_buffer(buf, len)                      \
+do {                                                    \
+    for (int i = 0; i < len; i++)                       \
+        buf[i] = (rnd() / (double)UINT_MAX) * 2.0 - 1.0; \
+} while (0)
+
+/* K-weighting coefficients at 48kHz */
+static const EBUR128Biquad filters[2] = {
+    { 1.53512485958697, -2.69169618940638, 1.19839281085285,
+     -1.69065929318241,  0.73248077421585 },
+    { 1.0, -2.0, 1.0, -1.99004745483398, 0.99007225036621 },
+};
+
+static void check_filter_channels(EBUR128DSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(double, samples,    [NB_SAMPLES * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, state_ref,  [6 * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, state_new,  [6 * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, cache_ref,  [2 * NB_SAMPLES * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, cache_new,  [2 * NB_SAMPLES * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, sum_ref,    [2 * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, sum_new,    [2 * MAX_CHANNELS]);
+    static const int channels[] = { 1, 2, 3, 6, 8 };
+
+    declare_func(void, const EBUR128Biquad *filters, double *state,
+                 const double *samples,
+                 double *cache_400, double *cache_3000,
+                 double *sum_400, double *sum_3000,
+                 int nb_channels);
+
+    for (int c = 0; c < FF_ARRAY_ELEMS(channels); c++) {
+        const int nb_channels = channels[c];
+
+        if (check_func(dsp->filter_channels, "filter_channels_%dch", nb_channels)) {
+            randomize_buffer(samples, NB_SAMPLES * nb_channels);
+            randomize_buffer(state_ref, 6 * nb_channels);
+            randomize_buffer(cache_ref, 2 * NB_SAMPLES * nb_channels);
+            randomize_buffer(sum_ref, 2 * nb_channels);
+            memcpy(state_new, state_ref, 6 * nb_channels * sizeof(*state_ref));
+            memcpy(cache_new, cache_ref, 2 * NB_SAMPLES * nb_channels * sizeof(*cache_ref));
+            memcpy(sum_new, sum_ref, 2 * nb_channels * sizeof(*sum_ref));
+
+            for (int n = 0; n < NB_SAMPLES; n++) {
+                const int idx = n * nb_channels;
+
+                call_ref(filters, state_ref, samples + idx,
+                         cache_ref + idx, cache_ref + (NB_SAMPLES + n) * nb_channels,
+                         sum_ref, sum_ref + nb_channels, nb_channels);
+                call_new(filters, state_new, samples + idx,
+                         cache_new + idx, cache_new + (NB_SAMPLES + n) * nb_channels,
+                         sum_new, sum_new + nb_channels, nb_channels);
+            }
+            if (!double_near_abs_eps_array(state_ref, state_new, EPS, 6 * nb_channels) ||
+                !double_near_abs_eps_array(cache_ref, cache_new, EPS, 2 * NB_SAMPLES * nb_channels) ||
+                !double_near_abs_eps_array(sum_ref, sum_new, EPS, 2 * nb_channels))
+                fail();
+
+            bench_new(filters, state_new, samples, cache_new, cache_new + NB_SAMPLES * nb_channels,
+                      sum_new, sum_new + nb_channels, nb_channels);
+        }
+    }
+    report("filter_channels");
+}
+
+static void check_filter(EBUR128DSPContext *dsp)
+{
+    LOCAL_ALIGNED_32(double, src,       [NB_SAMPLES * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, dst_ref,   [NB_SAMPLES * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, dst_new,   [NB_SAMPLES * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, state_ref, [4 * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, state_new, [4 * MAX_CHANNELS]);
+    static const int channels[] = { 1, 2, 3, 6, 8 };
+    double b[5], a[5];
+
+    declare_func(void, const double *b, const double *a, double *state,
+                 double *dst, const double *src,
+                 int nb_samples, int nb_channels);
+
+    /* combined pre-filter and RLB-filter, as set up by the ebur128 library */
+    b[0] = filters[0].b0;
+    b[1] = filters[0].b1 - 2.0 * filters[0].b0;
+    b[2] = filters[0].b2 - 2.0 * filters[0].b1 + filters[0].b0;
+    b[3] = filters[0].b1 - 2.0 * filters[0].b2;
+    b[4] = filters[0].b2;
+    a[0] = 1.0;
+    a[1] = filters[1].a1 + filters[0].a1;
+    a[2] = filters[1].a2 + filters[0].a1 * filters[1].a1 + filters[0].a2;
+    a[3] = filters[0].a1 * filters[1].a2 + filters[0].a2 * filters[1].a1;
+    a[4] = filters[0].a2 * filters[1].a2;
+
+    for (int c = 0; c < FF_ARRAY_ELEMS(channels); c++) {
+        const int nb_channels = channels[c];
+
+        if (check_func(dsp->filter, "filter_%dch", nb_channels)) {
+            randomize_buffer(src, NB_SAMPLES * nb_channels);
+            randomize_buffer(state_ref, 4 * nb_channels);
+            memcpy(state_new, state_ref, 4 * nb_channels * sizeof(*state_ref));
+
+            call_ref(b, a, state_ref, dst_ref, src, NB_SAMPLES, nb_channels);
+            call_new(b, a, state_new, dst_new, src, NB_SAMPLES, nb_channels);
+            if (!double_near_abs_eps_array(dst_ref, dst_new, EPS, NB_SAMPLES * nb_channels) ||
+                !double_near_abs_eps_array(state_ref, state_new, EPS, 4 * nb_channels))
+                fail();
+
+            bench_new(b, a, state_new, dst_new, src, NB_SAMPLES, nb_channels);
+        }
+    }
+    report("filter");
+}
+
+static void check_true_peak(EBUR128DSPContext *dsp, int factor)
+{
+    LOCAL_ALIGNED_32(double, src, [(EBUR128_TRUE_PEAK_TAPS - 1 + NB_SAMPLES) * MAX_CHANNELS]);
+    LOCAL_ALIGNED_32(double, coeffs, [4 * EBUR128_TRUE_PEAK_TAPS]);
+    double peaks_ref[MAX_CHANNELS], peaks_new[MAX_CHANNELS];
+    static const int channels[] = { 1, 2, 6 };
+
+    declare_func(void, double *peaks, const double *coeffs,
+                 const double *src, int nb_samples, int nb_channels);
+
+    ff_ebur128_true_peak_coeffs(coeffs, factor);
+
+    for (int c = 0; c < FF_ARRAY_ELEMS(channels); c++) {
+        const int nb_channels = channels[c];
+
+        if (check_func(factor == 4 ? dsp->true_peak_4x : dsp->true_peak_2x,
+                       "true_peak_%dx_%dch", factor, nb_channels)) {
+            randomize_buffer(src, (EBUR128_TRUE_PEAK_TAPS - 1 + NB_SAMPLES) * nb_channels);
+            for (int ch = 0; ch < nb_channels; ch++)
+                peaks_ref[ch] = peaks_new[ch] = (rnd() & 1) ? 0.0 : 1.5;
+
+            call_ref(peaks_ref, coeffs, src, NB_SAMPLES, nb_channels);
+            call_new(peaks_new, coeffs, src, NB_SAMPLES, nb_channels);
+            if (!double_near_abs_eps_array(peaks_ref, peaks_new, EPS, nb_channels))
+                fail();
+
+            bench_new(peaks_new, coeffs, src, NB_SAMPLES, nb_channels);
+        }
+    }
+    report("true_peak_%dx", factor);
+}
+
+void checkasm_check_ebur128(void)
+{
+    EBUR128DSPContext dsp;
+
+    ff_ebur128_dsp_init(&dsp);
+
+    check_filter_channels(&dsp);
+    check_filter(&dsp);
+    check_true_peak(&dsp, 4);
+    check_true_peak(&dsp, 2);
+}
@@ -167,6 +167,9 @@ static const struct {
     #if CONFIG_COLORSPACE_FILTER
         { "vf_colorspace", checkasm_check_colorspace },
     #endif
+    #if CONFIG_EBUR128_FILTER
+        { "af_ebur128", checkasm_check_ebur128 },
+    #endif
     #if CONFIG_EQ_FILTER
         { "vf_eq", checkasm_check_vf_eq },
     #endif
@@ -179,6 +182,9 @@ static const struct {
     #if CONFIG_NLMEANS_FILTER
         { "vf_nlmeans", checkasm_check_nlmeans },
     #endif
+    #if CONFIG_PALETTEUSE_FILTER
+        { "vf_paletteuse", checkasm_check_vf_paletteuse },
+    #endif
     #if CONFIG_THRESHOLD_FILTER
         { "vf_threshold", checkasm_check_vf_threshold },
     #endif
@@ -188,6 +194,10 @@ static const struct {
     { "sw_rgb", checkasm_check_sw_rgb },
     { "sw_scale", checkasm_check_sw_scale },
 #endif
+#if CONFIG_SWRESAMPLE
+    { "sw_rematrix", checkasm_check_sw_rematrix },
+    { "sw_resample", checkasm_check_sw_resample },
+#endif
 #if CONFIG_AVUTIL
         { "fixed_dsp", checkasm_check_fixed_dsp },
         { "float_dsp", checkasm_check_float_dsp },
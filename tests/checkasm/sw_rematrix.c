@@ -0,0 +1,101 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <float.h>
+#include <string.h>
+
+#include "libavutil/channel_layout.h"
+#include "libavutil/common.h"
+#include "libavutil/mem_internal.h"
+
+#include "libswresample/swresample.h"
+#include "libswresample/swresample_internal.h"
+
+#include "checkasm.h"
+
+#define LEN 256
+
+static void randomize_buffer(float *buf, int len)
+{
+    for (int i = 0; i < len; i++)
+        buf[i] = ((int)(rnd() % 2001) - 1000) / 1000.0f;
+}
+
+static void check_mix_float(void)
+{
+    LOCAL_ALIGNED_64(float, in1,  [LEN]);
+    LOCAL_ALIGNED_64(float, in2,  [LEN]);
+    LOCAL_ALIGNED_64(float, dst0, [LEN]);
+    LOCAL_ALIGNED_64(float, dst1, [LEN]);
+    AVChannelLayout in_layout  = (AVChannelLayout)AV_CHANNEL_LAYOUT_STEREO;
+    AVChannelLayout out_layout = (AVChannelLayout)AV_CHANNEL_LAYOUT_MONO;
+    double matrix[2];
+    SwrContext *s = NULL;
+    mix_1_1_func_type *mix_1_1;
+    mix_2_1_func_type *mix_2_1;
+    void *coeffs;
+
+    /* stereo to mono with an arbitrary matrix, which uses both kernels */
+    matrix[0] = ((int)(rnd() % 2001) - 1000) / 1000.0;
+    matrix[1] = ((int)(rnd() % 2001) - 1000) / 1000.0;
+    if (swr_alloc_set_opts2(&s, &out_layout, AV_SAMPLE_FMT_FLTP, 48000,
+                            &in_layout, AV_SAMPLE_FMT_FLTP, 48000, 0, NULL) < 0 ||
+        swr_set_matrix(s, matrix, 2) < 0 || swr_init(s) < 0) {
+        fprintf(stderr, "rematrix: failed to set up the context\n");
+        fail();
+        swr_free(&s);
+        return;
+    }
+
+    mix_1_1 = s->mix_1_1_simd ? s->mix_1_1_simd : s->mix_1_1_f;
+    mix_2_1 = s->mix_2_1_simd ? s->mix_2_1_simd : s->mix_2_1_f;
+    coeffs  = s->mix_1_1_simd ? s->native_simd_matrix : s->native_matrix;
+
+    randomize_buffer(in1, LEN);
+    randomize_buffer(in2, LEN);
+
+    if (check_func(mix_1_1, "mix_1_1_float")) {
+        declare_func(void, void *out, const void *in, void *coeffp,
+                     integer index, integer len);
+
+        call_ref(dst0, in1, coeffs, 1, LEN);
+        call_new(dst1, in1, coeffs, 1, LEN);
+        if (!float_near_abs_eps_array(dst0, dst1, FLT_EPSILON, LEN))
+            fail();
+        bench_new(dst1, in1, coeffs, 1, LEN);
+    }
+
+    if (check_func(mix_2_1, "mix_2_1_float")) {
+        declare_func(void, void *out, const void *in1, const void *in2,
+                     void *coeffp, integer index1, integer index2, integer len);
+
+        call_ref(dst0, in1, in2, coeffs, 0, 1, LEN);
+        call_new(dst1, in1, in2, coeffs, 0, 1, LEN);
+        if (!float_near_abs_eps_array(dst0, dst1, 2 * FLT_EPSILON, LEN))
+            fail();
+        bench_new(dst1, in1, in2, coeffs, 0, 1, LEN);
+    }
+
+    swr_free(&s);
+}
+
+void checkasm_check_sw_rematrix(void)
+{
+    check_mix_float();
+    report("mix_float");
+}
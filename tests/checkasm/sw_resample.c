@@ -0,0 +1,142 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/mathematics.h"
+#include "libavutil/mem_internal.h"
+
+#include "libswresample/resample.h"
+
+#include "checkasm.h"
+
+#define PHASE_COUNT  32
+// not a multiple of any vector size, so that the tail handling is tested
+#define FILTER_LEN   34
+#define FILTER_ALLOC FFALIGN(FILTER_LEN, 16)
+#define DST_LEN      256
+#define SRC_LEN      (DST_LEN * 2 + FILTER_ALLOC)
+
+static void init_context(ResampleContext *c, enum AVSampleFormat format,
+                         uint8_t *filter_bank, uint8_t *src)
+{
+    int bps = av_get_bytes_per_sample(format);
+    int i, j;
+
+    memset(c, 0, sizeof(*c));
+    c->format        = format;
+    c->felem_size    = bps;
+    c->filter_shift  = format == AV_SAMPLE_FMT_S16P ? 15 : 0;
+    c->filter_bank   = filter_bank;
+    c->filter_length = FILTER_LEN;
+    c->filter_alloc  = FILTER_ALLOC;
+    c->phase_count   = PHASE_COUNT;
+
+    /* 48000 -> 44100, set up the same way as resample_init() */
+    av_reduce(&c->src_incr, &c->dst_incr, 44100, 48000LL * PHASE_COUNT, INT32_MAX / 2);
+    while (c->dst_incr < (1 << 20) && c->src_incr < (1 << 20)) {
+        c->dst_incr *= 2;
+        c->src_incr *= 2;
+    }
+    c->ideal_dst_incr = c->dst_incr;
+    c->dst_incr_div   = c->dst_incr / c->src_incr;
+    c->dst_incr_mod   = c->dst_incr % c->src_incr;
+
+    /* coefficients small enough that no sum can overflow, zero padding */
+    memset(filter_bank, 0, (PHASE_COUNT + 1) * FILTER_ALLOC * bps);
+    for (i = 0; i <= PHASE_COUNT; i++) {
+        for (j = 0; j < FILTER_LEN; j++) {
+            int k = i * FILTER_ALLOC + j;
+            int v = (int)(rnd() % 2001) - 1000;
+            switch (format) {
+            case AV_SAMPLE_FMT_S16P: ((int16_t *)filter_bank)[k] = v * (32767 / FILTER_LEN) / 1000; break;
+            case AV_SAMPLE_FMT_FLTP: ((float   *)filter_bank)[k] = v / (1000.0f * FILTER_LEN);      break;
+            case AV_SAMPLE_FMT_DBLP: ((double  *)filter_bank)[k] = v / (1000.0  * FILTER_LEN);      break;
+            }
+        }
+    }
+
+    for (i = 0; i < SRC_LEN; i++) {
+        int v = (int)(rnd() % 2001) - 1000;
+        switch (format) {
+        case AV_SAMPLE_FMT_S16P: ((int16_t *)src)[i] = (int16_t)rnd(); break;
+        case AV_SAMPLE_FMT_FLTP: ((float   *)src)[i] = v / 1000.0f;     break;
+        case AV_SAMPLE_FMT_DBLP: ((double  *)src)[i] = v / 1000.0;      break;
+        }
+    }
+
+    swri_resample_dsp_init(c);
+}
+
+static void check_resample(enum AVSampleFormat format, const char *name)
+{
+    LOCAL_ALIGNED_32(uint8_t, filter_bank, [(PHASE_COUNT + 1) * FILTER_ALLOC * sizeof(double)]);
+    LOCAL_ALIGNED_32(uint8_t, src,  [SRC_LEN * sizeof(double)]);
+    LOCAL_ALIGNED_32(uint8_t, dst0, [DST_LEN * sizeof(double)]);
+    LOCAL_ALIGNED_32(uint8_t, dst1, [DST_LEN * sizeof(double)]);
+    ResampleContext c, c0, c1;
+    int linear;
+
+    declare_func(int, ResampleContext *c, void *dst, const void *src,
+                 int n, int update_ctx);
+
+    init_context(&c, format, filter_bank, src);
+
+    for (linear = 0; linear < 2; linear++) {
+        void *func = linear ? (void *)c.dsp.resample_linear : (void *)c.dsp.resample_common;
+
+        if (check_func(func, "resample_%s_%s", linear ? "linear" : "common", name)) {
+            int ret0, ret1, ok;
+
+            c0 = c1 = c;
+            c0.index = c1.index = rnd() % PHASE_COUNT;
+            c0.frac  = c1.frac  = rnd() % c.src_incr;
+            memset(dst0, 0, DST_LEN * c.felem_size);
+            memset(dst1, 0, DST_LEN * c.felem_size);
+
+            ret0 = call_ref(&c0, dst0, src, DST_LEN, 1);
+            ret1 = call_new(&c1, dst1, src, DST_LEN, 1);
+
+            switch (format) {
+            case AV_SAMPLE_FMT_FLTP:
+                ok = float_near_abs_eps_array((float *)dst0, (float *)dst1,
+                                              1e-5f, DST_LEN);
+                break;
+            case AV_SAMPLE_FMT_DBLP:
+                ok = double_near_abs_eps_array((double *)dst0, (double *)dst1,
+                                               1e-12, DST_LEN);
+                break;
+            default:
+                ok = !memcmp(dst0, dst1, DST_LEN * c.felem_size);
+            }
+            if (!ok || ret0 != ret1 || c0.index != c1.index || c0.frac != c1.frac)
+                fail();
+
+            bench_new(&c1, dst1, src, DST_LEN, 0);
+        }
+    }
+}
+
+void checkasm_check_sw_resample(void)
+{
+    check_resample(AV_SAMPLE_FMT_S16P, "int16");
+    check_resample(AV_SAMPLE_FMT_FLTP, "float");
+    check_resample(AV_SAMPLE_FMT_DBLP, "double");
+    report("resample");
+}
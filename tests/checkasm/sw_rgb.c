@@ -179,6 +179,123 @@ static void check_interleave_bytes(void)
     }
 }
 
+static const int word_shifts[] = { -6, 0, 6 };
+
+static void check_shift_words(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1, [MAX_STRIDE * MAX_HEIGHT]);
+
+    declare_func(void, const uint8_t *, uint8_t *, int, int, int, int, int);
+
+    randomize_buffers((uint8_t *)src, 2 * MAX_STRIDE * MAX_HEIGHT);
+
+    for (int s = 0; s < FF_ARRAY_ELEMS(word_shifts); s++) {
+        const int shift = word_shifts[s];
+
+        if (check_func(shiftWords, "shift_words_%d", shift)) {
+            for (int i = 0; i <= 17; i++) {
+                // Try all widths [1,17], and try one random width.
+                int w = i > 0 ? i : (1 + (rnd() % (MAX_STRIDE - 2)));
+                int h = 1 + (rnd() % (MAX_HEIGHT - 2));
+
+                memset(dst0, 0, 2 * MAX_STRIDE * MAX_HEIGHT);
+                memset(dst1, 0, 2 * MAX_STRIDE * MAX_HEIGHT);
+
+                call_ref((const uint8_t *)src, (uint8_t *)dst0, w, h,
+                         2 * MAX_STRIDE, 2 * MAX_STRIDE, shift);
+                call_new((const uint8_t *)src, (uint8_t *)dst1, w, h,
+                         2 * MAX_STRIDE, 2 * MAX_STRIDE, shift);
+                checkasm_check(uint16_t, dst0, 2 * MAX_STRIDE, dst1, 2 * MAX_STRIDE,
+                               w + 1, h + 1, "dst");
+            }
+            bench_new((const uint8_t *)src, (uint8_t *)dst1, MAX_STRIDE, MAX_HEIGHT,
+                      2 * MAX_STRIDE, 2 * MAX_STRIDE, shift);
+        }
+    }
+}
+
+static void check_interleave_words(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src0, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, src1, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0, [2 * MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1, [2 * MAX_STRIDE * MAX_HEIGHT]);
+
+    declare_func(void, const uint8_t *, const uint8_t *, uint8_t *,
+                 int, int, int, int, int, int);
+
+    randomize_buffers((uint8_t *)src0, 2 * MAX_STRIDE * MAX_HEIGHT);
+    randomize_buffers((uint8_t *)src1, 2 * MAX_STRIDE * MAX_HEIGHT);
+
+    for (int s = 0; s < FF_ARRAY_ELEMS(word_shifts); s++) {
+        const int shift = word_shifts[s];
+
+        if (check_func(interleaveWords, "interleave_words_%d", shift)) {
+            for (int i = 0; i <= 17; i++) {
+                int w = i > 0 ? i : (1 + (rnd() % (MAX_STRIDE - 2)));
+                int h = 1 + (rnd() % (MAX_HEIGHT - 2));
+
+                memset(dst0, 0, 4 * MAX_STRIDE * MAX_HEIGHT);
+                memset(dst1, 0, 4 * MAX_STRIDE * MAX_HEIGHT);
+
+                call_ref((const uint8_t *)src0, (const uint8_t *)src1, (uint8_t *)dst0,
+                         w, h, 2 * MAX_STRIDE, 2 * MAX_STRIDE, 4 * MAX_STRIDE, shift);
+                call_new((const uint8_t *)src0, (const uint8_t *)src1, (uint8_t *)dst1,
+                         w, h, 2 * MAX_STRIDE, 2 * MAX_STRIDE, 4 * MAX_STRIDE, shift);
+                checkasm_check(uint16_t, dst0, 4 * MAX_STRIDE, dst1, 4 * MAX_STRIDE,
+                               2 * w + 2, h + 1, "dst");
+            }
+            bench_new((const uint8_t *)src0, (const uint8_t *)src1, (uint8_t *)dst1,
+                      MAX_STRIDE, MAX_HEIGHT, 2 * MAX_STRIDE, 2 * MAX_STRIDE,
+                      4 * MAX_STRIDE, shift);
+        }
+    }
+}
+
+static void check_deinterleave_words(void)
+{
+    LOCAL_ALIGNED_32(uint16_t, src, [2 * MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_u, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst0_v, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_u, [MAX_STRIDE * MAX_HEIGHT]);
+    LOCAL_ALIGNED_32(uint16_t, dst1_v, [MAX_STRIDE * MAX_HEIGHT]);
+
+    declare_func(void, const uint8_t *, uint8_t *, uint8_t *,
+                 int, int, int, int, int, int);
+
+    randomize_buffers((uint8_t *)src, 4 * MAX_STRIDE * MAX_HEIGHT);
+
+    for (int s = 0; s < FF_ARRAY_ELEMS(word_shifts); s++) {
+        const int shift = word_shifts[s];
+
+        if (check_func(deinterleaveWords, "deinterleave_words_%d", shift)) {
+            for (int i = 0; i <= 17; i++) {
+                int w = i > 0 ? i : (1 + (rnd() % (MAX_STRIDE - 2)));
+                int h = 1 + (rnd() % (MAX_HEIGHT - 2));
+
+                memset(dst0_u, 0, 2 * MAX_STRIDE * MAX_HEIGHT);
+                memset(dst0_v, 0, 2 * MAX_STRIDE * MAX_HEIGHT);
+                memset(dst1_u, 0, 2 * MAX_STRIDE * MAX_HEIGHT);
+                memset(dst1_v, 0, 2 * MAX_STRIDE * MAX_HEIGHT);
+
+                call_ref((const uint8_t *)src, (uint8_t *)dst0_u, (uint8_t *)dst0_v,
+                         w, h, 4 * MAX_STRIDE, 2 * MAX_STRIDE, 2 * MAX_STRIDE, shift);
+                call_new((const uint8_t *)src, (uint8_t *)dst1_u, (uint8_t *)dst1_v,
+                         w, h, 4 * MAX_STRIDE, 2 * MAX_STRIDE, 2 * MAX_STRIDE, shift);
+                checkasm_check(uint16_t, dst0_u, 2 * MAX_STRIDE, dst1_u, 2 * MAX_STRIDE,
+                               w + 1, h + 1, "dst_u");
+                checkasm_check(uint16_t, dst0_v, 2 * MAX_STRIDE, dst1_v, 2 * MAX_STRIDE,
+                               w + 1, h + 1, "dst_v");
+            }
+            bench_new((const uint8_t *)src, (uint8_t *)dst1_u, (uint8_t *)dst1_v,
+                      MAX_STRIDE, MAX_HEIGHT, 4 * MAX_STRIDE, 2 * MAX_STRIDE,
+                      2 * MAX_STRIDE, shift);
+        }
+    }
+}
+
 void checkasm_check_sw_rgb(void)
 {
     ff_sws_rgb2rgb_init();
@@ -203,4 +320,13 @@ void checkasm_check_sw_rgb(void)
 
     check_interleave_bytes();
     report("interleave_bytes");
+
+    check_shift_words();
+    report("shift_words");
+
+    check_interleave_words();
+    report("interleave_words");
+
+    check_deinterleave_words();
+    report("deinterleave_words");
 }
@@ -133,6 +133,80 @@ static void check_yuv2yuvX(void)
 #undef FILTER_SIZES
 }
 
+static void check_yuv2planeX_hbd(void)
+{
+    struct SwsContext *ctx;
+    int fmi, fsi, i;
+#define HBD_FILTER_SIZES 4
+    static const int filter_sizes[HBD_FILTER_SIZES] = { 2, 4, 8, 16 };
+#define HBD_FORMATS 3
+    static const struct {
+        enum AVPixelFormat format;
+        int bpc;
+    } formats[HBD_FORMATS] = {
+        { AV_PIX_FMT_YUV420P9,   9 },
+        { AV_PIX_FMT_YUV420P10, 10 },
+        { AV_PIX_FMT_YUV420P16, 16 },
+    };
+#define HBD_WIDTH 512
+
+    declare_func_emms(AV_CPU_FLAG_MMX, void, const int16_t *filter,
+                      int filterSize, const int16_t **src, uint8_t *dest,
+                      int dstW, const uint8_t *dither, int offset);
+
+    const int16_t *src[16];
+    // large enough for the 19-bit intermediate of 16-bit output
+    LOCAL_ALIGNED_32(int32_t, src_pixels, [16 * HBD_WIDTH]);
+    LOCAL_ALIGNED_32(int16_t, filter, [16]);
+    LOCAL_ALIGNED_32(uint16_t, dst0, [HBD_WIDTH]);
+    LOCAL_ALIGNED_32(uint16_t, dst1, [HBD_WIDTH]);
+    LOCAL_ALIGNED_8(uint8_t, dither, [8]);
+
+    memset(dither, 0, 8);
+    for (i = 0; i < 16; i++) {
+        src[i] = (const int16_t *)&src_pixels[i * HBD_WIDTH];
+        filter[i] = (rnd() & 0xfff) - 0x800;
+    }
+
+    ctx = sws_alloc_context();
+    if (sws_init_context(ctx, NULL, NULL) < 0)
+        fail();
+
+    for (fmi = 0; fmi < HBD_FORMATS; fmi++) {
+        const int bpc = formats[fmi].bpc;
+
+        if (bpc == 16) {
+            for (i = 0; i < 16 * HBD_WIDTH; i++)
+                src_pixels[i] = rnd() & ((1 << 19) - 1);
+        } else {
+            int16_t *src16 = (int16_t *)src_pixels;
+            for (i = 0; i < 2 * 16 * HBD_WIDTH; i++)
+                src16[i] = rnd() & 0x7fff;
+        }
+
+        ctx->dstFormat = formats[fmi].format;
+        ctx->dstBpc    = bpc;
+        ctx->dstW      = ctx->chrDstW = HBD_WIDTH;
+        ff_sws_init_scale(ctx);
+
+        for (fsi = 0; fsi < HBD_FILTER_SIZES; fsi++) {
+            const int filter_size = filter_sizes[fsi];
+
+            if (check_func(ctx->yuv2planeX, "yuv2planeX_%d_%d", bpc, filter_size)) {
+                memset(dst0, 0, HBD_WIDTH * sizeof(dst0[0]));
+                memset(dst1, 0, HBD_WIDTH * sizeof(dst1[0]));
+
+                call_ref(filter, filter_size, src, (uint8_t *)dst0, HBD_WIDTH, dither, 0);
+                call_new(filter, filter_size, src, (uint8_t *)dst1, HBD_WIDTH, dither, 0);
+                if (memcmp(dst0, dst1, HBD_WIDTH * sizeof(dst0[0])))
+                    fail();
+                bench_new(filter, filter_size, src, (uint8_t *)dst1, HBD_WIDTH, dither, 0);
+            }
+        }
+    }
+    sws_freeContext(ctx);
+}
+
 #undef SRC_PIXELS
 #define SRC_PIXELS 512
 
@@ -142,17 +216,29 @@ static void check_hscale(void)
 #define FILTER_SIZES 6
     static const int filter_sizes[FILTER_SIZES] = { 4, 8, 12, 16, 32, 40 };
 
-#define HSCALE_PAIRS 2
+#define HSCALE_PAIRS 8
     static const int hscale_pairs[HSCALE_PAIRS][2] = {
-        { 8, 14 },
-        { 8, 18 },
+        {  8, 14 },
+        {  8, 18 },
+        { 10, 14 },
+        { 10, 18 },
+        { 12, 14 },
+        { 12, 18 },
+        { 16, 14 },
+        { 16, 18 },
+    };
+    static const enum AVPixelFormat hscale_formats[HSCALE_PAIRS] = {
+        AV_PIX_FMT_YUV420P,   AV_PIX_FMT_YUV420P,
+        AV_PIX_FMT_YUV420P10, AV_PIX_FMT_YUV420P10,
+        AV_PIX_FMT_YUV420P12, AV_PIX_FMT_YUV420P12,
+        AV_PIX_FMT_YUV420P16, AV_PIX_FMT_YUV420P16,
     };
 
     int i, j, fsi, hpi, width;
     struct SwsContext *ctx;
 
-    // padded
-    LOCAL_ALIGNED_32(uint8_t, src, [FFALIGN(SRC_PIXELS + MAX_FILTER_WIDTH - 1, 4)]);
+    // padded, large enough for 16-bit input
+    LOCAL_ALIGNED_32(uint16_t, src, [FFALIGN(SRC_PIXELS + MAX_FILTER_WIDTH - 1, 4)]);
     LOCAL_ALIGNED_32(uint32_t, dst0, [SRC_PIXELS]);
     LOCAL_ALIGNED_32(uint32_t, dst1, [SRC_PIXELS]);
 
@@ -174,14 +260,23 @@ static void check_hscale(void)
     if (sws_init_context(ctx, NULL, NULL) < 0)
         fail();
 
-    randomize_buffers(src, SRC_PIXELS + MAX_FILTER_WIDTH - 1);
-
     for (hpi = 0; hpi < HSCALE_PAIRS; hpi++) {
+        int src_bpc = hscale_pairs[hpi][0];
+
+        randomize_buffers((uint8_t *)src, sizeof(src[0]) * (SRC_PIXELS + MAX_FILTER_WIDTH - 1));
+        // keep high bit depth input within its nominal range
+        if (src_bpc > 8) {
+            for (i = 0; i < SRC_PIXELS + MAX_FILTER_WIDTH - 1; i++)
+                src[i] &= (1 << src_bpc) - 1;
+        }
+
         for (fsi = 0; fsi < FILTER_SIZES; fsi++) {
             width = filter_sizes[fsi];
 
-            ctx->srcBpc = hscale_pairs[hpi][0];
+            ctx->srcBpc = src_bpc;
             ctx->dstBpc = hscale_pairs[hpi][1];
+            // the C 16-bit input functions read the depth from the format
+            ctx->srcFormat = hscale_formats[hpi];
             ctx->hLumFilterSize = ctx->hChrFilterSize = width;
             ctx->dstW = ctx->chrDstW = SRC_PIXELS;
 
@@ -206,6 +301,16 @@ static void check_hscale(void)
                     filter[i * width + j] = -((1 << 14) / (width - 1));
                 }
                 filter[i * width + (rnd() % width)] = ((1 << 15) - 1);
+
+                // The 16-bit input SIMD functions offset the input to signed
+                // and add the offset back assuming normalized coefficients,
+                // so they are fed coefficients summing to exactly (1 << 14).
+                if (src_bpc == 16) {
+                    for (j = 0; j < width; j++) {
+                        if (filter[i * width + j] > 0)
+                            filter[i * width + j] = (1 << 14) + (width - 1) * ((1 << 14) / (width - 1));
+                    }
+                }
             }
 
             for (i = 0; i < MAX_FILTER_WIDTH; i++) {
@@ -224,11 +329,11 @@ static void check_hscale(void)
                 memset(dst0, 0, SRC_PIXELS * sizeof(dst0[0]));
                 memset(dst1, 0, SRC_PIXELS * sizeof(dst1[0]));
 
-                call_ref(NULL, dst0, SRC_PIXELS, src, filter, filterPos, width);
-                call_new(NULL, dst1, SRC_PIXELS, src, filterAvx2, filterPosAvx, width);
+                call_ref(ctx, dst0, SRC_PIXELS, (const uint8_t *)src, filter, filterPos, width);
+                call_new(ctx, dst1, SRC_PIXELS, (const uint8_t *)src, filterAvx2, filterPosAvx, width);
                 if (memcmp(dst0, dst1, SRC_PIXELS * sizeof(dst0[0])))
                     fail();
-                bench_new(NULL, dst0, SRC_PIXELS, src, filter, filterPosAvx, width);
+                bench_new(ctx, dst0, SRC_PIXELS, (const uint8_t *)src, filterAvx2, filterPosAvx, width);
             }
         }
     }
@@ -241,4 +346,6 @@ void checkasm_check_sw_scale(void)
     report("hscale");
     check_yuv2yuvX();
     report("yuv2yuvX");
+    check_yuv2planeX_hbd();
+    report("yuv2planeX_hbd");
 }
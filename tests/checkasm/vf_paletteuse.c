@@ -0,0 +1,62 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with FFmpeg; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <limits.h>
+
+#include "checkasm.h"
+#include "libavfilter/paletteuse.h"
+#include "libavutil/mem_internal.h"
+
+#define NB_ENTRIES 256
+
+void checkasm_check_vf_paletteuse(void)
+{
+    LOCAL_ALIGNED_32(int16_t, pal_rg, [2 * NB_ENTRIES]);
+    LOCAL_ALIGNED_32(int16_t, pal_ba, [2 * NB_ENTRIES]);
+    LOCAL_ALIGNED_32(int32_t, skip,   [NB_ENTRIES]);
+    PaletteUseDSPContext dsp;
+
+    declare_func(int, const int16_t *pal_rg, const int16_t *pal_ba,
+                 const int32_t *skip, int rg, int ba);
+
+    ff_paletteuse_init(&dsp);
+
+    if (check_func(dsp.nearest, "palette_nearest")) {
+        for (int use_alpha = 0; use_alpha < 2; use_alpha++) {
+            for (int i = 0; i < NB_ENTRIES; i++) {
+                /* few distinct values, so that there are ties */
+                pal_rg[2*i    ] = rnd() & 0xf0;
+                pal_rg[2*i + 1] = rnd() & 0xf0;
+                pal_ba[2*i    ] = rnd() & 0xf0;
+                pal_ba[2*i + 1] = use_alpha ? rnd() & 0xff : 0;
+                skip[i]         = rnd() % 8 ? 0 : INT_MAX;
+            }
+            for (int n = 0; n < 16; n++) {
+                const int rg = (rnd() & 0xff) | (rnd() & 0xff) << 16;
+                const int ba = (rnd() & 0xff) | (use_alpha ? (rnd() & 0xff) << 16 : 0);
+                const int ref = call_ref(pal_rg, pal_ba, skip, rg, ba);
+                const int new = call_new(pal_rg, pal_ba, skip, rg, ba);
+
+                if (ref != new)
+                    fail();
+            }
+        }
+        bench_new(pal_rg, pal_ba, skip, 0x800080, 0x80);
+    }
+    report("palette_nearest");
+}
@@ -26,6 +26,16 @@ fate-api-threadmessage: $(APITESTSDIR)/api-threadmessage-test$(EXESUF)
 fate-api-threadmessage: CMD = run $(APITESTSDIR)/api-threadmessage-test$(EXESUF) 3 10 30 50 2 20 40
 fate-api-threadmessage: CMP = null
 
+FATE_API-$(HAVE_THREADS) += fate-api-threadmessage-multi
+fate-api-threadmessage-multi: $(APITESTSDIR)/api-threadmessage-test$(EXESUF)
+fate-api-threadmessage-multi: CMD = run $(APITESTSDIR)/api-threadmessage-test$(EXESUF) 3 10 30 50 2 20 40 4
+fate-api-threadmessage-multi: CMP = null
+
+FATE_API-$(HAVE_THREADS) += fate-api-executor
+fate-api-executor: $(APITESTSDIR)/api-executor-test$(EXESUF)
+fate-api-executor: CMD = run $(APITESTSDIR)/api-executor-test$(EXESUF) 3 4 50
+fate-api-executor: CMP = null
+
 FATE_API_SAMPLES-$(CONFIG_AVFORMAT) += $(FATE_API_SAMPLES_LIBAVFORMAT-yes)
 
 ifdef SAMPLES
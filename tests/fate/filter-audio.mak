@@ -181,6 +181,9 @@ fate-filter-pan-downmix2: CMD = framecrc -ss 3.14 -i $(SRC) -frames:a 20 -filter
 FATE_AFILTER-$(call ALLYES, LAVFI_INDEV, AEVALSRC_FILTER SILENCEREMOVE_FILTER) += fate-filter-silenceremove
 fate-filter-silenceremove: CMD = framecrc -auto_conversion_filters -f lavfi -i "aevalsrc=between(t\,1\,2)+between(t\,4\,5)+between(t\,7\,9):d=10:n=8192,silenceremove=start_periods=0:start_duration=0:start_threshold=0:stop_periods=-1:stop_duration=0:stop_threshold=-90dB:window=0:detection=peak"
 
+FATE_AFILTER-$(call ALLYES, LAVFI_INDEV AEVALSRC_FILTER LOUDNORM_FILTER) += fate-filter-loudnorm-lookahead
+fate-filter-loudnorm-lookahead: CMD = framecrc -auto_conversion_filters -f lavfi -i "aevalsrc=0.5*sin(2*PI*12000*t+PI/4)*(1+0.5*sin(PI*t))|0.3*sin(2*PI*997*t):c=stereo:s=48000:d=4:n=4800" -af loudnorm=lookahead=1
+
 FATE_AFILTER_SAMPLES-$(call FILTERDEMDECENCMUX, STEREOTOOLS, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-filter-stereotools
 fate-filter-stereotools: SRC = $(TARGET_SAMPLES)/audio-reference/luckynight_2ch_44kHz_s16.wav
 fate-filter-stereotools: CMD = framecrc -i $(SRC) -frames:a 20 -af aresample,stereotools=mlev=0.015625,aresample
@@ -396,6 +399,10 @@ FATE_AFILTER-yes += fate-filter-formats
 fate-filter-formats: libavfilter/tests/formats$(EXESUF)
 fate-filter-formats: CMD = run libavfilter/tests/formats$(EXESUF)
 
+FATE_AFILTER-$(CONFIG_LOUDNORM_FILTER) += fate-filter-ebur128-true-peak
+fate-filter-ebur128-true-peak: libavfilter/tests/ebur128$(EXESUF)
+fate-filter-ebur128-true-peak: CMD = run libavfilter/tests/ebur128$(EXESUF)
+
 FATE_SAMPLES_AVCONV += $(FATE_AFILTER_SAMPLES-yes)
 FATE_FFMPEG += $(FATE_AFILTER-yes)
 fate-afilter: $(FATE_AFILTER-yes) $(FATE_AFILTER_SAMPLES-yes)
@@ -524,6 +524,20 @@ FATE_FILTER_VSYNTH-$(CONFIG_SCALE_FILTER) += fate-filter-scalechroma
 fate-filter-scalechroma: tests/data/vsynth1.yuv
 fate-filter-scalechroma: CMD = framecrc -flags bitexact -s 352x288 -pix_fmt yuv444p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -pix_fmt yuv420p -sws_flags +bitexact -vf scale=out_v_chr_pos=33:out_h_chr_pos=151
 
+FATE_FILTER_VSYNTH-$(CONFIG_SCALE_FILTER) += fate-filter-scale-gamma
+fate-filter-scale-gamma: tests/data/vsynth1.yuv
+fate-filter-scale-gamma: CMD = framecrc -flags bitexact -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -frames:v 5 -pix_fmt yuv420p -sws_flags +bitexact -vf scale=176:144:gamma=1
+
+# slice threading must not change the output
+FATE_FILTER_VSYNTH-$(CONFIG_SCALE_FILTER) += fate-filter-scale-gamma-threads
+fate-filter-scale-gamma-threads: tests/data/vsynth1.yuv
+fate-filter-scale-gamma-threads: CMD = framecrc -flags bitexact -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -frames:v 5 -pix_fmt yuv420p -sws_flags +bitexact -filter_threads 4 -vf scale=176:144:gamma=1
+fate-filter-scale-gamma-threads: REF = $(SRC_PATH)/tests/ref/fate/filter-scale-gamma
+
+FATE_FILTER_VSYNTH-$(call ALLYES, SCALE_FILTER FORMAT_FILTER) += fate-filter-scale-gamma-nv12
+fate-filter-scale-gamma-nv12: tests/data/vsynth1.yuv
+fate-filter-scale-gamma-nv12: CMD = framecrc -flags bitexact -s 352x288 -pix_fmt yuv420p -i $(TARGET_PATH)/tests/data/vsynth1.yuv -frames:v 5 -pix_fmt yuv420p -sws_flags +bitexact -vf scale,format=nv12,scale=176:144:gamma=1
+
 FATE_FILTER_VSYNTH-$(CONFIG_VFLIP_FILTER) += fate-filter-vflip
 fate-filter-vflip: CMD = video_filter "vflip"
 
@@ -690,6 +704,9 @@ FATE_FILTER_VSYNTH-$(CONFIG_STEREO3D_FILTER) += $(FATE_STEREO3D)
 FATE_FILTER_VSYNTH-$(CONFIG_THUMBNAIL_FILTER) += fate-filter-thumbnail
 fate-filter-thumbnail: CMD = video_filter "scale,thumbnail=10"
 
+FATE_FILTER_VSYNTH-$(CONFIG_THUMBNAIL_FILTER) += fate-filter-thumbnail-lowmem
+fate-filter-thumbnail-lowmem: CMD = video_filter "scale,thumbnail=10:lowmem=1"
+
 FATE_FILTER_VSYNTH-$(CONFIG_TILE_FILTER) += fate-filter-tile
 fate-filter-tile: CMD = video_filter "tile=3x3:nb_frames=5:padding=7:margin=2"
 
@@ -838,6 +855,11 @@ FATE_METADATA_FILTER-$(call ALLYES, $(EBUR128_METADATA_DEPS)) += fate-filter-met
 fate-filter-metadata-ebur128: SRC = $(TARGET_SAMPLES)/filter/seq-3341-7_seq-3342-5-24bit.flac
 fate-filter-metadata-ebur128: CMD = run $(FILTER_METADATA_COMMAND) "amovie='$(SRC)',ebur128=metadata=1"
 
+# sines with a true peak of 0.5 that mostly falls between samples, in the
+# spirit of the EBU Tech 3341 true peak test signals
+FATE_METADATA_FILTER_LAVFI-$(call ALLYES, FFPROBE AVDEVICE LAVFI_INDEV AEVALSRC_FILTER EBUR128_FILTER) += fate-filter-metadata-ebur128-peak
+fate-filter-metadata-ebur128-peak: CMD = run $(FILTER_METADATA_COMMAND) "aevalsrc=0.5*sin(2*PI*12000*t+PI/4)|0.5*sin(2*PI*997*t)|0.5*sin(2*PI*17000*t):c=3.0:s=48000:d=1:n=4800,ebur128=metadata=1:peak=true+sample"
+
 READVITC_METADATA_DEPS = FFPROBE LAVFI_INDEV MOVIE_FILTER AVCODEC AVDEVICE \
                          AVI_DEMUXER FFVHUFF_DECODER READVITC_FILTER
 FATE_METADATA_FILTER-$(call ALLYES, $(READVITC_METADATA_DEPS)) += fate-filter-metadata-readvitc-def
@@ -879,10 +901,14 @@ fate-filter-refcmp-ssim-rgb: CMD = refcmp_metadata ssim rgb24 0.015
 FATE_FILTER-$(call ALLYES, $(REFCMP_DEPS) SSIM_FILTER) += fate-filter-refcmp-ssim-yuv
 fate-filter-refcmp-ssim-yuv: CMD = refcmp_metadata ssim yuv422p 0.015
 
+FATE_FILTER-$(call ALLYES, $(REFCMP_DEPS) QUALITYMETRICS_FILTER) += fate-filter-refcmp-qualitymetrics-yuv
+fate-filter-refcmp-qualitymetrics-yuv: CMD = refcmp_metadata qualitymetrics yuv422p 0.015
+
 FATE_SAMPLES_FFPROBE += $(FATE_METADATA_FILTER-yes)
+FATE_FFPROBE += $(FATE_METADATA_FILTER_LAVFI-yes)
 FATE_SAMPLES_FFMPEG += $(FATE_FILTER_SAMPLES-yes)
 FATE_FFMPEG += $(FATE_FILTER-yes)
 
 fate-vfilter: $(FATE_FILTER-yes) $(FATE_FILTER_SAMPLES-yes) $(FATE_FILTER_VSYNTH-yes)
 
-fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes)
+fate-filter: fate-afilter fate-vfilter $(FATE_METADATA_FILTER-yes) $(FATE_METADATA_FILTER_LAVFI-yes)
@@ -1086,6 +1086,23 @@ FATE_SWR_RESAMPLE-$(call FILTERDEMDECENCMUX, ARESAMPLE, WAV, PCM_S16LE, PCM_S16L
 fate-swr-resample: $(FATE_SWR_RESAMPLE-yes)
 FATE_SWR += $(FATE_SWR_RESAMPLE-yes)
 
+FATE_SWR_THREADS-$(call FILTERDEMDECENCMUX, ARESAMPLE AFORMAT, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-swr-resample-threads
+fate-swr-resample-threads: tests/data/asynth-44100-2.wav
+fate-swr-resample-threads: REF = tests/data/asynth-44100-2.wav
+fate-swr-resample-threads: CMD = ffmpeg -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af aresample=48000:internal_sample_fmt=fltp:threads=2,aformat=fltp,aresample=44100:internal_sample_fmt=fltp:threads=2 -f wav -c:a pcm_s16le -
+fate-swr-resample-threads: CMP = stddev
+fate-swr-resample-threads: CMP_UNIT = s16
+fate-swr-resample-threads: CMP_TARGET = 905.87
+fate-swr-resample-threads: FUZZ = 0.1
+
+# the output must not depend on the number of threads, so both tests share a ref
+FATE_SWR_THREADS-$(call FILTERDEMDECENCMUX, ARESAMPLE, WAV, PCM_S16LE, PCM_F32LE, FRAMECRC) += fate-swr-resample-threads-1 fate-swr-resample-threads-2
+fate-swr-resample-threads-%: tests/data/asynth-44100-2.wav
+fate-swr-resample-threads-%: CMD = framecrc -i $(TARGET_PATH)/tests/data/asynth-44100-2.wav -af aresample=48000:internal_sample_fmt=fltp:threads=$(@:fate-swr-resample-threads-%=%) -c:a pcm_f32le
+fate-swr-resample-threads-%: REF = $(SRC_PATH)/tests/ref/fate/swr-resample-threads-1
+
+FATE_SWR += $(FATE_SWR_THREADS-yes)
+
 FATE_SWR_AUDIOCONVERT-$(call FILTERDEMDECENCMUX, AFORMAT AEVAL, WAV, PCM_S16LE, PCM_S16LE, WAV) += fate-swr-audioconvert
 fate-swr-audioconvert: tests/data/asynth-44100-1.wav
 fate-swr-audioconvert: REF = tests/data/asynth-44100-1.wav
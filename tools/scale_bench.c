@@ -0,0 +1,343 @@
+/*
+ * This file is part of FFmpeg.
+ *
+ * FFmpeg is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * FFmpeg is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with FFmpeg; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Measure the swscale throughput over a matrix of pixel format pairs,
+ * resolutions, scaling algorithms and CPU flag sets.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libavutil/common.h"
+#include "libavutil/cpu.h"
+#include "libavutil/frame.h"
+#include "libavutil/lfg.h"
+#include "libavutil/parseutils.h"
+#include "libavutil/pixdesc.h"
+#include "libavutil/time.h"
+
+#include "libswscale/swscale.h"
+
+#define MAX_ITEMS 32
+
+typedef struct FormatPair {
+    enum AVPixelFormat src, dst;
+} FormatPair;
+
+typedef struct SizePair {
+    int src_w, src_h, dst_w, dst_h;
+} SizePair;
+
+typedef struct CPUSet {
+    const char *name;
+    int flags;          ///< -1 for the flags detected at runtime
+} CPUSet;
+
+static const struct {
+    const char *name;
+    int flags;
+} algorithms[] = {
+    { "fast_bilinear", SWS_FAST_BILINEAR },
+    { "bilinear",      SWS_BILINEAR      },
+    { "bicubic",       SWS_BICUBIC       },
+    { "neighbor",      SWS_POINT         },
+    { "area",          SWS_AREA          },
+    { "gauss",         SWS_GAUSS         },
+    { "lanczos",       SWS_LANCZOS       },
+    { "spline",        SWS_SPLINE        },
+};
+
+static const FormatPair default_formats[] = {
+    { AV_PIX_FMT_YUV420P,     AV_PIX_FMT_YUV420P     },
+    { AV_PIX_FMT_YUV420P,     AV_PIX_FMT_BGRA        },
+    { AV_PIX_FMT_NV12,        AV_PIX_FMT_YUV420P     },
+    { AV_PIX_FMT_YUV420P10LE, AV_PIX_FMT_YUV420P     },
+    { AV_PIX_FMT_YUV420P10LE, AV_PIX_FMT_YUV420P10LE },
+    { AV_PIX_FMT_P010LE,      AV_PIX_FMT_YUV420P10LE },
+    { AV_PIX_FMT_YUV422P,     AV_PIX_FMT_YUV420P     },
+    { AV_PIX_FMT_RGB24,       AV_PIX_FMT_YUV420P     },
+    { AV_PIX_FMT_BGRA,        AV_PIX_FMT_YUV420P     },
+    { AV_PIX_FMT_GBRP,        AV_PIX_FMT_YUV444P     },
+};
+
+static const SizePair default_sizes[] = {
+    { 3840, 2160, 1920, 1080 },
+    { 1920, 1080, 1280,  720 },
+    { 1920, 1080,  640,  360 },
+    { 1280,  720, 1920, 1080 },
+    { 1920, 1080, 1920, 1080 },
+};
+
+static AVFrame *alloc_frame(enum AVPixelFormat format, int w, int h, AVLFG *lfg)
+{
+    AVFrame *frame = av_frame_alloc();
+    if (!frame)
+        return NULL;
+
+    frame->format = format;
+    frame->width  = w;
+    frame->height = h;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+        return NULL;
+    }
+
+    /* random content, so that no format gets away with constant data */
+    for (int i = 0; i < 4 && frame->buf[i]; i++) {
+        uint8_t *data = frame->buf[i]->data;
+        for (size_t j = 0; j < frame->buf[i]->size; j++)
+            data[j] = av_lfg_get(lfg);
+    }
+    return frame;
+}
+
+/**
+ * @return the throughput in destination megapixels per second, 0 if the
+ *         conversion is not supported, <0 on error
+ */
+static double run_bench(const FormatPair *fmt, const SizePair *size,
+                        int flags, int64_t duration, AVLFG *lfg)
+{
+    struct SwsContext *sws;
+    AVFrame *src = NULL, *dst = NULL;
+    int64_t start, elapsed;
+    int iterations = 0;
+    double ret = -1;
+
+    sws = sws_getContext(size->src_w, size->src_h, fmt->src,
+                         size->dst_w, size->dst_h, fmt->dst,
+                         flags, NULL, NULL, NULL);
+    if (!sws)
+        return 0;
+
+    src = alloc_frame(fmt->src, size->src_w, size->src_h, lfg);
+    dst = alloc_frame(fmt->dst, size->dst_w, size->dst_h, lfg);
+    if (!src || !dst)
+        goto end;
+
+    /* warm up the caches and the lazily initialized tables */
+    if (sws_scale_frame(sws, dst, src) < 0)
+        goto end;
+
+    start = av_gettime_relative();
+    do {
+        if (sws_scale_frame(sws, dst, src) < 0)
+            goto end;
+        iterations++;
+        elapsed = av_gettime_relative() - start;
+    } while (elapsed < duration || iterations < 3);
+
+    ret = (double)size->dst_w * size->dst_h * iterations / elapsed;
+
+end:
+    av_frame_free(&src);
+    av_frame_free(&dst);
+    sws_freeContext(sws);
+    return ret;
+}
+
+static int parse_size_pair(const char *arg, SizePair *size)
+{
+    char src[64];
+    const char *sep = strchr(arg, ':');
+
+    if (!sep || sep - arg >= sizeof(src))
+        return AVERROR(EINVAL);
+    memcpy(src, arg, sep - arg);
+    src[sep - arg] = 0;
+
+    if (av_parse_video_size(&size->src_w, &size->src_h, src) < 0 ||
+        av_parse_video_size(&size->dst_w, &size->dst_h, sep + 1) < 0)
+        return AVERROR(EINVAL);
+    return 0;
+}
+
+static int parse_format_pair(const char *arg, FormatPair *fmt)
+{
+    char src[64];
+    const char *sep = strchr(arg, ':');
+
+    if (!sep || sep - arg >= sizeof(src))
+        return AVERROR(EINVAL);
+    memcpy(src, arg, sep - arg);
+    src[sep - arg] = 0;
+
+    fmt->src = av_get_pix_fmt(src);
+    fmt->dst = av_get_pix_fmt(sep + 1);
+    if (fmt->src == AV_PIX_FMT_NONE || fmt->dst == AV_PIX_FMT_NONE)
+        return AVERROR(EINVAL);
+    return 0;
+}
+
+static int parse_cpu_set(const char *arg, CPUSet *set)
+{
+    unsigned flags = 0;
+
+    set->name = arg;
+    if (!strcmp(arg, "native")) {
+        set->flags = -1;
+        return 0;
+    }
+    if (strcmp(arg, "c") && av_parse_cpu_caps(&flags, arg) < 0)
+        return AVERROR(EINVAL);
+    set->flags = flags;
+    return 0;
+}
+
+static void usage(const char *name)
+{
+    int i;
+
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -s <srcWxH>:<dstWxH>    resolution pair, may be repeated\n"
+            "  -p <srcfmt>:<dstfmt>    pixel format pair, may be repeated\n"
+            "  -a <algorithm>          scaling algorithm, may be repeated, one of\n"
+            "                         ",
+            name);
+    for (i = 0; i < FF_ARRAY_ELEMS(algorithms); i++)
+        fprintf(stderr, " %s", algorithms[i].name);
+    fprintf(stderr,
+            "\n"
+            "  -c <cpuflags>           CPU flag set, may be repeated: c (no SIMD),\n"
+            "                          native, or a list as accepted by -cpuflags\n"
+            "                          (default: c and native)\n"
+            "  -t <seconds>            time spent on each configuration (default 0.3)\n"
+            "  -e <flags>              additional SWS_* flags, e.g. 0x100 for accurate_rnd\n");
+}
+
+int main(int argc, char **argv)
+{
+    FormatPair formats[MAX_ITEMS];
+    SizePair   sizes[MAX_ITEMS];
+    CPUSet     cpu_sets[MAX_ITEMS];
+    int        algos[MAX_ITEMS];
+    int nb_formats = 0, nb_sizes = 0, nb_cpu_sets = 0, nb_algos = 0;
+    int extra_flags = 0;
+    double seconds = 0.3;
+    AVLFG lfg;
+
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i], *arg = i + 1 < argc ? argv[i + 1] : NULL;
+        int ret = 0;
+
+        if (!arg || opt[0] != '-' || !opt[1] || opt[2]) {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+
+        switch (opt[1]) {
+        case 's':
+            if (nb_sizes == MAX_ITEMS || parse_size_pair(arg, &sizes[nb_sizes++]) < 0)
+                ret = AVERROR(EINVAL);
+            break;
+        case 'p':
+            if (nb_formats == MAX_ITEMS || parse_format_pair(arg, &formats[nb_formats++]) < 0)
+                ret = AVERROR(EINVAL);
+            break;
+        case 'c':
+            if (nb_cpu_sets == MAX_ITEMS || parse_cpu_set(arg, &cpu_sets[nb_cpu_sets++]) < 0)
+                ret = AVERROR(EINVAL);
+            break;
+        case 'a': {
+            int j;
+            for (j = 0; j < FF_ARRAY_ELEMS(algorithms); j++)
+                if (!strcmp(arg, algorithms[j].name))
+                    break;
+            if (nb_algos == MAX_ITEMS || j == FF_ARRAY_ELEMS(algorithms))
+                ret = AVERROR(EINVAL);
+            else
+                algos[nb_algos++] = j;
+            break;
+        }
+        case 't':
+            seconds = strtod(arg, NULL);
+            break;
+        case 'e':
+            extra_flags = strtol(arg, NULL, 0);
+            break;
+        default:
+            ret = AVERROR(EINVAL);
+        }
+
+        if (ret < 0) {
+            fprintf(stderr, "Invalid argument '%s' for option %s\n", arg, opt);
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!nb_formats) {
+        memcpy(formats, default_formats, sizeof(default_formats));
+        nb_formats = FF_ARRAY_ELEMS(default_formats);
+    }
+    if (!nb_sizes) {
+        memcpy(sizes, default_sizes, sizeof(default_sizes));
+        nb_sizes = FF_ARRAY_ELEMS(default_sizes);
+    }
+    if (!nb_algos) {
+        static const int default_algos[] = { 0, 1, 2, 6 };
+        memcpy(algos, default_algos, sizeof(default_algos));
+        nb_algos = FF_ARRAY_ELEMS(default_algos);
+    }
+    if (!nb_cpu_sets) {
+        parse_cpu_set("c",      &cpu_sets[nb_cpu_sets++]);
+        parse_cpu_set("native", &cpu_sets[nb_cpu_sets++]);
+    }
+
+    av_lfg_init(&lfg, 0xdeadbeef);
+
+    printf("%-16s %-14s %-14s %-21s %-14s %10s\n",
+           "cpuflags", "src", "dst", "size", "algorithm", "Mpix/s");
+
+    for (int c = 0; c < nb_cpu_sets; c++) {
+        av_force_cpu_flags(cpu_sets[c].flags);
+
+        for (int f = 0; f < nb_formats; f++) {
+            for (int s = 0; s < nb_sizes; s++) {
+                for (int a = 0; a < nb_algos; a++) {
+                    char size[32];
+                    double mpix;
+
+                    snprintf(size, sizeof(size), "%dx%d->%dx%d",
+                             sizes[s].src_w, sizes[s].src_h,
+                             sizes[s].dst_w, sizes[s].dst_h);
+                    mpix = run_bench(&formats[f], &sizes[s],
+                                     algorithms[algos[a]].flags | extra_flags,
+                                     seconds * 1000000, &lfg);
+
+                    printf("%-16s %-14s %-14s %-21s %-14s ", cpu_sets[c].name,
+                           av_get_pix_fmt_name(formats[f].src),
+                           av_get_pix_fmt_name(formats[f].dst),
+                           size, algorithms[algos[a]].name);
+                    if (mpix > 0)
+                        printf("%10.2f\n", mpix);
+                    else
+                        printf("%10s\n", mpix < 0 ? "error" : "n/a");
+                    fflush(stdout);
+                }
+            }
+        }
+    }
+
+    return 0;
+}